@@ -29,6 +29,14 @@ pub fn build(b: *std.Build) void {
         .optimize = optimize,
     });
 
+    // SIMD kernel tiers: src/kernels.zig compiled once per x86 ISA tier with
+    // that tier's CPU features, each exporting its kernels under the tier's
+    // own symbol names. simd.kernels() fills its function-pointer table from
+    // them at startup, by the CPU's detected tier. Every artifact that links
+    // lib_mod links the objects; a static library consumer only gets them
+    // with --whole-archive and otherwise keeps the build target's kernels.
+    for (addKernelTiers(b, target, optimize)) |tier| lib_mod.addObject(tier);
+
     // We will also create a module for our other entry point, 'main.zig'.
     const exe_mod = b.createModule(.{
         // `root_source_file` is the Zig "entry point" of the module. If a module
@@ -313,6 +321,13 @@ pub fn build(b: *std.Build) void {
     });
 
     const run_exe_unit_tests = b.addRunArtifact(exe_unit_tests);
+
+    // C API tests
+    const c_api_tests = b.addTest(.{
+        .root_module = c_api_mod,
+    });
+
+    const run_c_api_tests = b.addRunArtifact(c_api_tests);
     
     // Create a module for ByteStream enhanced
     const byte_stream_enhanced_mod = b.createModule(.{
@@ -426,6 +441,7 @@ pub fn build(b: *std.Build) void {
     const test_step = b.step("test", "Run unit tests");
     test_step.dependOn(&run_lib_unit_tests.step);
     test_step.dependOn(&run_exe_unit_tests.step);
+    test_step.dependOn(&run_c_api_tests.step);
     test_step.dependOn(&run_byte_stream_tests.step);
     test_step.dependOn(&run_byte_stream_optimized_tests.step);
     
@@ -653,4 +669,38 @@ pub fn build(b: *std.Build) void {
     // Add a specific step for error visualization tests
     const error_visualizer_test_step = b.step("test-error-visualization", "Run error visualization tests");
     error_visualizer_test_step.dependOn(&run_error_visualizer_tests.step);
-}
\ No newline at end of file
+}
+
+/// One kernel object per x86 ISA tier above the baseline (see src/kernels.zig)
+fn addKernelTiers(
+    b: *std.Build,
+    target: std.Build.ResolvedTarget,
+    optimize: std.builtin.OptimizeMode,
+) []const *std.Build.Step.Compile {
+    if (target.result.cpu.arch != .x86_64) return &.{};
+
+    const tiers = [_]struct { name: []const u8, features: []const std.Target.x86.Feature }{
+        .{ .name = "avx2", .features = &.{.avx2} },
+        .{ .name = "avx512bw", .features = &.{.avx512bw} },
+    };
+    const objects = b.allocator.alloc(*std.Build.Step.Compile, tiers.len) catch @panic("OOM");
+    for (tiers, objects) |tier, *object| {
+        var query = target.query;
+        query.cpu_features_add.addFeatureSet(std.Target.x86.featureSet(tier.features));
+
+        const options = b.addOptions();
+        options.addOption([]const u8, "tier", tier.name);
+        const tier_mod = b.createModule(.{
+            .root_source_file = b.path("src/kernels.zig"),
+            .target = b.resolveTargetQuery(query),
+            .optimize = optimize,
+            .pic = true,
+        });
+        tier_mod.addOptions("kernel_options", options);
+        object.* = b.addObject(.{
+            .name = b.fmt("zp_kernels_{s}", .{tier.name}),
+            .root_module = tier_mod,
+        });
+    }
+    return objects;
+}
@@ -0,0 +1,404 @@
+const std = @import("std");
+
+/// Whether `AhoCorasick.compile(literals)` accepts the set: no empty literals
+pub fn supports(comptime literals: []const []const u8) bool {
+    if (literals.len == 0) return false;
+    for (literals) |lit| {
+        if (lit.len == 0) return false;
+    }
+    return true;
+}
+
+/// Aho-Corasick automaton over a set of literals, for sets too large for
+/// `Teddy` (hundreds to thousands of keywords or directives). Lookups cost one
+/// transition per input byte regardless of the number of literals.
+///
+/// Nodes are stored in breadth-first order, so the children of a node are
+/// contiguous and the hot upper levels of the trie share cache lines. Nodes
+/// with many children (always the root) get a dense 256-entry row; the rest
+/// find a child by scanning their children's labels, a few adjacent bytes.
+///
+/// The same layout is built at comptime (`compile`) for static token sets and
+/// at runtime (`init`) for grammars that arrive through the C API.
+pub const AhoCorasick = struct {
+    nodes: []const Node,
+    /// Byte on the edge into each node
+    labels: []const u8,
+    dense_rows: []const [256]u32,
+    max_len: usize,
+
+    pub const none = std.math.maxInt(u32);
+    /// Nodes with more children than this get a dense row
+    pub const sparse_limit = 8;
+
+    pub const Node = struct {
+        /// Children are nodes first_child..first_child + child_count
+        first_child: u32,
+        child_count: u32,
+        /// Index into dense_rows, or none
+        dense: u32,
+        fail: u32,
+        /// Lowest-index literal ending here, or none
+        literal: u32,
+        /// Nearest node on the fail chain that ends a literal, or none
+        dict: u32,
+        depth: u32,
+    };
+
+    /// Which literal wins among those starting at the same position
+    pub const MatchKind = enum {
+        /// The longest one
+        longest,
+        /// The first in declaration order
+        priority,
+    };
+
+    pub const Match = struct {
+        literal: u32,
+        start: usize,
+        end: usize,
+    };
+
+    pub const Error = error{ EmptyLiteral, TooManyLiterals } || std.mem.Allocator.Error;
+
+    /// Builds the automaton at comptime; the result can live in a `const`
+    pub fn compile(comptime literals: []const []const u8) AhoCorasick {
+        comptime {
+            @setEvalBranchQuota(1_000_000 + 1_000 * literals.len);
+            const max_nodes = maxNodes(literals);
+            var first_child: [max_nodes]u32 = undefined;
+            var next_sibling: [max_nodes]u32 = undefined;
+            var labels: [max_nodes]u8 = undefined;
+            var literal: [max_nodes]u32 = undefined;
+            var order: [max_nodes]u32 = undefined;
+            var remap: [max_nodes]u32 = undefined;
+            var scratch = Scratch{
+                .first_child = &first_child,
+                .next_sibling = &next_sibling,
+                .labels = &labels,
+                .literal = &literal,
+                .order = &order,
+                .remap = &remap,
+            };
+            const shape = scratch.build(literals) catch |err| @compileError(@errorName(err));
+
+            var nodes: [shape.node_count]Node = undefined;
+            var final_labels: [shape.node_count]u8 = undefined;
+            var dense_rows: [shape.dense_count][256]u32 = undefined;
+            const max_len = scratch.layout(&nodes, &final_labels, &dense_rows);
+
+            const frozen_nodes = nodes;
+            const frozen_labels = final_labels;
+            const frozen_rows = dense_rows;
+            return .{
+                .nodes = &frozen_nodes,
+                .labels = &frozen_labels,
+                .dense_rows = &frozen_rows,
+                .max_len = max_len,
+            };
+        }
+    }
+
+    /// Builds the automaton at runtime; release it with `deinit`
+    pub fn init(allocator: std.mem.Allocator, literals: []const []const u8) Error!AhoCorasick {
+        const max_nodes = maxNodes(literals);
+        if (max_nodes > none) return error.TooManyLiterals;
+
+        const words = try allocator.alloc(u32, max_nodes * 5);
+        defer allocator.free(words);
+        const scratch_labels = try allocator.alloc(u8, max_nodes);
+        defer allocator.free(scratch_labels);
+        var scratch = Scratch{
+            .first_child = words[0..max_nodes],
+            .next_sibling = words[max_nodes..][0..max_nodes],
+            .literal = words[2 * max_nodes ..][0..max_nodes],
+            .order = words[3 * max_nodes ..][0..max_nodes],
+            .remap = words[4 * max_nodes ..][0..max_nodes],
+            .labels = scratch_labels,
+        };
+        const shape = try scratch.build(literals);
+
+        const nodes = try allocator.alloc(Node, shape.node_count);
+        errdefer allocator.free(nodes);
+        const labels = try allocator.alloc(u8, shape.node_count);
+        errdefer allocator.free(labels);
+        const dense_rows = try allocator.alloc([256]u32, shape.dense_count);
+        const max_len = scratch.layout(nodes, labels, dense_rows);
+        return .{ .nodes = nodes, .labels = labels, .dense_rows = dense_rows, .max_len = max_len };
+    }
+
+    pub fn deinit(self: *AhoCorasick, allocator: std.mem.Allocator) void {
+        allocator.free(self.nodes);
+        allocator.free(self.labels);
+        allocator.free(self.dense_rows);
+        self.* = undefined;
+    }
+
+    /// Child of `node` along byte `c`, or none
+    pub inline fn child(self: *const AhoCorasick, node: u32, c: u8) u32 {
+        const n = self.nodes[node];
+        if (n.dense != none) return self.dense_rows[n.dense][c];
+        const first = n.first_child;
+        for (self.labels[first..][0..n.child_count], @as(usize, first)..) |label, i| {
+            if (label == c) return @intCast(i);
+        }
+        return none;
+    }
+
+    /// Automaton transition: follows fail links until some suffix extends by `c`
+    pub inline fn next(self: *const AhoCorasick, state: u32, c: u8) u32 {
+        var s = state;
+        while (true) {
+            const t = self.child(s, c);
+            if (t != none) return t;
+            if (s == 0) return 0;
+            s = self.nodes[s].fail;
+        }
+    }
+
+    /// Literal occurring at `pos`, chosen by `kind`; one trie walk
+    pub fn matchAt(self: *const AhoCorasick, input: []const u8, pos: usize, kind: MatchKind) ?Match {
+        var best: ?Match = null;
+        var node: u32 = 0;
+        var i = pos;
+        while (i < input.len) : (i += 1) {
+            node = self.child(node, input[i]);
+            if (node == none) break;
+            const literal = self.nodes[node].literal;
+            if (literal == none) continue;
+            const m = Match{ .literal = literal, .start = pos, .end = i + 1 };
+            if (better(m, best, kind)) best = m;
+        }
+        return best;
+    }
+
+    /// Leftmost literal occurrence at or after `start`, ties broken by `kind`
+    pub fn find(self: *const AhoCorasick, input: []const u8, start: usize, kind: MatchKind) ?Match {
+        var best: ?Match = null;
+        var state: u32 = 0;
+        var pos = start;
+        while (pos < input.len) : (pos += 1) {
+            // No literal starting at or before best.start ends past here
+            if (best) |b| {
+                if (pos >= b.start + self.max_len) break;
+            }
+            state = self.next(state, input[pos]);
+
+            var out = if (self.nodes[state].literal != none) state else self.nodes[state].dict;
+            while (out != none) : (out = self.nodes[out].dict) {
+                const node = self.nodes[out];
+                const m = Match{ .literal = node.literal, .start = pos + 1 - node.depth, .end = pos + 1 };
+                if (better(m, best, kind)) best = m;
+            }
+        }
+        return best;
+    }
+
+    fn better(m: Match, current: ?Match, kind: MatchKind) bool {
+        const b = current orelse return true;
+        if (m.start != b.start) return m.start < b.start;
+        return switch (kind) {
+            .longest => m.end > b.end or (m.end == b.end and m.literal < b.literal),
+            .priority => m.literal < b.literal,
+        };
+    }
+
+    fn maxNodes(literals: []const []const u8) usize {
+        var total: usize = 1;
+        for (literals) |lit| total += lit.len;
+        return total;
+    }
+
+    /// Trie under construction, with sorted sibling lists
+    const Scratch = struct {
+        first_child: []u32,
+        next_sibling: []u32,
+        labels: []u8,
+        literal: []u32,
+        /// Breadth-first order of the trie nodes, and its inverse
+        order: []u32,
+        remap: []u32,
+        count: u32 = 0,
+
+        const Shape = struct { node_count: usize, dense_count: usize };
+
+        fn build(self: *Scratch, literals: []const []const u8) Error!Shape {
+            if (literals.len >= none) return error.TooManyLiterals;
+            self.count = 1;
+            self.first_child[0] = none;
+            self.literal[0] = none;
+            for (literals, 0..) |lit, index| {
+                if (lit.len == 0) return error.EmptyLiteral;
+                self.insert(lit, @intCast(index));
+            }
+
+            self.order[0] = 0;
+            var head: usize = 0;
+            var tail: usize = 1;
+            var dense_count: usize = 0;
+            while (head < tail) : (head += 1) {
+                const node = self.order[head];
+                self.remap[node] = @intCast(head);
+                var children: usize = 0;
+                var c = self.first_child[node];
+                while (c != none) : (c = self.next_sibling[c]) {
+                    self.order[tail] = c;
+                    tail += 1;
+                    children += 1;
+                }
+                if (node == 0 or children > sparse_limit) dense_count += 1;
+            }
+            return .{ .node_count = self.count, .dense_count = dense_count };
+        }
+
+        fn insert(self: *Scratch, lit: []const u8, index: u32) void {
+            var node: u32 = 0;
+            for (lit) |c| {
+                var prev: u32 = none;
+                var cur = self.first_child[node];
+                while (cur != none and self.labels[cur] < c) {
+                    prev = cur;
+                    cur = self.next_sibling[cur];
+                }
+                if (cur == none or self.labels[cur] != c) {
+                    const fresh = self.count;
+                    self.count += 1;
+                    self.labels[fresh] = c;
+                    self.first_child[fresh] = none;
+                    self.literal[fresh] = none;
+                    self.next_sibling[fresh] = cur;
+                    if (prev == none) self.first_child[node] = fresh else self.next_sibling[prev] = fresh;
+                    cur = fresh;
+                }
+                node = cur;
+            }
+            // Duplicates keep the earlier index
+            if (self.literal[node] == none) self.literal[node] = index;
+        }
+
+        /// Writes the breadth-first layout and links; returns the longest literal
+        fn layout(self: *const Scratch, nodes: []Node, labels: []u8, dense_rows: [][256]u32) usize {
+            const count = nodes.len;
+            var next_child: u32 = 1;
+            var dense: u32 = 0;
+            var max_len: usize = 0;
+            // Depths are filled in by the parent, which comes first
+            nodes[0].depth = 0;
+            for (0..count) |i| {
+                const old = self.order[i];
+                const depth = nodes[i].depth;
+                var children: u32 = 0;
+                var c = self.first_child[old];
+                while (c != none) : (c = self.next_sibling[c]) children += 1;
+
+                nodes[i] = .{
+                    .first_child = next_child,
+                    .child_count = children,
+                    .dense = none,
+                    .fail = 0,
+                    .literal = self.literal[old],
+                    .dict = none,
+                    .depth = depth,
+                };
+                for (next_child..next_child + children) |ch| nodes[ch].depth = depth + 1;
+                labels[i] = if (i == 0) 0 else self.labels[old];
+                if (i == 0 or children > sparse_limit) {
+                    dense_rows[dense] = [_]u32{none} ** 256;
+                    c = self.first_child[old];
+                    while (c != none) : (c = self.next_sibling[c]) dense_rows[dense][self.labels[c]] = self.remap[c];
+                    nodes[i].dense = dense;
+                    dense += 1;
+                }
+                if (nodes[i].literal != none) max_len = @max(max_len, depth);
+                next_child += children;
+            }
+
+            const ac = AhoCorasick{ .nodes = nodes, .labels = labels, .dense_rows = dense_rows, .max_len = max_len };
+            // Breadth-first, so fail targets (shallower) are final before use
+            for (0..count) |i| {
+                const n = nodes[i];
+                for (n.first_child..n.first_child + n.child_count) |ch| {
+                    var fail: u32 = 0;
+                    if (i != 0) {
+                        var f = n.fail;
+                        while (true) {
+                            const t = ac.child(f, labels[ch]);
+                            if (t != none) {
+                                fail = t;
+                                break;
+                            }
+                            if (f == 0) break;
+                            f = nodes[f].fail;
+                        }
+                    }
+                    nodes[ch].fail = fail;
+                    nodes[ch].dict = if (nodes[fail].literal != none) fail else nodes[fail].dict;
+                }
+            }
+            return max_len;
+        }
+
+    };
+};
+
+test "aho-corasick leftmost matches by kind" {
+    const ac = comptime AhoCorasick.compile(&.{ "he", "she", "his", "hers", "her" });
+    const text = "ushers and his";
+
+    const longest = ac.find(text, 0, .longest).?;
+    try std.testing.expectEqual(AhoCorasick.Match{ .literal = 1, .start = 1, .end = 4 }, longest);
+    // "he", "hers" and "her" start at 2; longest takes "hers", priority "he"
+    try std.testing.expectEqual(AhoCorasick.Match{ .literal = 3, .start = 2, .end = 6 }, ac.find(text, 2, .longest).?);
+    try std.testing.expectEqual(AhoCorasick.Match{ .literal = 0, .start = 2, .end = 4 }, ac.find(text, 2, .priority).?);
+    try std.testing.expectEqual(AhoCorasick.Match{ .literal = 2, .start = 11, .end = 14 }, ac.find(text, 3, .priority).?);
+    try std.testing.expectEqual(@as(?AhoCorasick.Match, null), ac.find(text, 12, .longest));
+
+    try std.testing.expectEqual(@as(u32, 0), ac.matchAt(text, 2, .priority).?.literal);
+    try std.testing.expectEqual(@as(u32, 3), ac.matchAt(text, 2, .longest).?.literal);
+    try std.testing.expectEqual(@as(?AhoCorasick.Match, null), ac.matchAt(text, 0, .longest));
+}
+
+test "aho-corasick runtime build agrees with a naive search" {
+    const allocator = std.testing.allocator;
+    var prng = std.Random.DefaultPrng.init(23);
+    const random = prng.random();
+    const alphabet = "abcdefghij";
+
+    // Enough literals, over a small alphabet, for dense and sparse nodes
+    var storage: [300][6]u8 = undefined;
+    var literals: [300][]const u8 = undefined;
+    for (&storage, &literals) |*bytes, *lit| {
+        const len = 1 + random.uintLessThan(usize, 6);
+        for (bytes[0..len]) |*c| c.* = alphabet[random.uintLessThan(usize, alphabet.len)];
+        lit.* = bytes[0..len];
+    }
+    var ac = try AhoCorasick.init(allocator, &literals);
+    defer ac.deinit(allocator);
+    try std.testing.expect(ac.dense_rows.len > 1);
+
+    var input: [400]u8 = undefined;
+    for (&input) |*c| c.* = alphabet[random.uintLessThan(usize, alphabet.len)];
+
+    for (0..input.len) |pos| {
+        var longest: ?AhoCorasick.Match = null;
+        var first: ?AhoCorasick.Match = null;
+        for (literals, 0..) |lit, i| {
+            if (!std.mem.startsWith(u8, input[pos..], lit)) continue;
+            const m = AhoCorasick.Match{ .literal = @intCast(i), .start = pos, .end = pos + lit.len };
+            if (first == null) first = m;
+            if (longest == null or m.end > longest.?.end) longest = m;
+        }
+        try std.testing.expectEqual(longest, ac.matchAt(&input, pos, .longest));
+        try std.testing.expectEqual(first, ac.matchAt(&input, pos, .priority));
+
+        // The leftmost match of a search is the first position with a match
+        var expected: ?AhoCorasick.Match = null;
+        for (pos..input.len) |p| {
+            expected = ac.matchAt(&input, p, .priority);
+            if (expected != null) break;
+        }
+        try std.testing.expectEqual(expected, ac.find(&input, pos, .priority));
+    }
+
+    try std.testing.expectError(error.EmptyLiteral, AhoCorasick.init(allocator, &.{ "a", "" }));
+}
@@ -0,0 +1,149 @@
+const std = @import("std");
+const char_class = @import("char_class.zig");
+const simd = @import("simd.zig").simd;
+
+const CharClass = char_class.CharClass;
+
+/// Classifies input 64 bytes at a time into one u64 mask per CharClass (plus
+/// a few caller-chosen bytes such as a CSV delimiter), so tokenizers can find
+/// the end of a token with ctz on a mask instead of a char_table lookup per
+/// byte. The masks of the current block are cached; consecutive short tokens
+/// in the same block cost one classification.
+pub const BlockClassifier = struct {
+    pub const block_size = 64;
+    pub const max_specials = 4;
+
+    /// Bytes a query stops at or runs over: a set of classes plus specials
+    pub const Selector = struct {
+        /// Bit i selects CharClass with ordinal i
+        classes: u8 = 0,
+        /// Bit i selects specials[i]
+        specials: u8 = 0,
+
+        pub fn of(comptime classes: []const CharClass) Selector {
+            var bits: u8 = 0;
+            inline for (classes) |class| bits |= @as(u8, 1) << @intFromEnum(class);
+            return .{ .classes = bits };
+        }
+
+        pub fn withSpecials(self: Selector, bits: u8) Selector {
+            return .{ .classes = self.classes, .specials = self.specials | bits };
+        }
+    };
+
+    input: []const u8,
+    specials: [max_specials]u8 = undefined,
+    special_count: usize = 0,
+    /// Start of the cached block, or maxInt before the first load
+    cached_base: usize = std.math.maxInt(usize),
+    class_masks: [class_count]u64 = undefined,
+    special_masks: [max_specials]u64 = undefined,
+
+    const class_count = @typeInfo(CharClass).@"enum".fields.len;
+
+    pub fn init(input: []const u8, specials: []const u8) BlockClassifier {
+        std.debug.assert(specials.len <= max_specials);
+        var self = BlockClassifier{ .input = input, .special_count = specials.len };
+        @memcpy(self.specials[0..specials.len], specials);
+        return self;
+    }
+
+    /// First position >= pos whose byte is selected, or null
+    pub fn find(self: *BlockClassifier, pos: usize, selector: Selector) ?usize {
+        if (pos >= self.input.len) return null;
+        var base = pos - pos % block_size;
+        var bits = self.select(base, selector) & (~@as(u64, 0) << @intCast(pos - base));
+        while (true) {
+            if (bits != 0) return base + @ctz(bits);
+            base += block_size;
+            if (base >= self.input.len) return null;
+            bits = self.select(base, selector);
+        }
+    }
+
+    /// End of the run of selected bytes starting at pos
+    pub fn runEnd(self: *BlockClassifier, pos: usize, selector: Selector) usize {
+        if (pos >= self.input.len) return self.input.len;
+        var base = pos - pos % block_size;
+        // Lanes past the end of input are never selected, so the run stops there
+        var bits = ~self.select(base, selector) & (~@as(u64, 0) << @intCast(pos - base));
+        while (true) {
+            if (bits != 0) return @min(base + @ctz(bits), self.input.len);
+            base += block_size;
+            if (base >= self.input.len) return self.input.len;
+            bits = ~self.select(base, selector);
+        }
+    }
+
+    /// Union of the selected masks for the block starting at `base`
+    pub fn select(self: *BlockClassifier, base: usize, selector: Selector) u64 {
+        self.load(base);
+        var mask: u64 = 0;
+        inline for (0..class_count) |c| {
+            if (selector.classes & (1 << c) != 0) mask |= self.class_masks[c];
+        }
+        for (self.special_masks[0..self.special_count], 0..) |special, i| {
+            if (selector.specials & (@as(u8, 1) << @intCast(i)) != 0) mask |= special;
+        }
+        return mask;
+    }
+
+    fn load(self: *BlockClassifier, base: usize) void {
+        if (base == self.cached_base) return;
+        self.cached_base = base;
+
+        var padded: [block_size]u8 = [_]u8{0} ** block_size;
+        const available = self.input.len - base;
+        const bytes: *const [block_size]u8 = if (available >= block_size)
+            self.input[base..][0..block_size]
+        else blk: {
+            @memcpy(padded[0..available], self.input[base..]);
+            break :blk &padded;
+        };
+        const valid: u64 = if (available >= block_size) ~@as(u64, 0) else (@as(u64, 1) << @intCast(available)) - 1;
+
+        self.class_masks = simd.classMasks64(bytes);
+        for (&self.class_masks) |*mask| mask.* &= valid;
+
+        const v: @Vector(block_size, u8) = bytes.*;
+        for (self.specials[0..self.special_count], self.special_masks[0..self.special_count]) |special, *mask| {
+            mask.* = @as(u64, @bitCast(v == @as(@Vector(block_size, u8), @splat(special)))) & valid;
+        }
+    }
+};
+
+test "block classifier finds class and special boundaries" {
+    const input = "name,  age;\n" ++ "x" ** 70 ++ ",42\r\n";
+    var classifier = BlockClassifier.init(input, &.{ ',', ';' });
+
+    const letters = BlockClassifier.Selector.of(&.{ .alpha_lower, .alpha_upper });
+    try std.testing.expectEqual(@as(usize, 4), classifier.runEnd(0, letters));
+    // Runs continue across block boundaries
+    try std.testing.expectEqual(@as(usize, 82), classifier.runEnd(12, letters));
+
+    const stops = BlockClassifier.Selector.of(&.{.newline}).withSpecials(0b11);
+    try std.testing.expectEqual(@as(?usize, 4), classifier.find(0, stops));
+    try std.testing.expectEqual(@as(?usize, 10), classifier.find(5, stops));
+    try std.testing.expectEqual(@as(?usize, 82), classifier.find(12, stops));
+    try std.testing.expectEqual(@as(?usize, 85), classifier.find(83, stops));
+    try std.testing.expectEqual(@as(?usize, null), classifier.find(input.len, stops));
+}
+
+test "block classifier agrees with char_table" {
+    var input: [300]u8 = undefined;
+    var prng = std.Random.DefaultPrng.init(5);
+    prng.random().bytes(&input);
+
+    var classifier = BlockClassifier.init(&input, &.{0});
+    inline for (@typeInfo(CharClass).@"enum".fields) |field| {
+        const class: CharClass = @enumFromInt(field.value);
+        const selector = BlockClassifier.Selector.of(&.{class});
+        for (0..input.len) |pos| {
+            var end = pos;
+            while (end < input.len and char_class.char_table[input[end]] == class) end += 1;
+            try std.testing.expectEqual(end, classifier.runEnd(pos, selector));
+        }
+    }
+    const zero = BlockClassifier.Selector{ .specials = 1 };
+    try std.testing.expectEqual(std.mem.indexOfScalar(u8, &input, 0), classifier.find(0, zero));
+}
@@ -13,6 +13,16 @@ const EventHandler = @import("event_emitter.zig").EventHandler;
 const Event = @import("event_emitter.zig").Event;
 const ParserContext = @import("types.zig").ParserContext;
 const ActionFn = @import("types.zig").ActionFn;
+const format_engine = @import("format_engine.zig");
+const FormatEngine = format_engine.FormatEngine;
+const FormatEvent = format_engine.FormatEvent;
+const HandleTable = @import("handle_table.zig").HandleTable;
+const json = @import("parsers/json.zig");
+const csv = @import("parsers/csv.zig");
+const UltraFastTokenizer = @import("fast_matcher.zig").UltraFastTokenizer;
+const AhoCorasick = @import("aho_corasick.zig").AhoCorasick;
+const LazyDfa = @import("lazy_dfa.zig").LazyDfa;
+const regex = @import("regex.zig");
 
 // C compatible error code enum
 pub const ZP_ErrorCode = enum(c_int) {
@@ -56,61 +66,327 @@ pub const ZP_EventCallback = *const fn (
     user_data: ?*anyopaque,
 ) callconv(.C) void;
 
+// Fixed-size event record for the pull API (zp_next_events).
+// Payloads are not copied: offset/length locate them in the input stream,
+// counted from the first byte ever fed to the parser.
+pub const ZP_Event = extern struct {
+    type: c_int,
+    flags: u32,
+    offset: u64,
+    length: u64,
+    line: u32,
+    column: u32,
+};
+
+// Event flags (see format_engine.flags)
+pub const ZP_EVENT_FLAG_DETACHED: u32 = format_engine.flags.detached;
+pub const ZP_EVENT_FLAG_QUOTED: u32 = format_engine.flags.quoted;
+pub const ZP_EVENT_FLAG_KEY: u32 = format_engine.flags.key;
+pub const ZP_EVENT_FLAG_ARRAY: u32 = format_engine.flags.array;
+pub const ZP_EVENT_FLAG_NUMBER: u32 = format_engine.flags.number;
+pub const ZP_EVENT_FLAG_LITERAL: u32 = format_engine.flags.literal;
+
+// Options for the built-in format parsers
+pub const ZP_FormatParams = extern struct {
+    // CSV field delimiter
+    delimiter: u8,
+    // CSV quote character
+    quote: u8,
+    // CSV escape character; 0 means quotes are escaped by doubling
+    escape: u8,
+    // CSV: trim spaces and tabs around unquoted fields
+    trim_whitespace: u8,
+    // CSV: do not report records for empty lines
+    skip_empty_lines: u8,
+    // JSON nesting limit; 0 means unlimited
+    max_depth: u32,
+};
+
+// Built-in formats for zp_tokenize_batch
+pub const ZP_Format = enum(c_int) {
+    ZP_FORMAT_JSON = 0,
+    ZP_FORMAT_CSV = 1,
+    _,
+};
+
+// Literal set built at runtime (an Aho-Corasick automaton)
+pub const ZP_LiteralSet = opaque {};
+
+// Which literal wins among those starting at the same position
+pub const ZP_MatchKind = enum(c_int) {
+    ZP_MATCH_LONGEST = 0,
+    ZP_MATCH_PRIORITY = 1,
+    _,
+};
+
+// Literal occurrence; literal is ZP_NO_LITERAL when nothing matched
+pub const ZP_LiteralMatch = extern struct {
+    literal: u32,
+    start: usize,
+    end: usize,
+};
+
+pub const ZP_NO_LITERAL: u32 = std.math.maxInt(u32);
+
+// Regex set built at runtime (a lazily determinized DFA)
+pub const ZP_RegexSet = opaque {};
+
+// Longest match of a regex set; pattern is ZP_NO_LITERAL when nothing matched
+pub const ZP_PatternMatch = extern struct {
+    pattern: u32,
+    len: usize,
+};
+
+// Why zp_create_regex_set rejected its patterns
+pub const ZP_RegexError = extern struct {
+    // Index of the malformed regex, or ZP_NO_LITERAL if none is to blame
+    pattern: u32,
+    // Byte offset of the error within that regex
+    position: usize,
+    // Static, NUL-terminated description
+    message: [*c]const u8,
+};
+
+// Caller-supplied allocator. `resize` must grow or shrink in place and return
+// nonzero on success; it may be null, in which case memory is always moved.
+pub const ZP_Allocator = extern struct {
+    ctx: ?*anyopaque,
+    alloc: ?*const fn (ctx: ?*anyopaque, size: usize, alignment: usize) callconv(.C) ?*anyopaque,
+    resize: ?*const fn (ctx: ?*anyopaque, ptr: ?*anyopaque, old_size: usize, new_size: usize, alignment: usize) callconv(.C) c_int,
+    free: ?*const fn (ctx: ?*anyopaque, ptr: ?*anyopaque, size: usize, alignment: usize) callconv(.C) void,
+};
+
+// Keep all per-document memory in an arena that zp_reset() releases at once
+pub const ZP_PARSER_FLAG_ARENA: u32 = 1 << 0;
+
+// Options for zp_create_parser_ex
+pub const ZP_ParserOptions = extern struct {
+    // Null means the library's default allocator
+    allocator: [*c]const ZP_Allocator,
+    // ZP_PARSER_FLAG_*
+    flags: u32,
+    // Null means zp_format_params_default()
+    format_params: [*c]const ZP_FormatParams,
+};
+
+// Adapts a ZP_Allocator to std.mem.Allocator
+const CAllocator = struct {
+    c: ZP_Allocator,
+
+    fn allocator(self: *CAllocator) std.mem.Allocator {
+        return .{ .ptr = self, .vtable = &vtable };
+    }
+
+    const vtable = std.mem.Allocator.VTable{
+        .alloc = alloc,
+        .resize = resize,
+        .remap = remap,
+        .free = free,
+    };
+
+    fn alloc(ctx: *anyopaque, len: usize, alignment: std.mem.Alignment, ret_addr: usize) ?[*]u8 {
+        _ = ret_addr;
+        const self: *CAllocator = @ptrCast(@alignCast(ctx));
+        const ptr = self.c.alloc.?(self.c.ctx, len, alignment.toByteUnits()) orelse return null;
+        return @ptrCast(ptr);
+    }
+
+    fn resize(ctx: *anyopaque, memory: []u8, alignment: std.mem.Alignment, new_len: usize, ret_addr: usize) bool {
+        _ = ret_addr;
+        const self: *CAllocator = @ptrCast(@alignCast(ctx));
+        const resize_fn = self.c.resize orelse return false;
+        return resize_fn(self.c.ctx, memory.ptr, memory.len, new_len, alignment.toByteUnits()) != 0;
+    }
+
+    fn remap(ctx: *anyopaque, memory: []u8, alignment: std.mem.Alignment, new_len: usize, ret_addr: usize) ?[*]u8 {
+        return if (resize(ctx, memory, alignment, new_len, ret_addr)) memory.ptr else null;
+    }
+
+    fn free(ctx: *anyopaque, memory: []u8, alignment: std.mem.Alignment, ret_addr: usize) void {
+        _ = ret_addr;
+        const self: *CAllocator = @ptrCast(@alignCast(ctx));
+        // Copy first: the adapter may live inside the block being freed
+        const c = self.c;
+        c.free.?(c.ctx, memory.ptr, memory.len, alignment.toByteUnits());
+    }
+};
+
 // Global allocator for C API
 var gpa = std.heap.GeneralPurposeAllocator(.{}){};
 const global_allocator = gpa.allocator();
 
-// Internal parser registry to track handles
-const ParserRegistry = struct {
-    mutex: std.Thread.Mutex,
-    parsers: std.AutoHashMap(u64, *Parser),
-    
-    fn init() ParserRegistry {
-        return .{
-            .mutex = .{},
-            .parsers = std.AutoHashMap(u64, *Parser).init(global_allocator),
+// Pull-mode queue limit; a token's events may overshoot it by a few
+const max_queued_events = 4096;
+
+// State behind a ZP_Parser handle: the parsing engine plus event delivery.
+// Events go to the C callback when one is set (push mode), otherwise they are
+// queued until the caller drains them with zp_next_events (pull mode). The
+// queue is capped: once it holds max_queued_events the engine stops at the
+// next token and keeps the rest of the input, and zp_next_events resumes it.
+const CParser = struct {
+    // Per-document allocations (the arena when enabled)
+    allocator: std.mem.Allocator,
+    // Allocator for the CParser itself and the arena's backing memory
+    backing: std.mem.Allocator,
+    c_allocator: CAllocator,
+    arena: ?std.heap.ArenaAllocator,
+    format: ?FormatEngine,
+    error_code: ZP_ErrorCode,
+    events: std.ArrayList(ZP_Event),
+    next_event: usize,
+    // zp_finish_parsing was called but the engine stopped on a full queue
+    finishing: bool,
+    callback: ?ZP_EventCallback,
+    user_data: ?*anyopaque,
+
+    fn create(c_allocator: ?ZP_Allocator, use_arena: bool) !*CParser {
+        var adapter = CAllocator{ .c = c_allocator orelse undefined };
+        const allocator = if (c_allocator != null) adapter.allocator() else global_allocator;
+        
+        const self = try allocator.create(CParser);
+        self.* = .{
+            .allocator = undefined,
+            .backing = undefined,
+            .c_allocator = adapter,
+            .arena = null,
+            .format = null,
+            .error_code = .ZP_OK,
+            .events = undefined,
+            .next_event = 0,
+            .finishing = false,
+            .callback = null,
+            .user_data = null,
         };
+        
+        // Point the adapter at its final home before anything keeps a reference to it
+        self.backing = if (c_allocator != null) self.c_allocator.allocator() else global_allocator;
+        if (use_arena) self.arena = std.heap.ArenaAllocator.init(self.backing);
+        self.allocator = if (self.arena) |*arena| arena.allocator() else self.backing;
+        self.events = std.ArrayList(ZP_Event).init(self.allocator);
+        return self;
     }
-    
-    fn deinit(self: *ParserRegistry) void {
-        var it = self.parsers.iterator();
-        while (it.next()) |entry| {
-            const parser_ptr = entry.value_ptr.*;
-            parser_ptr.deinit();
-            global_allocator.destroy(parser_ptr);
+
+    fn destroy(self: *CParser) void {
+        if (self.format) |*engine| engine.deinit();
+        self.events.deinit();
+        if (self.arena) |*arena| arena.deinit();
+        self.backing.destroy(self);
+    }
+
+    // Prepares for the next document. In arena mode all document memory is
+    // released at once instead of buffer by buffer.
+    fn reset(self: *CParser) void {
+        if (self.arena) |*arena| {
+            _ = arena.reset(.retain_capacity);
+            self.events = std.ArrayList(ZP_Event).init(self.allocator);
+            if (self.format) |*engine| {
+                engine.* = FormatEngine.init(self.allocator, engine.format, engine.options);
+            }
+        } else {
+            self.events.clearRetainingCapacity();
+            if (self.format) |*engine| engine.reset();
         }
-        self.parsers.deinit();
+        self.next_event = 0;
+        self.finishing = false;
+        self.error_code = .ZP_OK;
     }
-    
-    fn register(self: *ParserRegistry, parser: *Parser) u64 {
-        const id = parser.handle.id;
-        self.mutex.lock();
-        defer self.mutex.unlock();
-        
-        self.parsers.put(id, parser) catch {
-            // If put fails, we just return the ID anyway since the parser is valid
-            // but won't be in our registry
+
+    // Runs one format-engine call, keeping the error code for zp_get_error_code
+    fn runFormat(self: *CParser, data: ?[]const u8) ZP_Result {
+        if (self.format == null) return makeError(.ZP_ERROR_NOT_IMPLEMENTED);
+        const engine = &self.format.?;
+        // No more chunks once finishing has started
+        if (data != null and self.finishing) return makeError(.ZP_ERROR_INVALID_STATE);
+        if (data == null) self.finishing = true;
+        const result = if (data) |bytes| engine.feed(bytes, self) else engine.finish(self);
+        result catch |err| {
+            self.error_code = if (err == error.InvalidState) .ZP_ERROR_INVALID_STATE else errorToCode(err);
+            return makeError(self.error_code);
         };
-        return id;
+        return makeSuccess(null);
     }
-    
-    fn get(self: *ParserRegistry, id: u64) ?*Parser {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-        
-        return self.parsers.get(id);
+
+    // Continues input the engine kept back while the queue was full
+    fn resumeFormat(self: *CParser) ZP_Result {
+        const engine = if (self.format) |*engine| engine else return makeSuccess(null);
+        if (engine.finished or engine.error_message != null or self.full()) return makeSuccess(null);
+        const more: ?[]const u8 = if (self.finishing) null else "";
+        return self.runFormat(more);
     }
-    
-    fn remove(self: *ParserRegistry, id: u64) void {
-        self.mutex.lock();
-        defer self.mutex.unlock();
-        
-        _ = self.parsers.remove(id);
+
+    // Tells the FormatEngine to stop at the next token boundary
+    pub fn full(self: *const CParser) bool {
+        return self.callback == null and self.events.items.len - self.next_event >= max_queued_events;
     }
+
+    // Sink for FormatEngine events
+    pub fn event(self: *CParser, ev: FormatEvent) !void {
+        try self.deliver(.{
+            .type = @intFromEnum(ev.type),
+            .flags = ev.flags,
+            .offset = ev.offset,
+            .length = ev.data.len,
+            .line = @truncate(ev.line),
+            .column = @truncate(ev.column),
+        }, ev.data);
+    }
+
+    fn deliver(self: *CParser, event: ZP_Event, data: []const u8) !void {
+        if (self.callback) |cb| {
+            var frame = Delivery{ .parser = self, .outer = delivering };
+            delivering = &frame;
+            defer delivering = frame.outer;
+            cb(event.type, data.ptr, data.len, self.user_data);
+            return;
+        }
+        try self.events.append(event);
+    }
+
+    // Copies up to out.len queued events into `out`, returns how many
+    fn drain(self: *CParser, out: []ZP_Event) usize {
+        const pending = self.events.items[self.next_event..];
+        const n = @min(pending.len, out.len);
+        @memcpy(out[0..n], pending[0..n]);
+        self.next_event += n;
+
+        // Reuse the queue storage once everything has been handed out
+        if (self.next_event == self.events.items.len) {
+            self.events.clearRetainingCapacity();
+            self.next_event = 0;
+        }
+        return n;
+    }
+};
+
+// Callbacks running on this thread, innermost first. Their parsers are pinned
+// by the call that delivers the event, so destroying one would wait forever.
+const Delivery = struct {
+    parser: *CParser,
+    outer: ?*const Delivery,
 };
+threadlocal var delivering: ?*const Delivery = null;
+
+fn isDelivering(parser: *CParser) bool {
+    var frame = delivering;
+    while (frame) |f| : (frame = f.outer) {
+        if (f.parser == parser) return true;
+    }
+    return false;
+}
+
+// Handle table for ZP_Parser handles. A ZP_Parser* is really a generation-tagged
+// slot handle, so lookups are lock-free and stale handles are rejected.
+const ParserTable = HandleTable(CParser);
+var parser_table = ParserTable.init(global_allocator);
 
-// Initialize the global parser registry
-var parser_registry = ParserRegistry.init();
+// Handles are packed to pointer width; on 32-bit targets with a narrower generation
+fn parserHandle(parser_ptr: *ZP_Parser) u64 {
+    return ParserTable.fromAddress(@intFromPtr(parser_ptr));
+}
+
+fn destroyParser(parser: *CParser) void {
+    parser.destroy();
+}
 
 // Convert Zig error to ZP_ErrorCode
 fn errorToCode(err: anyerror) ZP_ErrorCode {
@@ -126,7 +402,9 @@ fn errorToCode(err: anyerror) ZP_ErrorCode {
 
 // Cleanup function to be called at program exit
 pub fn cleanup() void {
-    parser_registry.deinit();
+    parser_table.deinit(destroyParser);
+    literal_set_table.deinit(destroyLiteralSet);
+    regex_set_table.deinit(destroyRegexSet);
     _ = gpa.deinit();
 }
 
@@ -146,13 +424,6 @@ fn makeSuccess(data: ?*anyopaque) ZP_Result {
     };
 }
 
-// A null event handler for when we're clearing the handler
-fn nullHandler(event: Event, ctx: ?*anyopaque) !void {
-    _ = event;
-    _ = ctx;
-    // Do nothing
-}
-
 //
 // C API Functions
 //
@@ -189,33 +460,121 @@ export fn zp_create_parser(
     return makeError(.ZP_ERROR_NOT_IMPLEMENTED);
 }
 
+// Fills in the default format parser options
+export fn zp_format_params_default(params: [*c]ZP_FormatParams) callconv(.C) void {
+    if (params == null) return;
+    params.* = .{
+        .delimiter = ',',
+        .quote = '"',
+        .escape = 0,
+        .trim_whitespace = 0,
+        .skip_empty_lines = 1,
+        .max_depth = 0,
+    };
+}
+
 // Creates a simple parser for a specific format (e.g., JSON, CSV)
 export fn zp_create_format_parser(format_name: [*c]const u8) callconv(.C) ZP_Result {
+    return zp_create_format_parser_ex(format_name, null);
+}
+
+// Creates a format parser with explicit options; null params means defaults
+export fn zp_create_format_parser_ex(
+    format_name: [*c]const u8,
+    params: [*c]const ZP_FormatParams,
+) callconv(.C) ZP_Result {
+    return createFormatParser(format_name, params, null, false);
+}
+
+// Creates a format parser with a caller-supplied allocator and/or arena mode
+export fn zp_create_parser_ex(
+    format_name: [*c]const u8,
+    options: [*c]const ZP_ParserOptions,
+) callconv(.C) ZP_Result {
+    if (options == null) {
+        return createFormatParser(format_name, null, null, false);
+    }
+    
+    var c_allocator: ?ZP_Allocator = null;
+    if (options.*.allocator != null) {
+        const supplied = options.*.allocator.*;
+        if (supplied.alloc == null or supplied.free == null) {
+            return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+        }
+        c_allocator = supplied;
+    }
+    
+    const use_arena = options.*.flags & ZP_PARSER_FLAG_ARENA != 0;
+    return createFormatParser(format_name, options.*.format_params, c_allocator, use_arena);
+}
+
+fn createFormatParser(
+    format_name: [*c]const u8,
+    params: [*c]const ZP_FormatParams,
+    c_allocator: ?ZP_Allocator,
+    use_arena: bool,
+) ZP_Result {
     if (format_name == null) {
         return makeError(.ZP_ERROR_INVALID_ARGUMENT);
     }
     
     const name = std.mem.span(format_name);
     
-    // This would create a parser for a specific format
-    if (std.mem.eql(u8, name, "json") or 
-        std.mem.eql(u8, name, "csv") or
-        std.mem.eql(u8, name, "xml")) {
-        // Not implemented yet
-        return makeError(.ZP_ERROR_NOT_IMPLEMENTED);
-    }
+    const format: format_engine.Format = if (std.mem.eql(u8, name, "json"))
+        .json
+    else if (std.mem.eql(u8, name, "csv"))
+        .csv
+    else if (std.mem.eql(u8, name, "xml"))
+        // No XML engine yet
+        return makeError(.ZP_ERROR_NOT_IMPLEMENTED)
+    else
+        return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+    
+    var defaults: ZP_FormatParams = undefined;
+    zp_format_params_default(&defaults);
+    const p: ZP_FormatParams = if (params != null) params.* else defaults;
     
-    return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+    const options = format_engine.Options{
+        .csv = csvConfig(p) orelse return makeError(.ZP_ERROR_PARSER_CONFIG),
+        .max_depth = p.max_depth,
+    };
+    
+    const parser = CParser.create(c_allocator, use_arena) catch {
+        return makeError(.ZP_ERROR_OUT_OF_MEMORY);
+    };
+    parser.format = FormatEngine.init(parser.allocator, format, options);
+    const handle = parser_table.insert(parser) catch {
+        parser.destroy();
+        return makeError(.ZP_ERROR_OUT_OF_MEMORY);
+    };
+    
+    return makeSuccess(@ptrFromInt(ParserTable.toAddress(handle)));
+}
+
+// CSV settings from format params, or null if the delimiter is unusable
+fn csvConfig(p: ZP_FormatParams) ?csv.CsvTokenizer.Config {
+    if (p.delimiter == p.quote or p.delimiter == '\n' or p.delimiter == '\r') return null;
+    return .{
+        .delimiter = p.delimiter,
+        .quote_char = p.quote,
+        .escape_char = if (p.escape != 0) p.escape else null,
+        .skip_empty_lines = p.skip_empty_lines != 0,
+        .trim_whitespace = p.trim_whitespace != 0,
+    };
 }
 
 // Destroys a parser
 export fn zp_destroy_parser(parser_ptr: *ZP_Parser) callconv(.C) ZP_Result {
-    const id = @intFromPtr(parser_ptr);
+    const handle = parserHandle(parser_ptr);
+    if (parser_table.acquire(handle)) |pin| {
+        const busy = isDelivering(pin.value);
+        pin.release();
+        if (busy) return makeError(.ZP_ERROR_INVALID_STATE);
+    }
     
-    if (parser_registry.get(id)) |parser| {
-        parser_registry.remove(id);
-        parser.deinit();
-        global_allocator.destroy(parser);
+    // Waits for calls still using the parser on other threads
+    if (parser_table.remove(handle)) |parser| {
+        parser.destroy();
         return makeSuccess(null);
     }
     
@@ -228,66 +587,14 @@ export fn zp_set_event_handler(
     callback: ?ZP_EventCallback,
     user_data: ?*anyopaque,
 ) callconv(.C) ZP_Result {
-    const id = @intFromPtr(parser_ptr);
-    
-    if (parser_registry.get(id)) |parser| {
-        if (callback) |cb| {
-            // Create a context struct to hold both the callback and user data
-            const CallbackContext = struct {
-                callback: ZP_EventCallback,
-                user_data: ?*anyopaque,
-            };
-            
-            const ctx = global_allocator.create(CallbackContext) catch {
-                return makeError(.ZP_ERROR_OUT_OF_MEMORY);
-            };
-            ctx.* = .{
-                .callback = cb,
-                .user_data = user_data,
-            };
-            
-            // Create a wrapper function that calls the C callback
-            const wrapper = struct {
-                fn handler(event: Event, context: ?*anyopaque) !void {
-                    if (context) |ctx_ptr| {
-                        const cb_ctx = @as(*CallbackContext, @ptrCast(@alignCast(ctx_ptr)));
-                        
-                        // Convert event data to C format
-                        const event_type = @intFromEnum(event.type);
-                        
-                        // Get data from event - this is simplified
-                        var data_ptr: [*c]const u8 = null;
-                        var data_len: usize = 0;
-                        
-                        switch (event.type) {
-                            .VALUE => {
-                                data_ptr = event.data.string_value.ptr;
-                                data_len = event.data.string_value.len;
-                            },
-                            .ERROR => {
-                                data_ptr = event.data.error_info.message.ptr;
-                                data_len = event.data.error_info.message.len;
-                            },
-                            else => {
-                                // Other event types may need special handling
-                            },
-                        }
-                        
-                        // Call the C callback
-                        cb_ctx.callback(event_type, data_ptr, data_len, cb_ctx.user_data);
-                    }
-                }
-            }.handler;
-            
-            // Set the event handler on the parser
-            parser.setEventHandler(EventHandler.init(wrapper, ctx));
-            return makeSuccess(null);
-        } else {
-            // Clear the event handler
-            // Note: Would need to free the context here in a real implementation
-            parser.setEventHandler(EventHandler{.handle_fn = nullHandler, .context = null});
-            return makeSuccess(null);
-        }
+    if (parser_table.acquire(parserHandle(parser_ptr))) |pin| {
+        defer pin.release();
+        const parser = pin.value;
+        
+        // A null callback switches the parser back to pull mode (zp_next_events)
+        parser.callback = callback;
+        parser.user_data = user_data;
+        return makeSuccess(null);
     }
     
     return makeError(.ZP_ERROR_INVALID_HANDLE);
@@ -299,15 +606,17 @@ export fn zp_parse_chunk(
     data: [*c]const u8,
     len: usize,
 ) callconv(.C) ZP_Result {
-    const id = @intFromPtr(parser_ptr);
-    
-    if (parser_registry.get(id)) |parser| {
-        // The current parser doesn't support incremental parsing
-        // Return not implemented
-        _ = parser;
-        _ = data;
-        _ = len;
-        return makeError(.ZP_ERROR_NOT_IMPLEMENTED);
+    if (parser_table.acquire(parserHandle(parser_ptr))) |pin| {
+        defer pin.release();
+        const parser = pin.value;
+        
+        if (data == null and len != 0) {
+            return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+        }
+        
+        // Only the format parsers support incremental parsing
+        const chunk: []const u8 = if (len == 0) "" else data[0..len];
+        return parser.runFormat(chunk);
     }
     
     return makeError(.ZP_ERROR_INVALID_HANDLE);
@@ -315,13 +624,12 @@ export fn zp_parse_chunk(
 
 // Finishes parsing
 export fn zp_finish_parsing(parser_ptr: *ZP_Parser) callconv(.C) ZP_Result {
-    const id = @intFromPtr(parser_ptr);
-    
-    if (parser_registry.get(id)) |parser| {
-        // The current parser doesn't support incremental parsing
-        // Return not implemented
-        _ = parser;
-        return makeError(.ZP_ERROR_NOT_IMPLEMENTED);
+    if (parser_table.acquire(parserHandle(parser_ptr))) |pin| {
+        defer pin.release();
+        const parser = pin.value;
+        
+        // Only the format parsers support incremental parsing
+        return parser.runFormat(null);
     }
     
     return makeError(.ZP_ERROR_INVALID_HANDLE);
@@ -333,34 +641,378 @@ export fn zp_parse_string(
     data: [*c]const u8,
     len: usize,
 ) callconv(.C) ZP_Result {
-    const id = @intFromPtr(parser_ptr);
-    
-    if (parser_registry.get(id)) |parser| {
+    if (parser_table.acquire(parserHandle(parser_ptr))) |pin| {
+        defer pin.release();
+        const parser = pin.value;
+        
         if (data == null) {
             return makeError(.ZP_ERROR_INVALID_ARGUMENT);
         }
         
-        // Create a slice from the C string
-        _ = data[0..len]; // Verify the input range is valid
+        const result = parser.runFormat(data[0..len]);
+        if (result.code != .ZP_OK) return result;
+        return parser.runFormat(null);
+    }
+    
+    return makeError(.ZP_ERROR_INVALID_HANDLE);
+}
+
+// Starts a new document on the same parser, dropping queued events.
+// In arena mode this releases all memory used by the previous document.
+export fn zp_reset(parser_ptr: *ZP_Parser) callconv(.C) ZP_Result {
+    if (parser_table.acquire(parserHandle(parser_ptr))) |pin| {
+        defer pin.release();
+        const parser = pin.value;
         
-        // Parse the input
-        parser.parse() catch |err| {
-            return makeError(errorToCode(err));
-        };
+        parser.reset();
+        return makeSuccess(null);
+    }
+    
+    return makeError(.ZP_ERROR_INVALID_HANDLE);
+}
+
+// Drains queued events into a caller-owned array (pull mode).
+// Events are fixed-size records pointing into the input, so a single call
+// can hand over many events without one FFI transition per event.
+export fn zp_next_events(
+    parser_ptr: *ZP_Parser,
+    out: [*c]ZP_Event,
+    cap: usize,
+    count: [*c]usize,
+) callconv(.C) ZP_Result {
+    if (count == null or (out == null and cap != 0)) {
+        return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+    }
+    count.* = 0;
+    
+    if (parser_table.acquire(parserHandle(parser_ptr))) |pin| {
+        defer pin.release();
+        const parser = pin.value;
         
+        if (cap == 0) return makeSuccess(null);
+        // Refill first, so a zero count means the parser needs more input
+        const resumed = parser.resumeFormat();
+        count.* = parser.drain(out[0..cap]);
+        return resumed;
+    }
+    
+    return makeError(.ZP_ERROR_INVALID_HANDLE);
+}
+
+const JsonLexer = UltraFastTokenizer(json.JsonTokenizer.TokenType, json.JsonTokenizer.patterns);
+
+// Tokenizes a whole buffer into caller-owned parallel arrays, without a parser
+// handle or events. Token types are the ZP_JSON_TOKEN_* / ZP_CSV_TOKEN_* values;
+// JSON whitespace is not reported. When the arrays fill up, `consumed` tells
+// where to resume (pass data + consumed on the next call).
+export fn zp_tokenize_batch(
+    format: ZP_Format,
+    params: [*c]const ZP_FormatParams,
+    data: [*c]const u8,
+    len: usize,
+    types: [*c]u32,
+    offsets: [*c]usize,
+    lengths: [*c]usize,
+    cap: usize,
+    count: [*c]usize,
+    consumed: [*c]usize,
+) callconv(.C) ZP_Result {
+    if (count == null or consumed == null or (data == null and len != 0)) {
+        return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+    }
+    if (cap != 0 and (types == null or offsets == null or lengths == null)) {
+        return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+    }
+    count.* = 0;
+    consumed.* = 0;
+    if (len == 0 or cap == 0) return makeSuccess(null);
+    
+    const input = data[0..len];
+    const out = TokenBatch{
+        .input = input,
+        .types = types[0..cap],
+        .offsets = offsets[0..cap],
+        .lengths = lengths[0..cap],
+    };
+    
+    const result = switch (format) {
+        .ZP_FORMAT_JSON => blk: {
+            var lexer = JsonLexer.init(input);
+            break :blk out.fill(&lexer, json.JsonTokenizer.TokenType, .whitespace, null);
+        },
+        .ZP_FORMAT_CSV => blk: {
+            var config = csv.CsvTokenizer.Config{};
+            if (params != null) {
+                config = csvConfig(params.*) orelse return makeError(.ZP_ERROR_PARSER_CONFIG);
+            }
+            var lexer = csv.UltraFastCsvTokenizer.init(input, config);
+            break :blk out.fill(&lexer, csv.CsvTokenizer.TokenType, null, .eof);
+        },
+        else => return makeError(.ZP_ERROR_INVALID_ARGUMENT),
+    };
+    
+    count.* = result.count;
+    consumed.* = result.consumed;
+    return makeSuccess(null);
+}
+
+// Parallel output arrays for zp_tokenize_batch
+const TokenBatch = struct {
+    input: []const u8,
+    types: []u32,
+    offsets: []usize,
+    lengths: []usize,
+    
+    // Runs `lexer` until the input or the arrays are exhausted; tokens of type
+    // `skip` are dropped, and a token of type `end` marks the end of input
+    fn fill(
+        self: TokenBatch,
+        lexer: anytype,
+        comptime TokenType: type,
+        comptime skip: ?TokenType,
+        comptime end: ?TokenType,
+    ) struct { count: usize, consumed: usize } {
+        var n: usize = 0;
+        while (n < self.types.len) {
+            const token = lexer.next() orelse return .{ .count = n, .consumed = self.input.len };
+            if (end != null and token.type == end.?) return .{ .count = n, .consumed = self.input.len };
+            if (skip != null and token.type == skip.?) continue;
+            
+            self.types[n] = @intFromEnum(token.type);
+            self.offsets[n] = @intFromPtr(token.text.ptr) - @intFromPtr(self.input.ptr);
+            self.lengths[n] = token.text.len;
+            n += 1;
+        }
+        
+        // Arrays are full; anything after the last token is still unread
+        if (lexer.pos >= self.input.len) return .{ .count = n, .consumed = self.input.len };
+        return .{ .count = n, .consumed = lexer.pos };
+    }
+};
+
+// Literal and regex sets are table handles like ZP_Parser, so a repeated
+// destroy or a call on a destroyed set is rejected with INVALID_HANDLE
+const LiteralSetTable = HandleTable(AhoCorasick);
+var literal_set_table = LiteralSetTable.init(global_allocator);
+
+fn literalSetHandle(set_ptr: *const ZP_LiteralSet) u64 {
+    return LiteralSetTable.fromAddress(@intFromPtr(set_ptr));
+}
+
+fn destroyLiteralSet(set: *AhoCorasick) void {
+    set.deinit(global_allocator);
+    global_allocator.destroy(set);
+}
+
+// Builds a literal set from `count` byte strings; literal i has priority i
+export fn zp_create_literal_set(
+    literals: [*c]const [*c]const u8,
+    lens: [*c]const usize,
+    count: usize,
+) callconv(.C) ZP_Result {
+    if (count == 0 or literals == null or lens == null) {
+        return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+    }
+    
+    const slices = global_allocator.alloc([]const u8, count) catch return makeError(.ZP_ERROR_OUT_OF_MEMORY);
+    defer global_allocator.free(slices);
+    for (slices, 0..) |*slice, i| {
+        if (literals[i] == null) return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+        slice.* = literals[i][0..lens[i]];
+    }
+    
+    const set = global_allocator.create(AhoCorasick) catch return makeError(.ZP_ERROR_OUT_OF_MEMORY);
+    set.* = AhoCorasick.init(global_allocator, slices) catch |err| {
+        global_allocator.destroy(set);
+        return makeError(switch (err) {
+            error.OutOfMemory => .ZP_ERROR_OUT_OF_MEMORY,
+            error.EmptyLiteral, error.TooManyLiterals => .ZP_ERROR_INVALID_ARGUMENT,
+        });
+    };
+    const handle = literal_set_table.insert(set) catch {
+        destroyLiteralSet(set);
+        return makeError(.ZP_ERROR_OUT_OF_MEMORY);
+    };
+    return makeSuccess(@ptrFromInt(LiteralSetTable.toAddress(handle)));
+}
+
+export fn zp_destroy_literal_set(set_ptr: ?*ZP_LiteralSet) callconv(.C) ZP_Result {
+    // Waits for searches still using the set on other threads
+    if (literal_set_table.remove(literalSetHandle(set_ptr orelse return makeError(.ZP_ERROR_INVALID_HANDLE)))) |set| {
+        destroyLiteralSet(set);
+        return makeSuccess(null);
+    }
+    
+    return makeError(.ZP_ERROR_INVALID_HANDLE);
+}
+
+// Finds the leftmost literal at or after `start`
+export fn zp_literal_set_find(
+    set_ptr: ?*const ZP_LiteralSet,
+    data: [*c]const u8,
+    len: usize,
+    start: usize,
+    kind: ZP_MatchKind,
+    out: [*c]ZP_LiteralMatch,
+) callconv(.C) ZP_Result {
+    return literalSetSearch(set_ptr, data, len, start, kind, out, false);
+}
+
+// Finds the literal that occurs exactly at `pos`
+export fn zp_literal_set_match_at(
+    set_ptr: ?*const ZP_LiteralSet,
+    data: [*c]const u8,
+    len: usize,
+    pos: usize,
+    kind: ZP_MatchKind,
+    out: [*c]ZP_LiteralMatch,
+) callconv(.C) ZP_Result {
+    return literalSetSearch(set_ptr, data, len, pos, kind, out, true);
+}
+
+fn literalSetSearch(
+    set_ptr: ?*const ZP_LiteralSet,
+    data: [*c]const u8,
+    len: usize,
+    pos: usize,
+    kind: ZP_MatchKind,
+    out: [*c]ZP_LiteralMatch,
+    anchored: bool,
+) ZP_Result {
+    const pin = literal_set_table.acquire(literalSetHandle(set_ptr orelse return makeError(.ZP_ERROR_INVALID_HANDLE))) orelse {
+        return makeError(.ZP_ERROR_INVALID_HANDLE);
+    };
+    defer pin.release();
+    const set: *const AhoCorasick = pin.value;
+    if (out == null or (data == null and len != 0)) return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+    const match_kind: AhoCorasick.MatchKind = switch (kind) {
+        .ZP_MATCH_LONGEST => .longest,
+        .ZP_MATCH_PRIORITY => .priority,
+        else => return makeError(.ZP_ERROR_INVALID_ARGUMENT),
+    };
+    
+    out.* = .{ .literal = ZP_NO_LITERAL, .start = 0, .end = 0 };
+    if (len == 0) return makeSuccess(null);
+    const input = data[0..len];
+    const found = if (anchored) set.matchAt(input, pos, match_kind) else set.find(input, pos, match_kind);
+    if (found) |m| out.* = .{ .literal = m.literal, .start = m.start, .end = m.end };
+    return makeSuccess(null);
+}
+
+// The lazy DFA fills its cache during searches, so calls on one set take turns
+const RegexSet = struct {
+    mutex: std.Thread.Mutex = .{},
+    dfa: LazyDfa,
+};
+
+const RegexSetTable = HandleTable(RegexSet);
+var regex_set_table = RegexSetTable.init(global_allocator);
+
+fn regexSetHandle(set_ptr: *const ZP_RegexSet) u64 {
+    return RegexSetTable.fromAddress(@intFromPtr(set_ptr));
+}
+
+fn destroyRegexSet(set: *RegexSet) void {
+    set.dfa.deinit();
+    global_allocator.destroy(set);
+}
+
+// Builds a regex set from `count` regexes; regex i has priority i.
+// `cache_states` bounds the DFA states kept; 0 picks the default.
+// On ZP_ERROR_INVALID_ARGUMENT, `error_info` (if not null) says what was wrong.
+export fn zp_create_regex_set(
+    patterns: [*c]const [*c]const u8,
+    lens: [*c]const usize,
+    count: usize,
+    cache_states: usize,
+    error_info: [*c]ZP_RegexError,
+) callconv(.C) ZP_Result {
+    if (count == 0 or patterns == null or lens == null) {
+        return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+    }
+    
+    const sources = global_allocator.alloc([]const u8, count) catch return makeError(.ZP_ERROR_OUT_OF_MEMORY);
+    defer global_allocator.free(sources);
+    for (sources, 0..) |*source, i| {
+        if (patterns[i] == null) return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+        source.* = patterns[i][0..lens[i]];
+    }
+    
+    var options = LazyDfa.Options{};
+    if (cache_states != 0) options.cache_states = std.math.cast(u32, cache_states) orelse std.math.maxInt(u32);
+    
+    const set = global_allocator.create(RegexSet) catch return makeError(.ZP_ERROR_OUT_OF_MEMORY);
+    var diagnostic = regex.Diagnostic{};
+    set.* = .{
+        .dfa = LazyDfa.initRegex(global_allocator, sources, options, &diagnostic) catch |err| {
+            global_allocator.destroy(set);
+            if (error_info != null) {
+                error_info.* = switch (err) {
+                    error.InvalidRegex => .{
+                        .pattern = @intCast(diagnostic.source),
+                        .position = diagnostic.pos,
+                        .message = diagnostic.message.ptr,
+                    },
+                    else => .{ .pattern = ZP_NO_LITERAL, .position = 0, .message = "regex set cannot be compiled to an automaton" },
+                };
+            }
+            return makeError(switch (err) {
+                error.OutOfMemory => .ZP_ERROR_OUT_OF_MEMORY,
+                error.InvalidRegex, error.Unsupported => .ZP_ERROR_INVALID_ARGUMENT,
+            });
+        },
+    };
+    const handle = regex_set_table.insert(set) catch {
+        destroyRegexSet(set);
+        return makeError(.ZP_ERROR_OUT_OF_MEMORY);
+    };
+    return makeSuccess(@ptrFromInt(RegexSetTable.toAddress(handle)));
+}
+
+export fn zp_destroy_regex_set(set_ptr: ?*ZP_RegexSet) callconv(.C) ZP_Result {
+    // Waits for matches still using the set on other threads
+    if (regex_set_table.remove(regexSetHandle(set_ptr orelse return makeError(.ZP_ERROR_INVALID_HANDLE)))) |set| {
+        destroyRegexSet(set);
         return makeSuccess(null);
     }
     
     return makeError(.ZP_ERROR_INVALID_HANDLE);
 }
 
+// Finds the longest match starting exactly at `pos`
+export fn zp_regex_set_match_at(
+    set_ptr: ?*ZP_RegexSet,
+    data: [*c]const u8,
+    len: usize,
+    pos: usize,
+    out: [*c]ZP_PatternMatch,
+) callconv(.C) ZP_Result {
+    const pin = regex_set_table.acquire(regexSetHandle(set_ptr orelse return makeError(.ZP_ERROR_INVALID_HANDLE))) orelse {
+        return makeError(.ZP_ERROR_INVALID_HANDLE);
+    };
+    defer pin.release();
+    const set = pin.value;
+    if (out == null or (data == null and len != 0) or pos > len) return makeError(.ZP_ERROR_INVALID_ARGUMENT);
+    
+    out.* = .{ .pattern = ZP_NO_LITERAL, .len = 0 };
+    const input: []const u8 = if (len == 0) "" else data[0..len];
+    set.mutex.lock();
+    defer set.mutex.unlock();
+    const found = set.dfa.longest(input, pos) catch return makeError(.ZP_ERROR_OUT_OF_MEMORY);
+    if (found) |m| out.* = .{ .pattern = m.pattern, .len = m.len };
+    return makeSuccess(null);
+}
+
 // Gets the last error message
 export fn zp_get_error(parser_ptr: *ZP_Parser) callconv(.C) [*c]const u8 {
-    const id = @intFromPtr(parser_ptr);
-    
-    if (parser_registry.get(id)) |parser| {
-        if (parser.handle.data.error_message) |msg| {
-            return msg.ptr;
+    if (parser_table.acquire(parserHandle(parser_ptr))) |pin| {
+        defer pin.release();
+        const parser = pin.value;
+        
+        if (parser.format) |engine| {
+            if (engine.error_message) |msg| {
+                return msg.ptr;
+            }
         }
         return "No error";
     }
@@ -370,10 +1022,11 @@ export fn zp_get_error(parser_ptr: *ZP_Parser) callconv(.C) [*c]const u8 {
 
 // Gets the last error code
 export fn zp_get_error_code(parser_ptr: *ZP_Parser) callconv(.C) c_int {
-    const id = @intFromPtr(parser_ptr);
-    
-    if (parser_registry.get(id)) |parser| {
-        return @intCast(parser.handle.data.error_code);
+    if (parser_table.acquire(parserHandle(parser_ptr))) |pin| {
+        defer pin.release();
+        const parser = pin.value;
+        
+        return @intFromEnum(parser.error_code);
     }
     
     return @intFromEnum(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE);
@@ -394,4 +1047,332 @@ export fn zp_shutdown() callconv(.C) ZP_Result {
 // Test function to verify the C API is working
 export fn zp_test() callconv(.C) c_int {
     return 42;
-}
\ No newline at end of file
+}
+//
+// Tests
+//
+
+test {
+    _ = @import("format_engine.zig");
+    _ = @import("handle_table.zig");
+}
+
+fn testParser(result: ZP_Result) !*ZP_Parser {
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, result.code);
+    return @ptrCast(result.data.?);
+}
+
+fn eventCode(event_type: EventType) c_int {
+    return @intFromEnum(event_type);
+}
+
+test "zp_next_events checks its arguments before the handle" {
+    var events: [4]ZP_Event = undefined;
+    var count: usize = 7;
+    const unknown: *ZP_Parser = @ptrFromInt(0x1000);
+    
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_ARGUMENT, zp_next_events(unknown, &events, events.len, null).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_ARGUMENT, zp_next_events(unknown, null, 1, &count).code);
+    try std.testing.expectEqual(@as(usize, 7), count);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE, zp_next_events(unknown, &events, events.len, &count).code);
+    try std.testing.expectEqual(@as(usize, 0), count);
+}
+
+// ZP_Allocator over std.testing.allocator that counts calls
+const CountingAllocator = struct {
+    allocs: usize = 0,
+    frees: usize = 0,
+    
+    fn c(self: *CountingAllocator) ZP_Allocator {
+        return .{ .ctx = self, .alloc = alloc, .resize = null, .free = free };
+    }
+    
+    fn alloc(ctx: ?*anyopaque, size: usize, alignment: usize) callconv(.C) ?*anyopaque {
+        const self: *CountingAllocator = @ptrCast(@alignCast(ctx.?));
+        self.allocs += 1;
+        const ptr = std.testing.allocator.rawAlloc(size, .fromByteUnits(alignment), @returnAddress()) orelse return null;
+        return ptr;
+    }
+    
+    fn free(ctx: ?*anyopaque, ptr: ?*anyopaque, size: usize, alignment: usize) callconv(.C) void {
+        const self: *CountingAllocator = @ptrCast(@alignCast(ctx.?));
+        self.frees += 1;
+        const bytes: [*]u8 = @ptrCast(ptr.?);
+        std.testing.allocator.rawFree(bytes[0..size], .fromByteUnits(alignment), @returnAddress());
+    }
+};
+
+test "zp_next_events hands out queued events in batches" {
+    const parser = try testParser(zp_create_format_parser("json"));
+    defer _ = zp_destroy_parser(parser);
+    
+    const input = "[1, 22, 333]";
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_parse_string(parser, input, input.len).code);
+    
+    // START_DOCUMENT, START_ELEMENT, 3 x VALUE, END_ELEMENT, END_DOCUMENT
+    var all: [7]ZP_Event = undefined;
+    var total: usize = 0;
+    var batch: [3]ZP_Event = undefined;
+    var sizes: [4]usize = undefined;
+    for (&sizes) |*size| {
+        try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_next_events(parser, &batch, batch.len, size).code);
+        @memcpy(all[total..][0..size.*], batch[0..size.*]);
+        total += size.*;
+    }
+    try std.testing.expectEqualSlices(usize, &.{ 3, 3, 1, 0 }, &sizes);
+    
+    try std.testing.expectEqual(eventCode(.START_DOCUMENT), all[0].type);
+    try std.testing.expectEqual(eventCode(.START_ELEMENT), all[1].type);
+    try std.testing.expect(all[1].flags & ZP_EVENT_FLAG_ARRAY != 0);
+    for (all[2..5], [_][]const u8{ "1", "22", "333" }) |event, text| {
+        try std.testing.expectEqual(eventCode(.VALUE), event.type);
+        try std.testing.expect(event.flags & ZP_EVENT_FLAG_NUMBER != 0);
+        try std.testing.expectEqualStrings(text, input[event.offset..][0..event.length]);
+    }
+    try std.testing.expectEqual(eventCode(.END_ELEMENT), all[5].type);
+    try std.testing.expectEqual(eventCode(.END_DOCUMENT), all[6].type);
+    
+    var count: usize = 1;
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_ARGUMENT, zp_next_events(parser, null, 1, &count).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_next_events(parser, null, 0, &count).code);
+    try std.testing.expectEqual(@as(usize, 0), count);
+}
+
+test "zp_next_events resumes parsing that stopped on a full queue" {
+    const parser = try testParser(zp_create_format_parser("csv"));
+    defer _ = zp_destroy_parser(parser);
+    
+    // START_DOCUMENT, 2000 x (START_ELEMENT, 3 x VALUE, END_ELEMENT), END_DOCUMENT
+    const input = "1,2,3\n" ** 2000;
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_parse_chunk(parser, input, input.len).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_finish_parsing(parser).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_STATE, zp_parse_chunk(parser, input, 1).code);
+    
+    var batch: [256]ZP_Event = undefined;
+    var total: usize = 0;
+    var values: usize = 0;
+    var last: c_int = -1;
+    while (true) {
+        const pin = parser_table.acquire(parserHandle(parser)).?;
+        const queued = pin.value.events.items.len - pin.value.next_event;
+        pin.release();
+        try std.testing.expect(queued <= max_queued_events + 4);
+        
+        var count: usize = 0;
+        try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_next_events(parser, &batch, batch.len, &count).code);
+        if (count == 0) break;
+        for (batch[0..count]) |event| {
+            if (event.type == eventCode(.VALUE)) {
+                try std.testing.expectEqualStrings(&[_]u8{"123"[values % 3]}, input[event.offset..][0..event.length]);
+                values += 1;
+            }
+        }
+        total += count;
+        last = batch[count - 1].type;
+    }
+    try std.testing.expectEqual(@as(usize, 10002), total);
+    try std.testing.expectEqual(@as(usize, 6000), values);
+    try std.testing.expectEqual(eventCode(.END_DOCUMENT), last);
+}
+
+test "zp_create_parser_ex routes all memory through a custom allocator" {
+    var counter = CountingAllocator{};
+    const c_allocator = counter.c();
+    const options = ZP_ParserOptions{ .allocator = &c_allocator, .flags = 0, .format_params = null };
+    const parser = try testParser(zp_create_parser_ex("csv", &options));
+    
+    const input = "a,b\n\"c\",d\n";
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_parse_chunk(parser, input, 5).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_parse_chunk(parser, input[5..].ptr, input.len - 5).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_finish_parsing(parser).code);
+    try std.testing.expect(counter.allocs > 1);
+    
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_destroy_parser(parser).code);
+    try std.testing.expectEqual(counter.allocs, counter.frees);
+    
+    // An allocator without alloc/free is rejected
+    const incomplete = ZP_Allocator{ .ctx = null, .alloc = null, .resize = null, .free = null };
+    const bad_options = ZP_ParserOptions{ .allocator = &incomplete, .flags = 0, .format_params = null };
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_ARGUMENT, zp_create_parser_ex("csv", &bad_options).code);
+}
+
+test "zp_reset starts a new document on an arena parser" {
+    var counter = CountingAllocator{};
+    const c_allocator = counter.c();
+    const options = ZP_ParserOptions{ .allocator = &c_allocator, .flags = ZP_PARSER_FLAG_ARENA, .format_params = null };
+    const parser = try testParser(zp_create_parser_ex("json", &options));
+    
+    const first = "{\"a\": [true, null]}";
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_parse_string(parser, first, first.len).code);
+    
+    // Queued events of the old document are dropped
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_reset(parser).code);
+    var events: [16]ZP_Event = undefined;
+    var count: usize = undefined;
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_next_events(parser, &events, events.len, &count).code);
+    try std.testing.expectEqual(@as(usize, 0), count);
+    
+    // Offsets restart at the new document
+    const second = "[\"x\"]";
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_parse_string(parser, second, second.len).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_next_events(parser, &events, events.len, &count).code);
+    try std.testing.expectEqual(@as(usize, 5), count);
+    try std.testing.expectEqual(eventCode(.VALUE), events[2].type);
+    try std.testing.expectEqual(@as(u64, 2), events[2].offset);
+    try std.testing.expectEqual(@as(u64, 1), events[2].length);
+    
+    // Parsing past the end of a document needs a reset first
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_STATE, zp_parse_chunk(parser, second, second.len).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_reset(parser).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_parse_string(parser, second, second.len).code);
+    
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_destroy_parser(parser).code);
+    try std.testing.expectEqual(counter.allocs, counter.frees);
+}
+
+test "stale parser handles are rejected after destroy" {
+    const parser = try testParser(zp_create_format_parser("csv"));
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_destroy_parser(parser).code);
+    
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE, zp_destroy_parser(parser).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE, zp_parse_chunk(parser, "a", 1).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE, zp_reset(parser).code);
+    try std.testing.expectEqual(@intFromEnum(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE), zp_get_error_code(parser));
+    
+    // A new parser may reuse the slot, but not the handle
+    const next = try testParser(zp_create_format_parser("csv"));
+    defer _ = zp_destroy_parser(next);
+    try std.testing.expect(next != parser);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE, zp_parse_chunk(parser, "a", 1).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_parse_chunk(next, "a", 1).code);
+}
+
+test "zp_destroy_parser refuses to run inside the parser's own callback" {
+    const Context = struct {
+        parser: *ZP_Parser,
+        result: ZP_ErrorCode = .ZP_OK,
+        
+        fn onEvent(event_type: c_int, data: [*c]const u8, data_len: usize, user_data: ?*anyopaque) callconv(.C) void {
+            _ = data;
+            _ = data_len;
+            const self: *@This() = @ptrCast(@alignCast(user_data.?));
+            if (event_type == eventCode(.VALUE)) self.result = zp_destroy_parser(self.parser).code;
+        }
+    };
+    
+    const parser = try testParser(zp_create_format_parser("csv"));
+    var context = Context{ .parser = parser };
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_set_event_handler(parser, &Context.onEvent, &context).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_parse_string(parser, "a\n", 2).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_STATE, context.result);
+    
+    // Once the call has returned the parser can go
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_destroy_parser(parser).code);
+}
+
+test "zp_tokenize_batch applies CSV escape and trimming params" {
+    var params: ZP_FormatParams = undefined;
+    zp_format_params_default(&params);
+    params.escape = '\\';
+    params.trim_whitespace = 1;
+    
+    const input = " a ,\"x\\\"y\"\n";
+    var types: [8]u32 = undefined;
+    var offsets: [8]usize = undefined;
+    var lengths: [8]usize = undefined;
+    var count: usize = undefined;
+    var consumed: usize = undefined;
+    const result = zp_tokenize_batch(.ZP_FORMAT_CSV, &params, input, input.len, &types, &offsets, &lengths, types.len, &count, &consumed);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, result.code);
+    
+    const Type = csv.CsvTokenizer.TokenType;
+    try std.testing.expectEqual(@as(usize, 4), count);
+    try std.testing.expectEqualSlices(u32, &.{ @intFromEnum(Type.field), @intFromEnum(Type.comma), @intFromEnum(Type.quoted_field), @intFromEnum(Type.newline) }, types[0..4]);
+    try std.testing.expectEqualStrings("a", input[offsets[0]..][0..lengths[0]]);
+    try std.testing.expectEqualStrings("\"x\\\"y\"", input[offsets[2]..][0..lengths[2]]);
+    
+    params.delimiter = params.quote;
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_PARSER_CONFIG, zp_tokenize_batch(.ZP_FORMAT_CSV, &params, input, input.len, &types, &offsets, &lengths, types.len, &count, &consumed).code);
+}
+
+test "zp_tokenize_batch resumes at consumed when the arrays fill up" {
+    const input = "{\"id\": 7, \"tags\": [\"a\", \"b\"], \"ok\": false}";
+    
+    var types: [32]u32 = undefined;
+    var offsets: [32]usize = undefined;
+    var lengths: [32]usize = undefined;
+    var count: usize = undefined;
+    var consumed: usize = undefined;
+    var result = zp_tokenize_batch(.ZP_FORMAT_JSON, null, input, input.len, &types, &offsets, &lengths, types.len, &count, &consumed);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, result.code);
+    try std.testing.expectEqual(input.len, consumed);
+    try std.testing.expectEqual(@as(usize, 17), count);
+    
+    // Same tokens three at a time, resuming at data + consumed
+    var pos: usize = 0;
+    var total: usize = 0;
+    while (pos < input.len) {
+        var batch_types: [3]u32 = undefined;
+        var batch_offsets: [3]usize = undefined;
+        var batch_lengths: [3]usize = undefined;
+        result = zp_tokenize_batch(.ZP_FORMAT_JSON, null, input[pos..].ptr, input.len - pos, &batch_types, &batch_offsets, &batch_lengths, 3, &count, &consumed);
+        try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, result.code);
+        try std.testing.expect(consumed > 0);
+        for (0..count) |i| {
+            try std.testing.expectEqual(types[total + i], batch_types[i]);
+            try std.testing.expectEqual(offsets[total + i], pos + batch_offsets[i]);
+            try std.testing.expectEqual(lengths[total + i], batch_lengths[i]);
+        }
+        total += count;
+        pos += consumed;
+    }
+    try std.testing.expectEqual(@as(usize, 17), total);
+    
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_ARGUMENT, zp_tokenize_batch(.ZP_FORMAT_JSON, null, input, input.len, null, null, null, 1, &count, &consumed).code);
+}
+
+test "zp_create_regex_set reports where a regex is malformed" {
+    const good = [_][*c]const u8{ "[a-z]+", "\\d+" };
+    const good_lens = [_]usize{ 6, 3 };
+    const created = zp_create_regex_set(&good, &good_lens, good.len, 0, null);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, created.code);
+    
+    var found: ZP_PatternMatch = undefined;
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_regex_set_match_at(@ptrCast(created.data), "abc12", 5, 3, &found).code);
+    try std.testing.expectEqual(ZP_PatternMatch{ .pattern = 1, .len = 2 }, found);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_destroy_regex_set(@ptrCast(created.data)).code);
+    
+    const bad = [_][*c]const u8{ "ab", "x{3,1}" };
+    const bad_lens = [_]usize{ 2, 6 };
+    var info: ZP_RegexError = undefined;
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_ARGUMENT, zp_create_regex_set(&bad, &bad_lens, bad.len, 0, &info).code);
+    try std.testing.expectEqual(@as(u32, 1), info.pattern);
+    try std.testing.expect(info.position > 0 and info.position <= 6);
+    try std.testing.expectEqualStrings("repeat bounds out of order", std.mem.span(info.message));
+}
+
+test "literal and regex set handles reject use after destroy" {
+    const literals = [_][*c]const u8{ "if", "else" };
+    const literal_lens = [_]usize{ 2, 4 };
+    const literal_set = zp_create_literal_set(&literals, &literal_lens, literals.len);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, literal_set.code);
+    const lset: *ZP_LiteralSet = @ptrCast(literal_set.data.?);
+    
+    var match: ZP_LiteralMatch = undefined;
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_literal_set_find(lset, "x else", 6, 0, .ZP_MATCH_LONGEST, &match).code);
+    try std.testing.expectEqual(ZP_LiteralMatch{ .literal = 1, .start = 2, .end = 6 }, match);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_destroy_literal_set(lset).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE, zp_destroy_literal_set(lset).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE, zp_literal_set_match_at(lset, "if", 2, 0, .ZP_MATCH_LONGEST, &match).code);
+    
+    const patterns = [_][*c]const u8{"[a-z]+"};
+    const pattern_lens = [_]usize{6};
+    const regex_set = zp_create_regex_set(&patterns, &pattern_lens, patterns.len, 0, null);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, regex_set.code);
+    const rset: *ZP_RegexSet = @ptrCast(regex_set.data.?);
+    
+    var found: ZP_PatternMatch = undefined;
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_OK, zp_destroy_regex_set(rset).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE, zp_destroy_regex_set(rset).code);
+    try std.testing.expectEqual(ZP_ErrorCode.ZP_ERROR_INVALID_HANDLE, zp_regex_set_match_at(rset, "abc", 3, 0, &found).code);
+}
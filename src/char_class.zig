@@ -93,6 +93,141 @@ pub inline fn isQuote(c: u8) bool {
     return char_table[c] == .quote;
 }
 
+/// Moves a 1-based line/column position past `text`; only '\n' starts a line
+pub inline fn advancePosition(line: *usize, column: *usize, text: []const u8) void {
+    if (std.mem.lastIndexOfScalar(u8, text, '\n')) |last| {
+        line.* += std.mem.count(u8, text, "\n");
+        column.* = text.len - last;
+    } else {
+        column.* += text.len;
+    }
+}
+
+/// User-defined byte class, built from sets, ranges, CharClasses, unions and
+/// negations. Scalar code tests membership with one bit lookup; `shufti`
+/// turns the set into nibble tables for vector span scanning.
+pub const ByteSet = struct {
+    bits: std.StaticBitSet(256) = std.StaticBitSet(256).initEmpty(),
+    
+    pub fn empty() ByteSet {
+        return .{};
+    }
+    
+    pub fn full() ByteSet {
+        return .{ .bits = std.StaticBitSet(256).initFull() };
+    }
+    
+    pub fn of(chars: []const u8) ByteSet {
+        var set = ByteSet{};
+        for (chars) |c| set.bits.set(c);
+        return set;
+    }
+    
+    pub fn range(min: u8, max: u8) ByteSet {
+        var set = ByteSet{};
+        if (min <= max) set.bits.setRangeValue(.{ .start = min, .end = @as(usize, max) + 1 }, true);
+        return set;
+    }
+    
+    pub fn fromClass(class: CharClass) ByteSet {
+        var set = ByteSet{};
+        for (char_table, 0..) |entry, c| {
+            if (entry == class) set.bits.set(c);
+        }
+        return set;
+    }
+    
+    pub fn unionWith(self: ByteSet, other: ByteSet) ByteSet {
+        return .{ .bits = self.bits.unionWith(other.bits) };
+    }
+    
+    pub fn intersectWith(self: ByteSet, other: ByteSet) ByteSet {
+        return .{ .bits = self.bits.intersectWith(other.bits) };
+    }
+    
+    /// Bytes of `self` that are not in `other`
+    pub fn without(self: ByteSet, other: ByteSet) ByteSet {
+        return .{ .bits = self.bits.differenceWith(other.bits) };
+    }
+    
+    pub fn negate(self: ByteSet) ByteSet {
+        return .{ .bits = self.bits.complement() };
+    }
+    
+    pub inline fn contains(self: ByteSet, c: u8) bool {
+        return self.bits.isSet(c);
+    }
+    
+    pub fn count(self: ByteSet) usize {
+        return self.bits.count();
+    }
+    
+    pub fn fromArray(array: [256]bool) ByteSet {
+        var set = ByteSet{};
+        for (array, 0..) |member, c| set.bits.setValue(c, member);
+        return set;
+    }
+    
+    pub fn toArray(self: ByteSet) [256]bool {
+        var array: [256]bool = undefined;
+        for (&array, 0..) |*b, c| b.* = self.bits.isSet(c);
+        return array;
+    }
+    
+    /// Nibble tables for `set`: byte c is a member iff, for some pair p,
+    /// `lo[p][c & 15] & hi[p][c >> 4] != 0`. High nibbles with the same
+    /// column of low nibbles share a bucket bit; 16 high nibbles give at most
+    /// 16 buckets, so two 8-bit table pairs always represent the set exactly.
+    pub fn shufti(comptime self: ByteSet) Shufti {
+        comptime {
+            @setEvalBranchQuota(10_000);
+            var tables = Shufti{};
+            var buckets: [16]u16 = undefined;
+            var bucket_count: usize = 0;
+            for (0..16) |hi| {
+                var row: u16 = 0;
+                for (0..16) |lo| {
+                    if (self.contains(hi * 16 + lo)) row |= @as(u16, 1) << lo;
+                }
+                if (row == 0) continue;
+                
+                const bucket = for (buckets[0..bucket_count], 0..) |existing, b| {
+                    if (existing == row) break b;
+                } else blk: {
+                    buckets[bucket_count] = row;
+                    bucket_count += 1;
+                    const b = bucket_count - 1;
+                    for (0..16) |lo| {
+                        if (row & (@as(u16, 1) << lo) != 0) tables.lo[b / 8][lo] |= 1 << (b % 8);
+                    }
+                    break :blk b;
+                };
+                tables.hi[bucket / 8][hi] |= 1 << (bucket % 8);
+            }
+            tables.pairs = if (bucket_count > 8) 2 else 1;
+            return tables;
+        }
+    }
+};
+
+/// Shufti lookup tables of a ByteSet; only the first `pairs` are used
+pub const Shufti = struct {
+    lo: [2][16]u8 = .{[_]u8{0} ** 16} ** 2,
+    hi: [2][16]u8 = .{[_]u8{0} ** 16} ** 2,
+    pairs: usize = 1,
+};
+
+test "position tracking" {
+    var line: usize = 1;
+    var column: usize = 1;
+    advancePosition(&line, &column, "ab");
+    try std.testing.expectEqual([2]usize{ 1, 3 }, [2]usize{ line, column });
+    advancePosition(&line, &column, "c\nd\nef");
+    try std.testing.expectEqual([2]usize{ 3, 3 }, [2]usize{ line, column });
+    advancePosition(&line, &column, "\n");
+    try std.testing.expectEqual([2]usize{ 4, 1 }, [2]usize{ line, column });
+}
+
 // Compile-time tests to ensure our table is correct
 test "char classification" {
     try std.testing.expect(isWhitespace(' '));
@@ -115,4 +250,29 @@ test "char classification" {
     try std.testing.expect(isAlphaNumeric('Z'));
     try std.testing.expect(isAlphaNumeric('5'));
     try std.testing.expect(!isAlphaNumeric(' '));
-}
\ No newline at end of file
+}
+
+test "byte set algebra and shufti tables" {
+    // Protocol identifiers: letters, digits and '-', '.', ':'
+    const ident = comptime ByteSet.fromClass(.alpha_lower)
+        .unionWith(ByteSet.fromClass(.alpha_upper))
+        .unionWith(ByteSet.range('0', '9'))
+        .unionWith(ByteSet.of("-.:"));
+    try std.testing.expect(ident.contains('a') and ident.contains('Z') and ident.contains(':'));
+    try std.testing.expect(!ident.contains('_') and !ident.contains(' '));
+    try std.testing.expectEqual(@as(usize, 65), ident.count());
+    
+    const not_ident = comptime ident.negate();
+    try std.testing.expectEqual(@as(usize, 256 - 65), not_ident.count());
+    try std.testing.expectEqual(@as(usize, 0), ident.intersectWith(not_ident).count());
+    try std.testing.expectEqual(@as(usize, 62), ident.without(ByteSet.of("-.:")).count());
+    
+    inline for (.{ ident, not_ident, ByteSet.of("\x00\x13\x26\x39\x4c\x5f\x62\x75\x88\x9b\xae\xc1") }) |set| {
+        const tables = comptime set.shufti();
+        for (0..256) |c| {
+            var hit: u8 = 0;
+            for (0..tables.pairs) |p| hit |= tables.lo[p][c & 15] & tables.hi[p][c >> 4];
+            try std.testing.expectEqual(set.contains(@intCast(c)), hit != 0);
+        }
+    }
+}
@@ -0,0 +1,141 @@
+const std = @import("std");
+const builtin = @import("builtin");
+
+/// Instruction-set tiers, in ascending order; build.zig compiles the hot
+/// kernels once for each x86 tier above the baseline
+pub const IsaLevel = enum(u8) {
+    baseline,
+    sse42,
+    avx2,
+    avx512bw,
+};
+
+/// Features of the CPU the process runs on, not the compile target.
+///
+/// `builtin.cpu.features` only says what the compiler was allowed to assume;
+/// `simd.kernels()` uses this to pick the widest kernel tier the host runs.
+/// On x86 it queries CPUID and checks with XGETBV that the OS saves the wider
+/// register state, since a CPU may support AVX while the kernel has it
+/// disabled.
+pub const CpuFeatures = packed struct(u8) {
+    sse2: bool = false,
+    sse42: bool = false,
+    avx2: bool = false,
+    avx512bw: bool = false,
+    neon: bool = false,
+    _pad: u3 = 0,
+
+    pub fn detect() CpuFeatures {
+        var features = CpuFeatures{};
+
+        switch (builtin.cpu.arch) {
+            .x86, .x86_64 => detectX86(&features),
+            .aarch64 => {
+                // NEON is mandatory on AArch64
+                features.neon = true;
+            },
+            else => {
+                // No SIMD support
+            },
+        }
+
+        return features;
+    }
+
+    /// Highest tier this CPU can run
+    pub fn level(self: CpuFeatures) IsaLevel {
+        if (self.avx512bw) return .avx512bw;
+        if (self.avx2) return .avx2;
+        if (self.sse42) return .sse42;
+        return .baseline;
+    }
+};
+
+// Bit 8 marks the cache as filled
+var cached = std.atomic.Value(u16).init(0);
+
+/// Detected features, probed once per process
+pub fn get() CpuFeatures {
+    const word = cached.load(.acquire);
+    if (word != 0) return @bitCast(@as(u8, @truncate(word)));
+
+    // Racing first calls compute the same value, so no lock is needed
+    const features = CpuFeatures.detect();
+    cached.store(@as(u16, @as(u8, @bitCast(features))) | 0x100, .release);
+    return features;
+}
+
+const CpuidResult = struct {
+    eax: u32,
+    ebx: u32,
+    ecx: u32,
+    edx: u32,
+};
+
+fn cpuid(leaf: u32, subleaf: u32) CpuidResult {
+    var eax: u32 = undefined;
+    var ebx: u32 = undefined;
+    var ecx: u32 = undefined;
+    var edx: u32 = undefined;
+    asm volatile ("cpuid"
+        : [eax] "={eax}" (eax),
+          [ebx] "={ebx}" (ebx),
+          [ecx] "={ecx}" (ecx),
+          [edx] "={edx}" (edx),
+        : [leaf] "{eax}" (leaf),
+          [subleaf] "{ecx}" (subleaf),
+    );
+    return .{ .eax = eax, .ebx = ebx, .ecx = ecx, .edx = edx };
+}
+
+fn xgetbv(index: u32) u64 {
+    var eax: u32 = undefined;
+    var edx: u32 = undefined;
+    asm volatile ("xgetbv"
+        : [eax] "={eax}" (eax),
+          [edx] "={edx}" (edx),
+        : [index] "{ecx}" (index),
+    );
+    return @as(u64, edx) << 32 | eax;
+}
+
+inline fn bit(word: u32, comptime index: u5) bool {
+    return word & (@as(u32, 1) << index) != 0;
+}
+
+fn detectX86(features: *CpuFeatures) void {
+    const max_leaf = cpuid(0, 0).eax;
+    if (max_leaf < 1) return;
+
+    const leaf1 = cpuid(1, 0);
+    features.sse2 = bit(leaf1.edx, 26);
+    features.sse42 = bit(leaf1.ecx, 20);
+
+    // AVX state must be enabled by the OS (OSXSAVE + AVX, XCR0 XMM|YMM)
+    if (!bit(leaf1.ecx, 27) or !bit(leaf1.ecx, 28)) return;
+    const xcr0 = xgetbv(0);
+    if (xcr0 & 0x6 != 0x6 or max_leaf < 7) return;
+
+    const leaf7 = cpuid(7, 0);
+    features.avx2 = bit(leaf7.ebx, 5);
+    // AVX-512 additionally needs opmask, ZMM_Hi256 and Hi16_ZMM state
+    features.avx512bw = xcr0 & 0xE0 == 0xE0 and bit(leaf7.ebx, 16) and bit(leaf7.ebx, 30);
+}
+
+test "runtime CPU feature detection" {
+    const features = get();
+    try std.testing.expectEqual(@as(u8, @bitCast(features)), @as(u8, @bitCast(get())));
+
+    switch (builtin.cpu.arch) {
+        .x86_64 => {
+            try std.testing.expect(features.sse2);
+            // Code compiled for AVX2 can only be running on an AVX2 machine
+            if (comptime std.Target.x86.featureSetHas(builtin.cpu.features, .avx2)) {
+                try std.testing.expect(features.avx2);
+            }
+        },
+        .aarch64 => try std.testing.expect(features.neon),
+        else => {},
+    }
+    if (features.avx512bw) try std.testing.expect(features.level() == .avx512bw);
+}
@@ -1,62 +1,49 @@
 const std = @import("std");
 const Pattern = @import("pattern.zig").Pattern;
-const char_class = @import("char_class.zig");
+const Nfa = @import("nfa.zig").Nfa;
+const simd_module = @import("simd.zig");
 
 /// Compile-time DFA (Deterministic Finite Automaton) generator
 /// Converts patterns into optimized state machines for ultra-fast matching
 pub fn DFAGenerator(comptime patterns: anytype) type {
-    const TokenType = @TypeOf(patterns);
-    const num_patterns = @typeInfo(TokenType).@"struct".fields.len;
-    
-    // Compile-time DFA construction
-    const dfa_table = comptime buildDFATable(patterns);
-    const max_states = dfa_table.len;
+    // Compile-time DFA construction: one NFA for all patterns, determinized
+    const dfa = comptime Dfa.build(Nfa.fromPatterns(patternList(patterns)));
     
     return struct {
         const Self = @This();
         
         /// Pre-compiled transition table for ultra-fast lookups
         /// [current_state][character] -> next_state
-        pub const transition_table = dfa_table;
-        
+        pub const transition_table = dfa.table;
+
+        /// State-machine interface used by ParallelLexer
+        pub const start_state: u32 = 0;
+        pub const dead_state: u32 = DEAD_STATE;
+        pub const state_count = dfa.table.len;
+
+        pub fn next(state: u32, c: u8) u32 {
+            return transition_table[state][c];
+        }
+
+        /// Pattern accepted in `state`, if any
+        pub fn accepting(state: u32) ?u32 {
+            return dfa.accepts[state];
+        }
+
         /// Pattern matching result
         pub const MatchResult = struct {
             pattern_id: ?u32,
             length: usize,
         };
         
-        /// Match patterns against input using DFA
+        /// Match patterns against input using DFA: the longest match, and
+        /// among patterns matching that much, the first declared
         pub fn match(input: []const u8, start_pos: usize) MatchResult {
             if (start_pos >= input.len) return .{ .pattern_id = null, .length = 0 };
             
-            var state: u32 = 0; // Start state
-            var pos = start_pos;
-            var last_accepting_state: ?u32 = null;
-            var last_accepting_pos: usize = start_pos;
-            
-            // Run the DFA
-            while (pos < input.len and state < max_states) {
-                const c = input[pos];
-                const next_state = transition_table[state][c];
-                
-                if (next_state == DEAD_STATE) break;
-                
-                state = next_state;
-                pos += 1;
-                
-                // Check if this is an accepting state
-                if (isAcceptingState(state)) {
-                    last_accepting_state = state;
-                    last_accepting_pos = pos;
-                }
-            }
-            
-            if (last_accepting_state) |accepting_state| {
-                const pattern_id = getPatternId(accepting_state);
-                const length = last_accepting_pos - start_pos;
-                return .{ .pattern_id = pattern_id, .length = length };
+            if (dfa.longest(input, start_pos)) |found| {
+                if (found.len > 0) return .{ .pattern_id = found.pattern, .length = found.len };
             }
-            
             return .{ .pattern_id = null, .length = 0 };
         }
         
@@ -67,7 +54,7 @@ pub fn DFAGenerator(comptime patterns: anytype) type {
         
         /// Match all patterns and return the first (highest priority) match
         pub fn matchFirst(input: []const u8, start_pos: usize) MatchResult {
-            // For now, same as matchLongest since we build priority into the DFA
+            // Priority is built into the accepting states
             return match(input, start_pos);
         }
     };
@@ -75,196 +62,178 @@ pub fn DFAGenerator(comptime patterns: anytype) type {
 
 // Compile-time constants
 const DEAD_STATE: u32 = std.math.maxInt(u32);
-const MAX_STATES: u32 = 1024;
+const MAX_STATES: u32 = 4096;
 
-/// Build DFA transition table at compile time
-fn buildDFATable(comptime patterns: anytype) [MAX_STATES][256]u32 {
-    var table = [_][256]u32{[_]u32{DEAD_STATE} ** 256} ** MAX_STATES;
+/// Patterns of a token set (a struct of Patterns), in field order
+fn patternList(comptime patterns: anytype) []const Pattern {
+    comptime {
+        const fields = @typeInfo(@TypeOf(patterns)).@"struct".fields;
+        var list: [fields.len]Pattern = undefined;
+        for (fields, 0..) |field, i| list[i] = @field(patterns, field.name);
+        const frozen = list;
+        return &frozen;
+    }
+}
+
+/// DFA built at comptime by subset construction. State 0 is the start
+/// state; missing transitions go to DEAD_STATE.
+pub const Dfa = struct {
+    table: []const [256]u32,
+    /// Pattern accepted in each state: the lowest-numbered one
+    accepts: []const ?u32,
     
-    // Start with simple state machine construction
-    // State 0 is the initial state
-    var next_state_id: u32 = 1;
+    pub const Accept = struct {
+        pattern: u32,
+        len: usize,
+    };
     
-    // For each pattern, create a path through the DFA
-    inline for (@typeInfo(@TypeOf(patterns)).@"struct".fields, 0..) |field, pattern_idx| {
-        const pattern = @field(patterns, field.name);
-        
-        // Build states for this pattern
-        const states_built = comptime buildPatternStates(pattern, pattern_idx);
-        
-        // Add transitions to the main table
-        var state_id = next_state_id;
-        for (states_built.transitions, 0..) |transition_set, state_offset| {
-            const current_state = state_id + state_offset;
-            if (current_state >= MAX_STATES) break;
+    pub fn build(comptime nfa: Nfa) Dfa {
+        comptime {
+            @setEvalBranchQuota(50_000_000);
+            const StateSet = std.StaticBitSet(nfa.states.len);
+            const classes = nfa.byteClasses();
+            
+            var sets: []const StateSet = &.{closure(nfa, single(StateSet, nfa.start))};
+            var table: []const [256]u32 = &.{};
+            var accepts: []const ?u32 = &.{};
             
-            for (transition_set, 0..) |next_state, char_index| {
-                if (next_state != DEAD_STATE) {
-                    table[current_state][char_index] = state_id + next_state;
+            var i = 0;
+            while (i < sets.len) : (i += 1) {
+                // One target per byte class, then expand to a row
+                var targets = [_]u32{DEAD_STATE} ** classes.count;
+                for (0..classes.count) |class| {
+                    const byte = classes.representative[class];
+                    var moved = StateSet.initEmpty();
+                    var it = sets[i].iterator(.{});
+                    while (it.next()) |s| {
+                        for (nfa.states[s].edges) |edge| {
+                            if (edge.bytes.contains(byte)) moved.set(edge.to);
+                        }
+                    }
+                    if (moved.count() == 0) continue;
+                    const target = closure(nfa, moved);
+                    targets[class] = for (sets, 0..) |existing, j| {
+                        if (existing.eql(target)) break j;
+                    } else blk: {
+                        if (sets.len == MAX_STATES) @compileError("DFA exceeds MAX_STATES states");
+                        sets = sets ++ &[_]StateSet{target};
+                        break :blk sets.len - 1;
+                    };
+                }
+                var row: [256]u32 = undefined;
+                for (&row, classes.of) |*entry, class| entry.* = targets[class];
+                table = table ++ &[_][256]u32{row};
+                
+                var accept: ?u32 = null;
+                var it = sets[i].iterator(.{});
+                while (it.next()) |s| {
+                    if (nfa.states[s].accept) |id| accept = if (accept) |a| @min(a, id) else id;
                 }
+                accepts = accepts ++ &[_]?u32{accept};
             }
+            return .{ .table = table, .accepts = accepts };
         }
-        
-        next_state_id += states_built.num_states;
-        if (next_state_id >= MAX_STATES) break;
     }
     
-    return table;
-}
-
-/// Result of building states for a pattern
-const PatternStates = struct {
-    transitions: []const [256]u32,
-    num_states: u32,
-    accepting_state: u32,
-};
-
-/// Build DFA states for a single pattern
-fn buildPatternStates(comptime pattern: Pattern, comptime pattern_id: u32) PatternStates {
-    _ = pattern_id;
+    /// Most states `longestShuffle` handles; lane 15 is left for the dead state
+    pub const max_shuffle_states = 15;
     
-    // Simplified DFA construction for basic patterns
-    switch (pattern) {
-        .literal => |lit| {
-            return buildLiteralStates(lit);
-        },
-        .char_class => |class| {
-            return buildCharClassStates(class);
-        },
-        .one_or_more => |sub| {
-            return buildOneOrMoreStates(sub.*);
-        },
-        .any_of => |chars| {
-            return buildAnyOfStates(chars);
-        },
-        else => {
-            // Fallback to simple single-state matcher
-            return buildSimpleStates();
-        },
+    /// Longest accepted prefix of `input[start..]`, possibly empty
+    pub fn longest(comptime self: Dfa, input: []const u8, start: usize) ?Accept {
+        if (comptime simd_module.has_byte_shuffle and self.table.len <= max_shuffle_states) {
+            return self.longestShuffle(input, start);
+        }
+        return self.longestTable(input, start);
     }
-}
-
-/// Build states for literal patterns
-fn buildLiteralStates(comptime literal: []const u8) PatternStates {
-    var transitions = [_][256]u32{[_]u32{DEAD_STATE} ** 256} ** (literal.len + 1);
     
-    // Create a linear chain of states for each character
-    for (literal, 0..) |char, i| {
-        transitions[i][char] = @intCast(i + 1);
+    /// `longest` by table walk; each step loads from the row of the state
+    /// the previous step produced
+    pub fn longestTable(comptime self: Dfa, input: []const u8, start: usize) ?Accept {
+        var state: u32 = 0;
+        var last: ?Accept = if (self.accepts[0]) |id| .{ .pattern = id, .len = 0 } else null;
+        var pos = start;
+        while (pos < input.len) {
+            state = self.table[state][input[pos]];
+            if (state == DEAD_STATE) break;
+            pos += 1;
+            if (self.accepts[state]) |id| last = .{ .pattern = id, .len = pos - start };
+        }
+        return last;
     }
     
-    return .{
-        .transitions = &transitions,
-        .num_states = @intCast(literal.len + 1),
-        .accepting_state = @intCast(literal.len),
-    };
-}
-
-/// Build states for character class patterns
-fn buildCharClassStates(comptime class: @TypeOf(.digit)) PatternStates {
-    var transitions = [_][256]u32{[_]u32{DEAD_STATE} ** 256} ** 2;
-    
-    // State 0 -> State 1 on matching character
-    for (0..256) |i| {
-        const c: u8 = @intCast(i);
-        const matches = switch (class) {
-            .digit => char_class.char_table[c] == .digit,
-            .alpha_lower => char_class.char_table[c] == .alpha_lower,
-            .alpha_upper => char_class.char_table[c] == .alpha_upper,
-            .whitespace => char_class.char_table[c] == .whitespace,
-            .newline => char_class.char_table[c] == .newline,
-            .punct => char_class.char_table[c] == .punct,
-            .quote => char_class.char_table[c] == .quote,
-            else => false,
-        };
-        
-        if (matches) {
-            transitions[0][i] = 1;
+    /// `longest` for DFAs of at most `max_shuffle_states` states. Lane s of
+    /// `states` is where the input so far leads from state s, and a step
+    /// shuffles it by the column for the input byte, so the loop-carried
+    /// chain is one in-register shuffle instead of a state-dependent load.
+    /// Lane 0 is the run from the start state.
+    pub fn longestShuffle(comptime self: Dfa, input: []const u8, start: usize) ?Accept {
+        const form = comptime self.shuffleForm();
+        var states = form.identity;
+        var last: ?Accept = if (self.accepts[0]) |id| .{ .pattern = id, .len = 0 } else null;
+        var pos = start;
+        while (pos < input.len) {
+            states = simd_module.shuffle16(form.columns[input[pos]], states);
+            const state = states[0];
+            if (state == form.dead) break;
+            pos += 1;
+            if (self.accepts[state]) |id| last = .{ .pattern = id, .len = pos - start };
         }
+        return last;
     }
     
-    return .{
-        .transitions = &transitions,
-        .num_states = 2,
-        .accepting_state = 1,
+    const ShuffleForm = struct {
+        /// columns[byte][s] = state after `byte` from state s
+        columns: [256]@Vector(16, u8),
+        identity: @Vector(16, u8),
+        dead: u8,
     };
-}
-
-/// Build states for one-or-more patterns
-fn buildOneOrMoreStates(comptime sub_pattern: Pattern) PatternStates {
-    // For now, handle simple character classes
-    if (sub_pattern == .char_class) {
-        var transitions = [_][256]u32{[_]u32{DEAD_STATE} ** 256} ** 2;
-        
-        const class = sub_pattern.char_class;
-        
-        // State 0 -> State 1 on first match
-        // State 1 -> State 1 on subsequent matches (loop)
-        for (0..256) |i| {
-            const c: u8 = @intCast(i);
-            const matches = switch (class) {
-                .digit => char_class.char_table[c] == .digit,
-                .alpha_lower => char_class.char_table[c] == .alpha_lower,
-                .alpha_upper => char_class.char_table[c] == .alpha_upper,
-                .whitespace => char_class.char_table[c] == .whitespace,
-                else => false,
-            };
-            
-            if (matches) {
-                transitions[0][i] = 1; // First character
-                transitions[1][i] = 1; // Continue matching
+    
+    fn shuffleForm(comptime self: Dfa) ShuffleForm {
+        comptime {
+            if (self.table.len > max_shuffle_states) @compileError("DFA has too many states for longestShuffle");
+            const dead: u8 = self.table.len;
+            var columns: [256]@Vector(16, u8) = undefined;
+            for (&columns, 0..) |*column, byte| {
+                var lanes = [_]u8{dead} ** 16;
+                for (self.table, 0..) |row, state| {
+                    if (row[byte] != DEAD_STATE) lanes[state] = @intCast(row[byte]);
+                }
+                column.* = lanes;
             }
+            var identity = [_]u8{dead} ** 16;
+            for (0..self.table.len) |state| identity[state] = state;
+            return .{ .columns = columns, .identity = identity, .dead = dead };
         }
-        
-        return .{
-            .transitions = &transitions,
-            .num_states = 2,
-            .accepting_state = 1,
-        };
     }
     
-    // Fallback for complex patterns
-    return buildSimpleStates();
-}
-
-/// Build states for any-of patterns
-fn buildAnyOfStates(comptime chars: []const u8) PatternStates {
-    var transitions = [_][256]u8{[_]u8{DEAD_STATE} ** 256} ** 2;
-    
-    // State 0 -> State 1 on any matching character
-    for (chars) |char| {
-        transitions[0][char] = 1;
+    fn single(comptime StateSet: type, comptime state: u32) StateSet {
+        var set = StateSet.initEmpty();
+        set.set(state);
+        return set;
     }
     
-    return .{
-        .transitions = @ptrCast(&transitions),
-        .num_states = 2,
-        .accepting_state = 1,
-    };
-}
-
-/// Fallback simple state builder
-fn buildSimpleStates() PatternStates {
-    const transitions = [_][256]u32{[_]u32{DEAD_STATE} ** 256} ** 1;
-    
-    return .{
-        .transitions = &transitions,
-        .num_states = 1,
-        .accepting_state = 0,
-    };
-}
-
-/// Check if a state is accepting (matches a pattern)
-fn isAcceptingState(state: u32) bool {
-    // For now, simplified: odd states are accepting
-    return state > 0 and state % 2 == 1;
-}
-
-/// Get pattern ID from accepting state
-fn getPatternId(state: u32) u32 {
-    // Simplified mapping
-    return (state - 1) / 2;
-}
+    /// `set` plus every state reachable from it by epsilon moves
+    fn closure(comptime nfa: Nfa, comptime set: anytype) @TypeOf(set) {
+        var result = set;
+        var stack: [nfa.states.len]usize = undefined;
+        var top: usize = 0;
+        var it = set.iterator(.{});
+        while (it.next()) |s| {
+            stack[top] = s;
+            top += 1;
+        }
+        while (top > 0) {
+            top -= 1;
+            for (nfa.states[stack[top]].eps) |to| {
+                if (result.isSet(to)) continue;
+                result.set(to);
+                stack[top] = to;
+                top += 1;
+            }
+        }
+        return result;
+    }
+};
 
 /// Ultra-fast DFA-based tokenizer
 pub fn DFATokenizer(comptime TokenType: type, comptime patterns: anytype) type {
@@ -421,4 +390,38 @@ test "DFA tokenizer" {
     
     // Should be at end
     try std.testing.expect(tokenizer.next() == null);
-}
\ No newline at end of file
+}
+test "DFA decides alternatives in one pass" {
+    const match = @import("pattern.zig").match;
+    const int = comptime match.digit.oneOrMore();
+    const patterns = comptime .{
+        .number = match.choice(.{ int, int.then(match.literal(".")).then(int), match.literal("0x").then(match.anyOf("0123456789abcdef").oneOrMore()) }),
+        .ident = match.alpha.then(match.alphanumeric.zeroOrMore()),
+        .dot = match.literal("."),
+    };
+    
+    const DFA = DFAGenerator(patterns);
+    
+    try std.testing.expectEqual(DFA.MatchResult{ .pattern_id = 0, .length = 4 }, DFA.match("12.5+", 0));
+    try std.testing.expectEqual(DFA.MatchResult{ .pattern_id = 0, .length = 2 }, DFA.match("12.x", 0));
+    try std.testing.expectEqual(DFA.MatchResult{ .pattern_id = 0, .length = 6 }, DFA.match("0xbeef", 0));
+    try std.testing.expectEqual(DFA.MatchResult{ .pattern_id = 1, .length = 1 }, DFA.match("x", 0));
+    try std.testing.expectEqual(DFA.MatchResult{ .pattern_id = 2, .length = 1 }, DFA.match(".5", 0));
+}
+
+test "small DFAs step by shuffle" {
+    const match = @import("pattern.zig").match;
+    const patterns = comptime [_]Pattern{
+        match.regex("\"([^\"]|\"\")*\""),
+        match.regex("[^,\"\n]+"),
+        match.anyOf(",\n"),
+    };
+    const dfa = comptime Dfa.build(Nfa.fromPatterns(&patterns));
+    try std.testing.expect(dfa.table.len <= Dfa.max_shuffle_states);
+    
+    const input = "id,\"say \"\"hi\"\"\",x y\n\"open";
+    for (0..input.len + 1) |start| {
+        try std.testing.expectEqual(dfa.longestTable(input, start), dfa.longestShuffle(input, start));
+    }
+    try std.testing.expectEqual(@as(?Dfa.Accept, .{ .pattern = 0, .len = 12 }), dfa.longestShuffle(input, 3));
+}
@@ -1,6 +1,7 @@
 const std = @import("std");
 const Pattern = @import("pattern.zig").Pattern;
 const char_class = @import("char_class.zig");
+const simd = @import("simd.zig").simd;
 
 /// Simplified DFA-style fast pattern matcher
 /// Uses lookup tables and specialized matchers for maximum performance
@@ -140,10 +141,10 @@ fn matchCharClass(input: []const u8, pos: usize, class: char_class.CharClass) In
 fn matchCharClassRepeated(input: []const u8, pos: usize, class: char_class.CharClass) InternalMatchResult {
     if (pos >= input.len) return .{ .matched = false, .length = 0 };
     
-    var end_pos = pos;
-    while (end_pos < input.len and char_class.char_table[input[end_pos]] == class) {
-        end_pos += 1;
-    }
+    // Vector class masks, ctz to the first byte outside the class
+    const end_pos = switch (class) {
+        inline else => |c| simd.classRunEnd(input, pos, c),
+    };
     
     const length = end_pos - pos;
     return .{ .matched = length > 0, .length = length };
@@ -233,14 +234,7 @@ pub fn FastTokenizer(comptime TokenType: type, comptime patterns: anytype) type
         }
         
         fn updatePosition(self: *Self, text: []const u8) void {
-            for (text) |c| {
-                if (c == '\n') {
-                    self.line += 1;
-                    self.column = 1;
-                } else {
-                    self.column += 1;
-                }
-            }
+            char_class.advancePosition(&self.line, &self.column, text);
         }
         
         pub fn remaining(self: *const Self) []const u8 {
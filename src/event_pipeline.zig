@@ -0,0 +1,582 @@
+const std = @import("std");
+const Position = @import("common.zig").Position;
+const event_emitter = @import("event_emitter.zig");
+const Event = event_emitter.Event;
+const EventType = event_emitter.EventType;
+const EventHandler = event_emitter.EventHandler;
+
+/// Bounded lock-free single-producer/single-consumer ring.
+/// Exactly one thread may push and exactly one (other) thread may pop.
+/// Capacity is rounded up to a power of two so indices wrap with a mask.
+pub fn SpscRing(comptime T: type) type {
+    return struct {
+        const Self = @This();
+
+        allocator: std.mem.Allocator,
+        slots: []T,
+        mask: usize,
+
+        // Producer side: write index plus a cached copy of the read index,
+        // on their own cache line so the consumer never false-shares with it.
+        tail: std.atomic.Value(usize) align(std.atomic.cache_line) = std.atomic.Value(usize).init(0),
+        cached_head: usize = 0,
+
+        // Consumer side: read index plus a cached copy of the write index.
+        head: std.atomic.Value(usize) align(std.atomic.cache_line) = std.atomic.Value(usize).init(0),
+        cached_tail: usize = 0,
+
+        pub fn init(allocator: std.mem.Allocator, capacity: usize) !Self {
+            const actual = try std.math.ceilPowerOfTwo(usize, @max(capacity, 2));
+            return .{
+                .allocator = allocator,
+                .slots = try allocator.alloc(T, actual),
+                .mask = actual - 1,
+            };
+        }
+
+        pub fn deinit(self: *Self) void {
+            self.allocator.free(self.slots);
+        }
+
+        pub fn capacity(self: *const Self) usize {
+            return self.slots.len;
+        }
+
+        /// Producer only. Returns false when the ring is full.
+        pub fn tryPush(self: *Self, item: T) bool {
+            const tail = self.tail.load(.monotonic);
+            if (tail -% self.cached_head >= self.slots.len) {
+                self.cached_head = self.head.load(.acquire);
+                if (tail -% self.cached_head >= self.slots.len) return false;
+            }
+            self.slots[tail & self.mask] = item;
+            self.tail.store(tail +% 1, .release);
+            return true;
+        }
+
+        /// Consumer only. Returns null when the ring is empty.
+        pub fn tryPop(self: *Self) ?T {
+            const head = self.head.load(.monotonic);
+            if (head == self.cached_tail) {
+                self.cached_tail = self.tail.load(.acquire);
+                if (head == self.cached_tail) return null;
+            }
+            const item = self.slots[head & self.mask];
+            self.head.store(head +% 1, .release);
+            return item;
+        }
+
+        /// Approximate number of queued items; safe to call from any thread.
+        pub fn len(self: *const Self) usize {
+            const tail = self.tail.load(.acquire);
+            const head = self.head.load(.acquire);
+            return tail -% head;
+        }
+    };
+}
+
+/// Reference-counted view of one input chunk.
+/// Events whose payload points into `bytes` hold a reference, so the chunk
+/// stays valid until the producer has moved on to the next chunk and the
+/// handler thread has finished with every event that referenced it.
+/// Payloads that live elsewhere (parser buffers, freed token lexemes) are
+/// copied into the epoch's arena and freed with it.
+pub const ChunkEpoch = struct {
+    pub const ReleaseFn = *const fn (bytes: []const u8, ctx: ?*anyopaque) void;
+
+    allocator: std.mem.Allocator,
+    /// Producer only, until the last reference is dropped
+    arena: std.heap.ArenaAllocator,
+    bytes: []const u8,
+    id: u64,
+    refs: std.atomic.Value(u32),
+    release_fn: ?ReleaseFn,
+    release_ctx: ?*anyopaque,
+
+    pub fn create(
+        allocator: std.mem.Allocator,
+        bytes: []const u8,
+        id: u64,
+        release_fn: ?ReleaseFn,
+        release_ctx: ?*anyopaque,
+    ) !*ChunkEpoch {
+        const epoch = try allocator.create(ChunkEpoch);
+        epoch.* = .{
+            .allocator = allocator,
+            .arena = std.heap.ArenaAllocator.init(allocator),
+            .bytes = bytes,
+            .id = id,
+            .refs = std.atomic.Value(u32).init(1),
+            .release_fn = release_fn,
+            .release_ctx = release_ctx,
+        };
+        return epoch;
+    }
+
+    pub fn contains(self: *const ChunkEpoch, data: []const u8) bool {
+        if (data.len == 0) return false;
+        const start = @intFromPtr(self.bytes.ptr);
+        const ptr = @intFromPtr(data.ptr);
+        return ptr >= start and ptr + data.len <= start + self.bytes.len;
+    }
+
+    /// Copies `data` into memory that lives as long as the epoch. Producer only.
+    pub fn copy(self: *ChunkEpoch, data: []const u8) ![]const u8 {
+        return self.arena.allocator().dupe(u8, data);
+    }
+
+    pub fn retain(self: *ChunkEpoch) void {
+        _ = self.refs.fetchAdd(1, .monotonic);
+    }
+
+    /// Drops one reference; the last one runs the release callback and frees the epoch.
+    /// The allocator must therefore be safe to use from the handler thread.
+    pub fn release(self: *ChunkEpoch) void {
+        if (self.refs.fetchSub(1, .acq_rel) != 1) return;
+        if (self.release_fn) |release_fn| {
+            release_fn(self.bytes, self.release_ctx);
+        }
+        self.arena.deinit();
+        self.allocator.destroy(self);
+    }
+};
+
+/// Fixed-size event record that crosses the ring.
+/// The payload is kept as pointer + length and pinned by `epoch`: it lies
+/// either inside the epoch's chunk or in a copy owned by the epoch.
+pub const CompactEvent = struct {
+    type: EventType,
+    position: Position,
+    data_ptr: [*]const u8,
+    data_len: usize,
+    epoch: ?*ChunkEpoch,
+
+    /// Every event but ERROR carries `string_value` (`Event.init` sets it),
+    /// including element names on START_ELEMENT/END_ELEMENT
+    fn payloadOf(event: Event) []const u8 {
+        return switch (event.type) {
+            .ERROR => event.data.error_info.message,
+            else => event.data.string_value,
+        };
+    }
+
+    fn init(event: Event, payload: []const u8, epoch: ?*ChunkEpoch) CompactEvent {
+        return .{
+            .type = event.type,
+            .position = event.position,
+            .data_ptr = payload.ptr,
+            .data_len = payload.len,
+            .epoch = epoch,
+        };
+    }
+
+    fn toEvent(self: CompactEvent) Event {
+        var event = Event.init(self.type, self.position);
+        const payload = self.data_ptr[0..self.data_len];
+        switch (self.type) {
+            .ERROR => event.data = .{ .error_info = .{ .message = payload } },
+            else => event.data = .{ .string_value = payload },
+        }
+        return event;
+    }
+};
+
+pub const PipelineConfig = struct {
+    /// Number of in-flight events between the parser and the handler thread
+    capacity: usize = 4096,
+    /// Busy-wait iterations before yielding the CPU when the ring is full/empty
+    spin_limit: u32 = 128,
+};
+
+pub const PipelineStats = struct {
+    events_pushed: u64,
+    events_handled: u64,
+    producer_stalls: u64,
+    chunks: u64,
+};
+
+/// Opt-in pipelined event delivery.
+/// The parser thread pushes compact events into a bounded SPSC ring through
+/// the `EventHandler` returned by `handler()`, and a dedicated thread drains
+/// the ring into the downstream handler, so expensive handlers overlap with
+/// tokenization instead of stalling it. The parser may free a payload as
+/// soon as the handler returns (e.g. a token lexeme), so payloads outside the
+/// current chunk are copied into its epoch.
+///
+///     var pipeline = try PipelinedEmitter.init(allocator, my_handler, .{});
+///     defer pipeline.deinit();
+///     try pipeline.start();
+///     parser.setEventHandler(pipeline.handler());
+///     try pipeline.beginChunk(chunk, null, null);
+///     try parser.process(chunk);
+///     try pipeline.finish();
+pub const PipelinedEmitter = struct {
+    allocator: std.mem.Allocator,
+    config: PipelineConfig,
+    ring: SpscRing(CompactEvent),
+    downstream: EventHandler,
+    thread: ?std.Thread,
+
+    // Producer-owned state
+    current: ?*ChunkEpoch,
+    next_epoch_id: u64,
+    events_pushed: u64,
+    producer_stalls: u64,
+
+    // Shared state
+    closed: std.atomic.Value(bool),
+    failed: std.atomic.Value(bool),
+    events_handled: std.atomic.Value(u64),
+
+    // Written by the handler thread, read after join
+    handler_error: ?anyerror,
+
+    pub fn init(allocator: std.mem.Allocator, downstream: EventHandler, config: PipelineConfig) !PipelinedEmitter {
+        return .{
+            .allocator = allocator,
+            .config = config,
+            .ring = try SpscRing(CompactEvent).init(allocator, config.capacity),
+            .downstream = downstream,
+            .thread = null,
+            .current = null,
+            .next_epoch_id = 0,
+            .events_pushed = 0,
+            .producer_stalls = 0,
+            .closed = std.atomic.Value(bool).init(false),
+            .failed = std.atomic.Value(bool).init(false),
+            .events_handled = std.atomic.Value(u64).init(0),
+            .handler_error = null,
+        };
+    }
+
+    pub fn deinit(self: *PipelinedEmitter) void {
+        if (self.thread != null) {
+            self.finish() catch {};
+        }
+        self.endChunk();
+        self.ring.deinit();
+    }
+
+    /// Spawns the handler thread
+    pub fn start(self: *PipelinedEmitter) !void {
+        if (self.thread != null) return error.AlreadyStarted;
+        self.closed.store(false, .release);
+        self.thread = try std.Thread.spawn(.{}, consumerLoop, .{self});
+    }
+
+    /// Returns an EventHandler that forwards into the pipeline; install it on the parser
+    pub fn handler(self: *PipelinedEmitter) EventHandler {
+        return EventHandler.init(pushThunk, self);
+    }
+
+    /// Starts a new chunk epoch. Payloads of subsequent events that point into
+    /// `bytes` are pinned until handled, the others are copied; `release_fn`
+    /// runs once the chunk is no longer referenced, which is when the caller
+    /// may reuse the buffer. Without a chunk, every payload is copied.
+    pub fn beginChunk(
+        self: *PipelinedEmitter,
+        bytes: []const u8,
+        release_fn: ?ChunkEpoch.ReleaseFn,
+        release_ctx: ?*anyopaque,
+    ) !void {
+        self.endChunk();
+        self.current = try ChunkEpoch.create(self.allocator, bytes, self.next_epoch_id, release_fn, release_ctx);
+        self.next_epoch_id += 1;
+    }
+
+    /// Drops the producer's reference to the current chunk
+    pub fn endChunk(self: *PipelinedEmitter) void {
+        if (self.current) |epoch| {
+            epoch.release();
+            self.current = null;
+        }
+    }
+
+    /// Producer side: enqueue one event, waiting while the ring is full
+    pub fn push(self: *PipelinedEmitter, event: Event) !void {
+        if (self.thread == null) return error.NotStarted;
+        if (self.failed.load(.acquire)) return error.HandlerFailed;
+
+        // The parser may reuse or free the payload as soon as this returns, so
+        // anything outside the current chunk is copied into the epoch
+        var payload = CompactEvent.payloadOf(event);
+        var epoch: ?*ChunkEpoch = null;
+        if (payload.len != 0) {
+            if (self.current == null) try self.beginChunk("", null, null);
+            const current = self.current.?;
+            if (!current.contains(payload)) payload = try current.copy(payload);
+            current.retain();
+            epoch = current;
+        }
+        const compact = CompactEvent.init(event, payload, epoch);
+
+        var spins: u32 = 0;
+        while (!self.ring.tryPush(compact)) {
+            if (self.failed.load(.acquire)) {
+                if (epoch) |e| e.release();
+                return error.HandlerFailed;
+            }
+            if (spins == 0) self.producer_stalls += 1;
+            backoff(&spins, self.config.spin_limit);
+        }
+        self.events_pushed += 1;
+    }
+
+    /// Closes the pipeline, waits for the handler thread to drain the ring and
+    /// returns the first error raised by the downstream handler, if any
+    pub fn finish(self: *PipelinedEmitter) !void {
+        self.endChunk();
+        const thread = self.thread orelse return;
+        self.closed.store(true, .release);
+        thread.join();
+        self.thread = null;
+        if (self.handler_error) |err| return err;
+    }
+
+    pub fn getStats(self: *const PipelinedEmitter) PipelineStats {
+        return .{
+            .events_pushed = self.events_pushed,
+            .events_handled = self.events_handled.load(.monotonic),
+            .producer_stalls = self.producer_stalls,
+            .chunks = self.next_epoch_id,
+        };
+    }
+
+    fn pushThunk(event: Event, ctx: ?*anyopaque) !void {
+        const self: *PipelinedEmitter = @ptrCast(@alignCast(ctx.?));
+        try self.push(event);
+    }
+
+    fn consumerLoop(self: *PipelinedEmitter) void {
+        var spins: u32 = 0;
+        while (true) {
+            if (self.ring.tryPop()) |compact| {
+                spins = 0;
+                self.deliver(compact);
+                continue;
+            }
+            // Check `closed` before the final pop so no event pushed ahead of
+            // the close can be missed.
+            if (self.closed.load(.acquire)) {
+                while (self.ring.tryPop()) |compact| self.deliver(compact);
+                return;
+            }
+            backoff(&spins, self.config.spin_limit);
+        }
+    }
+
+    fn deliver(self: *PipelinedEmitter, compact: CompactEvent) void {
+        defer if (compact.epoch) |epoch| epoch.release();
+
+        // After a failure keep draining so epochs are released, but stop calling the handler
+        if (self.handler_error != null) return;
+
+        self.downstream.handle(compact.toEvent()) catch |err| {
+            self.handler_error = err;
+            self.failed.store(true, .release);
+            return;
+        };
+        _ = self.events_handled.fetchAdd(1, .monotonic);
+    }
+};
+
+fn backoff(spins: *u32, spin_limit: u32) void {
+    if (spins.* < spin_limit) {
+        spins.* += 1;
+        std.atomic.spinLoopHint();
+    } else {
+        std.Thread.yield() catch {};
+    }
+}
+
+test "spsc ring push and pop" {
+    var ring = try SpscRing(u32).init(std.testing.allocator, 3);
+    defer ring.deinit();
+
+    try std.testing.expectEqual(@as(usize, 4), ring.capacity());
+    try std.testing.expect(ring.tryPush(1));
+    try std.testing.expect(ring.tryPush(2));
+    try std.testing.expect(ring.tryPush(3));
+    try std.testing.expect(ring.tryPush(4));
+    try std.testing.expect(!ring.tryPush(5)); // full
+    try std.testing.expectEqual(@as(usize, 4), ring.len());
+
+    try std.testing.expectEqual(@as(?u32, 1), ring.tryPop());
+    try std.testing.expect(ring.tryPush(5));
+    try std.testing.expectEqual(@as(?u32, 2), ring.tryPop());
+    try std.testing.expectEqual(@as(?u32, 3), ring.tryPop());
+    try std.testing.expectEqual(@as(?u32, 4), ring.tryPop());
+    try std.testing.expectEqual(@as(?u32, 5), ring.tryPop());
+    try std.testing.expectEqual(@as(?u32, null), ring.tryPop());
+}
+
+test "pipelined emitter preserves order and releases chunks" {
+    const Collector = struct {
+        sum: usize = 0,
+        count: usize = 0,
+        last_offset: usize = 0,
+        in_order: bool = true,
+
+        fn handle(event: Event, ctx: ?*anyopaque) !void {
+            const self: *@This() = @ptrCast(@alignCast(ctx.?));
+            if (event.type != .VALUE) return;
+            if (event.position.offset < self.last_offset) self.in_order = false;
+            self.last_offset = event.position.offset;
+            self.sum += std.fmt.parseInt(usize, event.data.string_value, 10) catch 0;
+            self.count += 1;
+        }
+    };
+
+    const Release = struct {
+        fn onRelease(bytes: []const u8, ctx: ?*anyopaque) void {
+            _ = bytes;
+            const counter: *std.atomic.Value(u32) = @ptrCast(@alignCast(ctx.?));
+            _ = counter.fetchAdd(1, .monotonic);
+        }
+    };
+
+    var collector = Collector{};
+    var released = std.atomic.Value(u32).init(0);
+
+    var pipeline = try PipelinedEmitter.init(
+        std.testing.allocator,
+        EventHandler.init(Collector.handle, &collector),
+        .{ .capacity = 8 },
+    );
+    defer pipeline.deinit();
+    try pipeline.start();
+
+    const chunks = [_][]const u8{ "1 2 3 4 5", "6 7 8 9 10" };
+    var offset: usize = 0;
+    for (chunks) |chunk| {
+        try pipeline.beginChunk(chunk, Release.onRelease, &released);
+        var it = std.mem.tokenizeScalar(u8, chunk, ' ');
+        while (it.next()) |number| {
+            var event = Event.init(.VALUE, Position.init(offset, 1, offset + 1));
+            event.data = .{ .string_value = number };
+            try pipeline.handler().handle(event);
+            offset += 1;
+        }
+    }
+    try pipeline.finish();
+
+    try std.testing.expectEqual(@as(usize, 10), collector.count);
+    try std.testing.expectEqual(@as(usize, 55), collector.sum);
+    try std.testing.expect(collector.in_order);
+    try std.testing.expectEqual(@as(u32, 2), released.load(.monotonic));
+    try std.testing.expectEqual(@as(u64, 10), pipeline.getStats().events_handled);
+}
+
+test "compact events keep the payload of every event type" {
+    const position = Position.init(3, 1, 4);
+    const types = [_]EventType{ .START_DOCUMENT, .START_ELEMENT, .VALUE, .END_ELEMENT, .END_DOCUMENT };
+    for (types) |event_type| {
+        var event = Event.init(event_type, position);
+        event.data = .{ .string_value = "row" };
+        const round_trip = CompactEvent.init(event, CompactEvent.payloadOf(event), null).toEvent();
+        try std.testing.expectEqual(event_type, round_trip.type);
+        try std.testing.expectEqualStrings("row", round_trip.data.string_value);
+    }
+
+    var failure = Event.init(.ERROR, position);
+    failure.data = .{ .error_info = .{ .message = "bad byte" } };
+    try std.testing.expectEqualStrings("bad byte", CompactEvent.init(failure, CompactEvent.payloadOf(failure), null).toEvent().data.error_info.message);
+}
+
+test "pipelined emitter copies payloads the parser frees after emitting" {
+    const parser_mod = @import("parser.zig");
+    const tokenizer = @import("tokenizer.zig");
+    const state_machine = @import("state_machine.zig");
+    const ByteStream = @import("byte_stream.zig").ByteStream;
+    const allocator = std.testing.allocator;
+
+    const Grammar = struct {
+        const word = tokenizer.TokenType{ .id = 1, .name = "word" };
+        const space = tokenizer.TokenType{ .id = 2, .name = "space" };
+        // Actions only see the token, so they reach the pipeline through here
+        var pipeline: ?*PipelinedEmitter = null;
+
+        fn matchWord(stream: *ByteStream, alloc: std.mem.Allocator) anyerror!?tokenizer.Token {
+            return matchRun(stream, alloc, word, std.ascii.isAlphabetic);
+        }
+
+        fn matchSpace(stream: *ByteStream, alloc: std.mem.Allocator) anyerror!?tokenizer.Token {
+            return matchRun(stream, alloc, space, std.ascii.isWhitespace);
+        }
+
+        // Like the library's matchers, returns an allocated lexeme that the
+        // parser frees right after the state machine transition
+        fn matchRun(stream: *ByteStream, alloc: std.mem.Allocator, token_type: tokenizer.TokenType, comptime accepts: fn (u8) bool) !?tokenizer.Token {
+            const position = stream.getPosition();
+            var len: usize = 0;
+            while (try stream.peekOffset(len)) |c| : (len += 1) {
+                if (!accepts(c)) break;
+            }
+            if (len == 0) return null;
+            const lexeme = try alloc.dupe(u8, stream.content[position.offset..][0..len]);
+            _ = try stream.consumeCount(len);
+            return tokenizer.Token.init(token_type, position, lexeme);
+        }
+
+        fn emitWord(ctx: *parser_mod.ParserContext, token: tokenizer.Token) anyerror!void {
+            _ = ctx;
+            var event = Event.init(.VALUE, token.position);
+            event.data = .{ .string_value = token.lexeme };
+            try pipeline.?.push(event);
+        }
+    };
+
+    const Collector = struct {
+        text: std.ArrayList(u8),
+        documents_ended: usize = 0,
+
+        fn handle(event: Event, ctx: ?*anyopaque) !void {
+            const self: *@This() = @ptrCast(@alignCast(ctx.?));
+            switch (event.type) {
+                .VALUE => {
+                    try self.text.appendSlice(event.data.string_value);
+                    try self.text.append(',');
+                },
+                .END_DOCUMENT => self.documents_ended += 1,
+                else => {},
+            }
+        }
+    };
+
+    var collector = Collector{ .text = std.ArrayList(u8).init(allocator) };
+    defer collector.text.deinit();
+    var pipeline = try PipelinedEmitter.init(allocator, EventHandler.init(Collector.handle, &collector), .{ .capacity = 4 });
+    defer pipeline.deinit();
+    try pipeline.start();
+    Grammar.pipeline = &pipeline;
+    defer Grammar.pipeline = null;
+
+    const matchers = [_]tokenizer.TokenMatcher{ tokenizer.TokenMatcher.init(Grammar.matchWord), tokenizer.TokenMatcher.init(Grammar.matchSpace) };
+    const transitions = [_]state_machine.StateTransition{
+        state_machine.StateTransition.init(Grammar.word.id, 0, 0),
+        state_machine.StateTransition.init(Grammar.space.id, 0, null),
+    };
+    const states = [_]state_machine.State{state_machine.State.init(0, "TEXT", &transitions)};
+    const actions = [_]state_machine.ActionFn{Grammar.emitWord};
+
+    var parser = try parser_mod.Parser.init(
+        allocator,
+        "",
+        .{ .matchers = &matchers, .skip_types = &.{} },
+        .{ .states = &states, .actions = &actions, .initial_state_id = 0 },
+        4096,
+    );
+    defer parser.deinit();
+    parser.setEventHandler(pipeline.handler());
+
+    // The parser copies each chunk into its own buffer, so no payload lies in a chunk
+    for ([_][]const u8{ "alpha beta ", "gamma ", "delta epsilon " }) |chunk| {
+        try pipeline.beginChunk(chunk, null, null);
+        try parser.process(chunk);
+    }
+    try parser.finish();
+    try pipeline.finish();
+
+    try std.testing.expectEqualStrings("alpha,beta,gamma,delta,epsilon,", collector.text.items);
+    try std.testing.expectEqual(@as(usize, 1), collector.documents_ended);
+}
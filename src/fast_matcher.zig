@@ -1,7 +1,8 @@
 const std = @import("std");
 const Pattern = @import("pattern.zig").Pattern;
 const char_class = @import("char_class.zig");
-const pattern_optimized = @import("pattern_optimized.zig");
+const simd = @import("simd.zig").simd;
+const pattern_ir = @import("pattern_ir.zig");
 
 /// Ultra-fast pattern matcher with specialized fast paths
 /// This is a runtime-optimized version that avoids complex compile-time analysis
@@ -20,8 +21,8 @@ pub const FastMatcher = struct {
         inline for (@typeInfo(@TypeOf(patterns)).@"struct".fields, 0..) |field, i| {
             const pattern = @field(patterns, field.name);
             
-            // Use highly optimized pattern matching
-            const result = pattern_optimized.matchPatternOptimized(pattern, input, start_pos);
+            // Matcher specialized for the pattern's optimized form
+            const result = pattern_ir.Compiled(pattern).match(input, start_pos);
             
             if (result.matched and result.len > 0) {
                 return .{ .pattern_index = i, .length = result.len };
@@ -68,10 +69,11 @@ pub const FastMatcher = struct {
     
     /// Specialized repeated character class matching (for one_or_more patterns)
     pub fn matchCharClassRepeated(input: []const u8, pos: usize, class: char_class.CharClass) usize {
-        var end_pos = pos;
-        while (end_pos < input.len and char_class.char_table[input[end_pos]] == class) {
-            end_pos += 1;
-        }
+        if (pos >= input.len) return 0;
+        // Vector class masks, ctz to the first byte outside the class
+        const end_pos = switch (class) {
+            inline else => |c| simd.classRunEnd(input, pos, c),
+        };
         return end_pos - pos;
     }
     
@@ -157,14 +159,7 @@ pub fn UltraFastTokenizer(comptime TokenType: type, comptime patterns: anytype)
         }
         
         fn updatePosition(self: *Self, text: []const u8) void {
-            for (text) |c| {
-                if (c == '\n') {
-                    self.line += 1;
-                    self.column = 1;
-                } else {
-                    self.column += 1;
-                }
-            }
+            char_class.advancePosition(&self.line, &self.column, text);
         }
         
         pub fn remaining(self: *const Self) []const u8 {
@@ -0,0 +1,673 @@
+const std = @import("std");
+const json = @import("parsers/json.zig");
+const csv = @import("parsers/csv.zig");
+const EventType = @import("event_emitter.zig").EventType;
+
+/// Incremental driver for the zero-allocation JSON and CSV tokenizers.
+/// Input arrives in arbitrary chunks; a token that touches the end of the
+/// buffered input may continue in the next chunk, so it is held back (and
+/// its bytes kept) until more data or `finish()` arrives.
+pub const Format = enum { json, csv };
+
+/// Event flags, shared with the C API (ZP_EVENT_FLAG_*)
+pub const flags = struct {
+    /// Payload is not part of the input (e.g. an error message)
+    pub const detached: u32 = 1 << 0;
+    /// Payload was quoted; offset/length exclude the quotes, escapes are kept
+    pub const quoted: u32 = 1 << 1;
+    /// JSON object key
+    pub const key: u32 = 1 << 2;
+    /// Container is a JSON array (otherwise an object or a CSV record)
+    pub const array: u32 = 1 << 3;
+    /// JSON number
+    pub const number: u32 = 1 << 4;
+    /// JSON true/false/null; the payload says which
+    pub const literal: u32 = 1 << 5;
+};
+
+pub const FormatEvent = struct {
+    type: EventType,
+    flags: u32 = 0,
+    /// Absolute offset of `data` in the whole input stream
+    offset: u64,
+    data: []const u8,
+    line: usize,
+    column: usize,
+};
+
+pub const Options = struct {
+    csv: csv.CsvTokenizer.Config = .{},
+    /// JSON nesting limit, 0 = unlimited
+    max_depth: usize = 0,
+};
+
+const Container = enum(u1) { object, array };
+
+/// What the held-back tail of `pending` is, so `feed` can tell whether new
+/// bytes may complete it
+const Held = enum {
+    /// Anything else; lexed again with every chunk
+    other,
+    /// Unterminated JSON string or CSV quoted field: only a quote can end it
+    quoted,
+    /// Unquoted CSV field: ends at a delimiter, a newline or a quote
+    field,
+};
+
+/// JSON token allowed next
+const Expect = enum {
+    /// A value (top level, after ':' or after ',' in an array)
+    value,
+    /// A value or ']' (just after '[')
+    first_value,
+    /// A key string (after ',' in an object)
+    key,
+    /// A key string or '}' (just after '{')
+    first_key,
+    colon,
+    /// ',' or the closing bracket of the current container
+    next,
+    /// Nothing: the top-level value is complete
+    end,
+
+    fn message(self: Expect) [:0]const u8 {
+        return switch (self) {
+            .value => "expected a value",
+            .first_value => "expected a value or ']'",
+            .key => "expected an object key",
+            .first_key => "expected an object key or '}'",
+            .colon => "expected ':'",
+            .next => "expected ',' or a closing bracket",
+            .end => "unexpected data after the document",
+        };
+    }
+};
+
+pub const FormatEngine = struct {
+    allocator: std.mem.Allocator,
+    format: Format,
+    options: Options,
+    /// Unconsumed bytes carried over from previous chunks
+    pending: std.ArrayList(u8),
+    held: Held,
+    /// Absolute offset of the first byte of the next input (pending or chunk)
+    base_offset: u64,
+    line: usize,
+    column: usize,
+    started: bool,
+    finished: bool,
+    error_message: ?[:0]const u8,
+
+    // JSON state
+    containers: std.ArrayList(Container),
+    expect: Expect,
+
+    // CSV state
+    in_record: bool,
+    after_delimiter: bool,
+
+    pub fn init(allocator: std.mem.Allocator, format: Format, options: Options) FormatEngine {
+        return .{
+            .allocator = allocator,
+            .format = format,
+            .options = options,
+            .pending = std.ArrayList(u8).init(allocator),
+            .held = .other,
+            .base_offset = 0,
+            .line = 1,
+            .column = 1,
+            .started = false,
+            .finished = false,
+            .error_message = null,
+            .containers = std.ArrayList(Container).init(allocator),
+            .expect = .value,
+            .in_record = false,
+            .after_delimiter = false,
+        };
+    }
+
+    pub fn deinit(self: *FormatEngine) void {
+        self.pending.deinit();
+        self.containers.deinit();
+    }
+
+    /// Prepares the engine for a new document, keeping buffer capacity
+    pub fn reset(self: *FormatEngine) void {
+        self.pending.clearRetainingCapacity();
+        self.held = .other;
+        self.containers.clearRetainingCapacity();
+        self.base_offset = 0;
+        self.line = 1;
+        self.column = 1;
+        self.started = false;
+        self.finished = false;
+        self.error_message = null;
+        self.expect = .value;
+        self.in_record = false;
+        self.after_delimiter = false;
+    }
+
+    /// Processes one chunk. `sink.event(FormatEvent) !void` receives the events;
+    /// payload slices are only valid for the duration of that call. A sink may
+    /// also declare `full() bool`: while it returns true the engine stops at the
+    /// next token and keeps the rest of the input for the next call.
+    pub fn feed(self: *FormatEngine, chunk: []const u8, sink: anytype) !void {
+        if (self.finished or self.error_message != null) return error.InvalidState;
+        try self.startDocument(sink);
+
+        var input = chunk;
+        if (self.pending.items.len != 0) {
+            const wait = !self.mayEnd(chunk);
+            try self.pending.appendSlice(chunk);
+            // Lexing again would rescan the whole held-back token for nothing,
+            // which is quadratic for a long string arriving in small chunks
+            if (wait) return;
+            input = self.pending.items;
+        }
+
+        const consumed = try self.run(input, false, sink);
+        const tail = input[consumed..];
+        if (self.pending.items.len != 0) {
+            std.mem.copyForwards(u8, self.pending.items[0..tail.len], tail);
+            self.pending.shrinkRetainingCapacity(tail.len);
+        } else {
+            try self.pending.appendSlice(tail);
+        }
+        self.base_offset += consumed;
+    }
+
+    /// Flushes held-back input, closes open records and ends the document.
+    /// If the sink fills up first, `finished` stays false and `finish()` must be
+    /// called again once it has room.
+    pub fn finish(self: *FormatEngine, sink: anytype) !void {
+        if (self.finished or self.error_message != null) return error.InvalidState;
+        try self.startDocument(sink);
+
+        const input = self.pending.items;
+        const consumed = try self.run(input, true, sink);
+        self.base_offset += consumed;
+        if (consumed < input.len and sinkFull(sink)) {
+            const tail = input[consumed..];
+            std.mem.copyForwards(u8, input[0..tail.len], tail);
+            self.pending.shrinkRetainingCapacity(tail.len);
+            return;
+        }
+        self.pending.clearRetainingCapacity();
+
+        switch (self.format) {
+            .json => if (self.containers.items.len != 0) {
+                return self.fail(sink, self.base_offset, "unterminated object or array");
+            },
+            .csv => if (self.in_record) try self.endRecord(self.base_offset, sink),
+        }
+
+        self.finished = true;
+        try sink.event(.{
+            .type = .END_DOCUMENT,
+            .offset = self.base_offset,
+            .data = "",
+            .line = self.line,
+            .column = self.column,
+        });
+    }
+
+    fn startDocument(self: *FormatEngine, sink: anytype) !void {
+        if (self.started) return;
+        self.started = true;
+        try sink.event(.{ .type = .START_DOCUMENT, .offset = self.base_offset, .data = "", .line = 1, .column = 1 });
+    }
+
+    /// Whether `chunk` may complete the held-back token
+    fn mayEnd(self: *const FormatEngine, chunk: []const u8) bool {
+        const config = self.options.csv;
+        return switch (self.held) {
+            .other => true,
+            .quoted => std.mem.indexOfScalar(u8, chunk, if (self.format == .json) '"' else config.quote_char) != null,
+            .field => std.mem.indexOfAny(u8, chunk, &[_]u8{ config.delimiter, config.quote_char, '\r', '\n' }) != null,
+        };
+    }
+
+    /// Returns how many bytes of `input` were fully processed
+    fn run(self: *FormatEngine, input: []const u8, final: bool, sink: anytype) !usize {
+        self.held = .other;
+        return switch (self.format) {
+            .json => self.runJson(input, final, sink),
+            .csv => self.runCsv(input, final, sink),
+        };
+    }
+
+    /// Whether the sink asked to stop at the next token (see `feed`)
+    fn sinkFull(sink: anytype) bool {
+        const Sink = switch (@typeInfo(@TypeOf(sink))) {
+            .pointer => |p| p.child,
+            else => @TypeOf(sink),
+        };
+        return if (@hasDecl(Sink, "full")) sink.full() else false;
+    }
+
+    /// Records the error, reports it downstream and returns the error to propagate
+    fn fail(self: *FormatEngine, sink: anytype, offset: u64, message: [:0]const u8) anyerror {
+        self.error_message = message;
+        sink.event(.{
+            .type = .ERROR,
+            .flags = flags.detached,
+            .offset = offset,
+            .data = message,
+            .line = self.line,
+            .column = self.column,
+        }) catch |err| return err;
+        return error.UnexpectedToken;
+    }
+
+    // Token positions are relative to the current buffer; `line`/`column`
+    // hold the absolute position of its first byte.
+    fn absLine(self: *const FormatEngine, rel_line: usize) usize {
+        return self.line + rel_line - 1;
+    }
+
+    fn absColumn(self: *const FormatEngine, rel_line: usize, rel_column: usize) usize {
+        return if (rel_line == 1) self.column + rel_column - 1 else rel_column;
+    }
+
+    fn advanceTo(self: *FormatEngine, rel_line: usize, rel_column: usize) void {
+        self.column = self.absColumn(rel_line, rel_column);
+        self.line = self.absLine(rel_line);
+    }
+
+    //
+    // JSON
+    //
+
+    fn runJson(self: *FormatEngine, input: []const u8, final: bool, sink: anytype) !usize {
+        var tokenizer = json.JsonTokenizer.init(input);
+        var consumed: usize = 0;
+        var line: usize = 1;
+        var column: usize = 1;
+
+        while (tokenizer.stream.pos < input.len and !sinkFull(sink)) {
+            const start = tokenizer.stream.pos;
+            const token = tokenizer.next() orelse {
+                if (!final and couldContinueJson(input[start..])) {
+                    if (input[start] == '"') self.held = .quoted;
+                    break;
+                }
+                self.advanceTo(line, column);
+                return self.fail(sink, self.base_offset + start, "unexpected character");
+            };
+            if (!final and tokenizer.stream.pos == input.len) break; // May continue in the next chunk
+
+            try self.jsonToken(token, self.base_offset + start, sink);
+            consumed = tokenizer.stream.pos;
+            line = tokenizer.stream.line;
+            column = tokenizer.stream.column;
+        }
+
+        self.advanceTo(line, column);
+        return consumed;
+    }
+
+    fn jsonToken(self: *FormatEngine, token: json.JsonTokenizer.Token, offset: u64, sink: anytype) !void {
+        var event = FormatEvent{
+            .type = .VALUE,
+            .offset = offset,
+            .data = token.text,
+            .line = self.absLine(token.line),
+            .column = self.absColumn(token.line, token.column),
+        };
+
+        const expect = self.expect;
+        switch (token.type) {
+            .whitespace => return,
+            .lbrace, .lbracket => {
+                if (expect != .value and expect != .first_value) return self.fail(sink, offset, expect.message());
+                if (self.options.max_depth != 0 and self.containers.items.len >= self.options.max_depth) {
+                    return self.fail(sink, offset, "maximum nesting depth exceeded");
+                }
+                const container: Container = if (token.type == .lbrace) .object else .array;
+                try self.containers.append(container);
+                self.expect = if (container == .object) .first_key else .first_value;
+                event.type = .START_ELEMENT;
+                if (container == .array) event.flags |= flags.array;
+            },
+            .rbrace, .rbracket => {
+                const container: Container = if (token.type == .rbrace) .object else .array;
+                const empty: Expect = if (container == .object) .first_key else .first_value;
+                if (expect != .next and expect != empty) {
+                    if (expect == .first_key or expect == .first_value) {
+                        return self.fail(sink, offset, "mismatched closing bracket");
+                    }
+                    return self.fail(sink, offset, expect.message());
+                }
+                if (self.containers.pop() != container) {
+                    return self.fail(sink, offset, "mismatched closing bracket");
+                }
+                self.valueDone();
+                event.type = .END_ELEMENT;
+                if (container == .array) event.flags |= flags.array;
+            },
+            .comma => {
+                if (expect != .next) return self.fail(sink, offset, expect.message());
+                self.expect = if (self.containers.getLast() == .object) .key else .value;
+                return;
+            },
+            .colon => {
+                if (expect != .colon) return self.fail(sink, offset, expect.message());
+                self.expect = .value;
+                return;
+            },
+            .string => {
+                event.flags |= flags.quoted;
+                event.data = token.text[1 .. token.text.len - 1];
+                event.offset += 1;
+                switch (expect) {
+                    .key, .first_key => {
+                        event.flags |= flags.key;
+                        self.expect = .colon;
+                    },
+                    .value, .first_value => self.valueDone(),
+                    else => return self.fail(sink, offset, expect.message()),
+                }
+            },
+            .number, .true_lit, .false_lit, .null_lit => {
+                if (expect != .value and expect != .first_value) return self.fail(sink, offset, expect.message());
+                event.flags |= if (token.type == .number) flags.number else flags.literal;
+                self.valueDone();
+            },
+            .error_token => return self.fail(sink, offset, "unexpected token"),
+        }
+
+        try sink.event(event);
+    }
+
+    /// A value just ended; what may follow depends on its container
+    fn valueDone(self: *FormatEngine) void {
+        self.expect = if (self.containers.items.len == 0) .end else .next;
+    }
+
+    /// Whether an unmatched tail could still become a token with more input
+    fn couldContinueJson(rest: []const u8) bool {
+        if (rest.len == 0) return false;
+        if (rest[0] == '"') return true; // Unterminated string
+        for ([_][]const u8{ "true", "false", "null" }) |literal| {
+            if (rest.len < literal.len and std.mem.startsWith(u8, literal, rest)) return true;
+        }
+        return false;
+    }
+
+    //
+    // CSV
+    //
+
+    fn runCsv(self: *FormatEngine, input: []const u8, final: bool, sink: anytype) !usize {
+        var tokenizer = csv.CsvTokenizer.init(input, self.options.csv);
+        var consumed: usize = 0;
+        var line: usize = 1;
+        var column: usize = 1;
+
+        while (tokenizer.stream.pos < input.len and !sinkFull(sink)) {
+            const token = tokenizer.next() orelse break;
+            if (token.type == .eof) {
+                // Only skipped whitespace was left
+                if (final) consumed = input.len;
+                break;
+            }
+            if (!final and tokenizer.stream.pos == input.len) {
+                // May continue in the next chunk
+                self.held = switch (token.type) {
+                    .field => .field,
+                    .quoted_field => if (self.quoteClosed(token.text)) .other else .quoted,
+                    else => .other,
+                };
+                break;
+            }
+
+            const start = @intFromPtr(token.text.ptr) - @intFromPtr(input.ptr);
+            try self.csvToken(token, self.base_offset + start, sink);
+            consumed = tokenizer.stream.pos;
+            line = tokenizer.stream.line;
+            column = tokenizer.stream.column;
+        }
+
+        self.advanceTo(line, column);
+        return consumed;
+    }
+
+    fn csvToken(self: *FormatEngine, token: csv.CsvTokenizer.Token, offset: u64, sink: anytype) !void {
+        const line = self.absLine(token.line);
+        const column = self.absColumn(token.line, token.column);
+
+        switch (token.type) {
+            .field, .quoted_field => {
+                if (!self.in_record) try self.startRecord(offset, line, column, sink);
+                var event = FormatEvent{ .type = .VALUE, .offset = offset, .data = token.text, .line = line, .column = column };
+                if (token.type == .quoted_field) {
+                    // Fields touching the end of a chunk are held back, so an
+                    // open quote here means the input ended inside the field
+                    if (!self.quoteClosed(token.text)) return self.fail(sink, offset, "unterminated quoted field");
+                    event.data = token.text[1 .. token.text.len - 1];
+                    event.offset += 1;
+                    event.flags |= flags.quoted;
+                }
+                self.after_delimiter = false;
+                try sink.event(event);
+            },
+            .comma => {
+                if (!self.in_record) {
+                    try self.startRecord(offset, line, column, sink);
+                    try self.emptyField(offset, line, column, sink); // Leading empty field
+                } else if (self.after_delimiter) {
+                    try self.emptyField(offset, line, column, sink);
+                }
+                self.after_delimiter = true;
+            },
+            .newline => {
+                if (self.in_record) {
+                    try self.endRecord(offset, sink);
+                } else if (!self.options.csv.skip_empty_lines) {
+                    try self.startRecord(offset, line, column, sink);
+                    try self.endRecord(offset, sink);
+                }
+            },
+            .eof => {},
+            .error_token => return self.fail(sink, offset, "malformed CSV field"),
+        }
+    }
+
+    /// Whether a quoted field token ends with its closing quote, scanning it
+    /// the way the tokenizer does (doubled quotes and escapes stay inside)
+    fn quoteClosed(self: *const FormatEngine, text: []const u8) bool {
+        const quote = self.options.csv.quote_char;
+        var i: usize = 1;
+        while (i < text.len) {
+            const c = text[i];
+            if (c == quote) {
+                if (i + 1 < text.len and text[i + 1] == quote) {
+                    i += 2;
+                    continue;
+                }
+                return i + 1 == text.len;
+            }
+            if (self.options.csv.escape_char) |escape| {
+                if (c == escape and i + 1 < text.len) {
+                    i += 2;
+                    continue;
+                }
+            }
+            i += 1;
+        }
+        return false;
+    }
+
+    fn startRecord(self: *FormatEngine, offset: u64, line: usize, column: usize, sink: anytype) !void {
+        self.in_record = true;
+        self.after_delimiter = false;
+        try sink.event(.{ .type = .START_ELEMENT, .offset = offset, .data = "", .line = line, .column = column });
+    }
+
+    fn endRecord(self: *FormatEngine, offset: u64, sink: anytype) !void {
+        if (self.after_delimiter) try self.emptyField(offset, self.line, self.column, sink); // Trailing empty field
+        self.in_record = false;
+        self.after_delimiter = false;
+        try sink.event(.{ .type = .END_ELEMENT, .offset = offset, .data = "", .line = self.line, .column = self.column });
+    }
+
+    fn emptyField(self: *FormatEngine, offset: u64, line: usize, column: usize, sink: anytype) !void {
+        _ = self;
+        try sink.event(.{ .type = .VALUE, .offset = offset, .data = "", .line = line, .column = column });
+    }
+};
+
+const TestSink = struct {
+    events: std.ArrayList(FormatEvent),
+    text: std.ArrayList(u8),
+
+    fn init(allocator: std.mem.Allocator) TestSink {
+        return .{
+            .events = std.ArrayList(FormatEvent).init(allocator),
+            .text = std.ArrayList(u8).init(allocator),
+        };
+    }
+
+    fn deinit(self: *TestSink) void {
+        self.events.deinit();
+        self.text.deinit();
+    }
+
+    pub fn event(self: *TestSink, ev: FormatEvent) !void {
+        try self.events.append(ev);
+        // Payloads are transient, so record them as text for comparison
+        try self.text.writer().print("{s}:{d}:{s};", .{ @tagName(ev.type), ev.offset, ev.data });
+    }
+};
+
+fn feedInChunks(format: Format, input: []const u8, chunk_size: usize, sink: *TestSink) !void {
+    var engine = FormatEngine.init(std.testing.allocator, format, .{});
+    defer engine.deinit();
+    var pos: usize = 0;
+    while (pos < input.len) {
+        const end = @min(pos + chunk_size, input.len);
+        try engine.feed(input[pos..end], sink);
+        pos = end;
+    }
+    try engine.finish(sink);
+}
+
+test "format engine JSON events are independent of chunking" {
+    const input =
+        \\{"name": "Ada", "tags": ["x", "y"], "age": 36, "ok": true, "none": null}
+    ;
+
+    var whole = TestSink.init(std.testing.allocator);
+    defer whole.deinit();
+    try feedInChunks(.json, input, input.len, &whole);
+
+    var chunked = TestSink.init(std.testing.allocator);
+    defer chunked.deinit();
+    try feedInChunks(.json, input, 3, &chunked);
+
+    try std.testing.expectEqualStrings(whole.text.items, chunked.text.items);
+
+    // First key points into the input, without quotes
+    const key = whole.events.items[2];
+    try std.testing.expectEqual(EventType.VALUE, key.type);
+    try std.testing.expect(key.flags & flags.key != 0);
+    try std.testing.expectEqualStrings("name", input[key.offset..][0..key.data.len]);
+    try std.testing.expectEqual(EventType.END_DOCUMENT, whole.events.items[whole.events.items.len - 1].type);
+}
+
+test "format engine rejects malformed JSON at any chunking" {
+    const malformed = [_][]const u8{
+        "[1 2]",
+        "{\"a\" 1}",
+        "{1:2}",
+        "[1,]",
+        "{\"a\":}",
+        "1 2",
+        "{\"a\":1,}",
+        "[,1]",
+        "{,}",
+        "[1]]",
+        ":1",
+        "{\"a\",1}",
+        "[1}",
+        "{\"a\":1]",
+    };
+    for (malformed) |input| {
+        for ([_]usize{ input.len, 1 }) |chunk_size| {
+            var sink = TestSink.init(std.testing.allocator);
+            defer sink.deinit();
+            try std.testing.expectError(error.UnexpectedToken, feedInChunks(.json, input, chunk_size, &sink));
+            try std.testing.expectEqual(EventType.ERROR, sink.events.items[sink.events.items.len - 1].type);
+        }
+    }
+
+    const valid = [_][]const u8{ "[]", "{}", " 7 ", "[[],{}]", "{\"a\":{\"b\":[1,{},\"c\"]},\"d\":null}" };
+    for (valid) |input| {
+        for ([_]usize{ input.len, 1 }) |chunk_size| {
+            var sink = TestSink.init(std.testing.allocator);
+            defer sink.deinit();
+            try feedInChunks(.json, input, chunk_size, &sink);
+        }
+    }
+}
+
+test "format engine CSV records and empty fields" {
+    const input = "a,,\"b,c\"\n\n1,2,3\n";
+
+    var whole = TestSink.init(std.testing.allocator);
+    defer whole.deinit();
+    try feedInChunks(.csv, input, input.len, &whole);
+
+    var chunked = TestSink.init(std.testing.allocator);
+    defer chunked.deinit();
+    try feedInChunks(.csv, input, 2, &chunked);
+
+    try std.testing.expectEqualStrings(whole.text.items, chunked.text.items);
+
+    var values: usize = 0;
+    var records: usize = 0;
+    for (whole.events.items) |ev| {
+        switch (ev.type) {
+            .VALUE => values += 1,
+            .START_ELEMENT => records += 1,
+            else => {},
+        }
+    }
+    try std.testing.expectEqual(@as(usize, 6), values);
+    try std.testing.expectEqual(@as(usize, 2), records);
+}
+
+test "format engine holds long strings and fields across many small chunks" {
+    const cases = [_]struct { format: Format, input: []const u8 }{
+        .{ .format = .json, .input = "[\"" ++ "ab\\\"" ** 400 ++ "\", 12345678, \"" ++ "x" ** 1000 ++ "\"]" },
+        .{ .format = .csv, .input = "\"" ++ "a,b\n\"\"" ** 300 ++ "\"," ++ "y" ** 1000 ++ "\nz\n" },
+    };
+    for (cases) |case| {
+        var whole = TestSink.init(std.testing.allocator);
+        defer whole.deinit();
+        try feedInChunks(case.format, case.input, case.input.len, &whole);
+
+        for ([_]usize{ 1, 3, 64 }) |chunk_size| {
+            var chunked = TestSink.init(std.testing.allocator);
+            defer chunked.deinit();
+            try feedInChunks(case.format, case.input, chunk_size, &chunked);
+            try std.testing.expectEqualStrings(whole.text.items, chunked.text.items);
+        }
+    }
+}
+
+test "format engine CSV rejects an unterminated quoted field" {
+    for ([_][]const u8{ "a,\"bc\n", "\"x\"\"", "\"" }) |input| {
+        for ([_]usize{ input.len, 1 }) |chunk_size| {
+            var sink = TestSink.init(std.testing.allocator);
+            defer sink.deinit();
+            try std.testing.expectError(error.UnexpectedToken, feedInChunks(.csv, input, chunk_size, &sink));
+            try std.testing.expectEqualStrings("unterminated quoted field", sink.events.items[sink.events.items.len - 1].data);
+        }
+    }
+
+    var sink = TestSink.init(std.testing.allocator);
+    defer sink.deinit();
+    try feedInChunks(.csv, "\"x\"\"y\"", 1, &sink);
+    try std.testing.expectEqualStrings("x\"\"y", sink.events.items[2].data);
+}
@@ -0,0 +1,255 @@
+const std = @import("std");
+const char_class = @import("char_class.zig");
+const pattern = @import("pattern.zig");
+const nfa = @import("nfa.zig");
+
+const Pattern = pattern.Pattern;
+const ByteSet = char_class.ByteSet;
+
+/// Glushkov automaton of a pattern, run bit-parallel.
+///
+/// Each byte-consuming leaf of the pattern is a position, and a match is a
+/// walk over positions. With at most 63 positions (bit 0 is the start) the
+/// set of live positions fits in a u64, and a step is
+/// `follow(live) & masks[byte]`: no states to determinize, so patterns that
+/// blow a DFA up (`[ab]*a[ab]{8}` needs 512 states) stay at a few words.
+/// When each position only continues to itself and the next one, `follow`
+/// is a shift (Shift-And); otherwise it is looked up 8 positions at a time.
+pub const Glushkov = struct {
+    /// Bytes each position consumes; position 0 is the start
+    bytes: []const ByteSet,
+    /// Positions that may come after each position
+    follow: []const u64,
+    /// Positions a match may end on; bit 0 when the empty string matches
+    last: u64,
+
+    pub const max_positions = 64;
+
+    /// Automaton of `p`, or null if it has more than `max_positions - 1`
+    /// positions or no automaton form (see `nfa.supports`)
+    pub fn fromPattern(comptime p: Pattern) ?Glushkov {
+        comptime {
+            @setEvalBranchQuota(1_000_000);
+            var builder = Builder{};
+            const frag = builder.build(p) orelse return null;
+            builder.follow[0] = frag.first;
+            const frozen_bytes = builder.bytes[0..builder.count].*;
+            const frozen_follow = builder.follow[0..builder.count].*;
+            return .{
+                .bytes = &frozen_bytes,
+                .follow = &frozen_follow,
+                .last = frag.last | @as(u64, @intFromBool(frag.nullable)),
+            };
+        }
+    }
+
+    /// Length of the longest prefix of `input[start..]` in the language
+    pub fn longest(comptime self: Glushkov, input: []const u8, start: usize) ?usize {
+        const t = comptime self.tables();
+        var last: ?usize = if (self.last & 1 != 0) 0 else null;
+        if (start >= input.len) return last;
+
+        var live = self.follow[0] & t.masks[input[start]];
+        var pos = start + 1;
+        while (live != 0) {
+            if (live & self.last != 0) last = pos - start;
+            if (pos >= input.len) break;
+            const reach = if (comptime t.linear)
+                ((live & t.step) << 1) | (live & t.loop)
+            else reach: {
+                var reach: u64 = 0;
+                inline for (t.follow_chunks, 0..) |chunk, k| reach |= chunk[@as(u8, @truncate(live >> (8 * k)))];
+                break :reach reach;
+            };
+            live = reach & t.masks[input[pos]];
+            pos += 1;
+        }
+        return last;
+    }
+
+    /// Number of DFA states the automaton determinizes to, counting up to
+    /// `limit + 1`
+    pub fn dfaStates(comptime self: Glushkov, comptime limit: usize) usize {
+        comptime {
+            @setEvalBranchQuota(10_000_000);
+            const t = self.tables();
+            var distinct: []const u64 = &.{};
+            for (t.masks) |mask| {
+                if (std.mem.indexOfScalar(u64, distinct, mask) == null) distinct = distinct ++ &[_]u64{mask};
+            }
+            var states: []const u64 = &.{1};
+            var i = 0;
+            while (i < states.len and states.len <= limit) : (i += 1) {
+                var reach: u64 = 0;
+                for (self.follow, 0..) |follow, position| {
+                    if (states[i] & (@as(u64, 1) << position) != 0) reach |= follow;
+                }
+                for (distinct) |mask| {
+                    const next = reach & mask;
+                    if (next != 0 and std.mem.indexOfScalar(u64, states, next) == null) states = states ++ &[_]u64{next};
+                }
+            }
+            return @min(states.len, limit + 1);
+        }
+    }
+
+    const Tables = struct {
+        /// Positions consuming each byte
+        masks: [256]u64,
+        /// `follow` is `((live & step) << 1) | (live & loop)` after the start
+        linear: bool,
+        step: u64,
+        loop: u64,
+        /// follow_chunks[k][b]: union of `follow` over positions 8k + bits of b
+        follow_chunks: []const [256]u64,
+    };
+
+    fn tables(comptime self: Glushkov) Tables {
+        comptime {
+            @setEvalBranchQuota(10_000_000);
+            var masks = [_]u64{0} ** 256;
+            for (self.bytes[1..], 1..) |bytes, position| {
+                for (&masks, 0..) |*mask, byte| {
+                    if (bytes.contains(byte)) mask.* |= @as(u64, 1) << position;
+                }
+            }
+
+            var linear = true;
+            var step: u64 = 0;
+            var loop: u64 = 0;
+            for (self.follow[1..], 1..) |follow, position| {
+                const self_bit = @as(u64, 1) << position;
+                const next_bit = if (position + 1 < max_positions) self_bit << 1 else 0;
+                if (follow & ~(self_bit | next_bit) != 0) linear = false;
+                if (follow & self_bit != 0) loop |= self_bit;
+                if (follow & next_bit != 0) step |= self_bit;
+            }
+
+            const chunk_count = (self.follow.len + 7) / 8;
+            var chunks: [chunk_count][256]u64 = undefined;
+            for (&chunks, 0..) |*chunk, k| {
+                for (chunk, 0..) |*reach, bits| {
+                    reach.* = 0;
+                    for (0..8) |j| {
+                        const position = 8 * k + j;
+                        if (bits & (1 << j) != 0 and position < self.follow.len) reach.* |= self.follow[position];
+                    }
+                }
+            }
+            const frozen = chunks;
+            return .{ .masks = masks, .linear = linear, .step = step, .loop = loop, .follow_chunks = &frozen };
+        }
+    }
+};
+
+/// Positions as fragments: the positions a fragment can start and end on,
+/// and whether it matches the empty string. Positions are numbered left to
+/// right, so concatenation mostly links a position to the next one.
+const Builder = struct {
+    bytes: [Glushkov.max_positions]ByteSet = undefined,
+    follow: [Glushkov.max_positions]u64 = [_]u64{0} ** Glushkov.max_positions,
+    count: usize = 1,
+
+    const Frag = struct {
+        first: u64 = 0,
+        last: u64 = 0,
+        nullable: bool,
+    };
+
+    fn build(self: *Builder, p: Pattern) ?Frag {
+        if (nfa.singleByteSet(p)) |bytes| return self.position(bytes);
+
+        switch (p) {
+            .literal => |lit| {
+                var frag = Frag{ .nullable = true };
+                for (lit) |c| frag = self.concat(frag, self.position(ByteSet.of(&[_]u8{c})) orelse return null);
+                return frag;
+            },
+            .sequence => |seq| {
+                var frag = Frag{ .nullable = true };
+                for (seq) |sub| frag = self.concat(frag, self.build(sub) orelse return null);
+                return frag;
+            },
+            .alternation => |alternatives| {
+                var frag = Frag{ .nullable = false };
+                for (alternatives) |alternative| {
+                    const sub = self.build(alternative) orelse return null;
+                    frag = .{ .first = frag.first | sub.first, .last = frag.last | sub.last, .nullable = frag.nullable or sub.nullable };
+                }
+                return frag;
+            },
+            .one_or_more, .zero_or_more => |sub| {
+                const body = self.build(sub.*) orelse return null;
+                self.link(body.last, body.first);
+                return .{ .first = body.first, .last = body.last, .nullable = body.nullable or p == .zero_or_more };
+            },
+            .optional_pattern => |sub| {
+                const body = self.build(sub.*) orelse return null;
+                return .{ .first = body.first, .last = body.last, .nullable = true };
+            },
+            .until => |delimiter| {
+                const stop = nfa.singleByteSet(delimiter.*) orelse return null;
+                const body = self.position(stop.negate()) orelse return null;
+                self.link(body.last, body.first);
+                return .{ .first = body.first, .last = body.last, .nullable = true };
+            },
+            .keyword_ident => |ki| return self.build(ki.ident),
+            // Single-byte patterns were handled above
+            .char_class, .range, .any_of, .byte_set, .any => unreachable,
+        }
+    }
+
+    fn position(self: *Builder, bytes: ByteSet) ?Frag {
+        if (self.count == Glushkov.max_positions) return null;
+        self.bytes[self.count] = bytes;
+        const bit = @as(u64, 1) << self.count;
+        self.count += 1;
+        return .{ .first = bit, .last = bit, .nullable = false };
+    }
+
+    fn concat(self: *Builder, a: Frag, b: Frag) Frag {
+        self.link(a.last, b.first);
+        return .{
+            .first = a.first | (if (a.nullable) b.first else 0),
+            .last = b.last | (if (b.nullable) a.last else 0),
+            .nullable = a.nullable and b.nullable,
+        };
+    }
+
+    /// Lets every position in `from` continue to those in `to`
+    fn link(self: *Builder, from: u64, to: u64) void {
+        for (1..self.count) |position| {
+            if (from & (@as(u64, 1) << position) != 0) self.follow[position] |= to;
+        }
+    }
+};
+
+test "glushkov matches like the DFA" {
+    const m = pattern.match;
+    const Dfa = @import("dfa_generator.zig").Dfa;
+    const patterns = comptime [_]Pattern{
+        m.regex("[ab]*a[ab]{3}"),
+        m.regex("(ab|c)*d"),
+        m.regex("x?(yz)+"),
+        m.regex("[^;]*;"),
+    };
+    const input = "abaabbcababcdxyzyzyyz;aab;";
+    inline for (patterns) |p| {
+        const g = comptime Glushkov.fromPattern(p).?;
+        const dfa = comptime Dfa.build(nfa.Nfa.fromPattern(p));
+        for (0..input.len + 1) |start| {
+            const expected = if (dfa.longestTable(input, start)) |found| found.len else null;
+            try std.testing.expectEqual(expected, g.longest(input, start));
+        }
+    }
+    try std.testing.expect((comptime Glushkov.fromPattern(patterns[0]).?.tables()).linear);
+    try std.testing.expect(!(comptime Glushkov.fromPattern(patterns[1]).?.tables()).linear);
+}
+
+test "glushkov sizes" {
+    const m = pattern.match;
+    const g = comptime Glushkov.fromPattern(m.regex("[ab]*a[ab]{8}")).?;
+    try std.testing.expectEqual(@as(usize, 11), g.follow.len);
+    try std.testing.expectEqual(@as(usize, 101), comptime g.dfaStates(100));
+    try std.testing.expect(comptime Glushkov.fromPattern(m.regex("a{64}")) == null);
+}
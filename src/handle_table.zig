@@ -0,0 +1,309 @@
+const std = @import("std");
+
+/// Lock-free table mapping opaque 64-bit handles to objects.
+///
+/// A handle is `generation << 32 | (index + 1)`, so it is never zero and a
+/// stale handle to a reused slot is rejected by its generation. Lookups are
+/// wait-free: they pin the slot with one atomic add on a word that packs the
+/// generation, a live bit and the pin count, so the pin and the validity check
+/// happen in the same step. Removal bumps the generation, waits until in-flight
+/// pins have drained and only then hands the object back for destruction.
+/// Free slots are recycled through a Treiber stack with an ABA tag; slot memory
+/// lives in segments that are never freed before `deinit`.
+///
+/// `toAddress`/`fromAddress` pack a handle into a pointer-sized integer for
+/// APIs that hand handles out as pointers. On 32-bit targets the generation
+/// is narrowed to fit next to the slot number, so it wraps sooner there.
+pub fn HandleTable(comptime T: type) type {
+    return struct {
+        const Self = @This();
+
+        pub const segment_size = 1024;
+        pub const max_segments = 1024;
+
+        // Slot state word: generation (32) | live (1) | pins (31)
+        const live_bit: u64 = 1 << 31;
+        const pin_mask: u64 = live_bit - 1;
+        const gen_shift = 32;
+
+        /// Bits of index + 1 in a packed address
+        const index_bits = std.math.log2_int_ceil(u64, segment_size * max_segments + 1);
+        /// Generations wrap at this width so that handles fit in a pointer
+        pub const generation_bits = @min(32, @bitSizeOf(usize) - index_bits);
+        const gen_mask: u64 = (1 << generation_bits) - 1;
+
+        const Slot = struct {
+            state: std.atomic.Value(u64),
+            value: ?*T,
+            /// index + 1 of the next free slot, 0 = end of list
+            next_free: std.atomic.Value(u32),
+        };
+
+        const Segment = [segment_size]Slot;
+
+        allocator: std.mem.Allocator,
+        segments: [max_segments]std.atomic.Value(?*Segment),
+        /// Number of slot indices handed out so far
+        next_index: std.atomic.Value(u32),
+        /// ABA tag (32) | index + 1 of the first free slot (32)
+        free_head: std.atomic.Value(u64),
+
+        /// Keeps the object alive until released; obtained from `acquire`
+        pub const Pin = struct {
+            slot: *Slot,
+            value: *T,
+
+            pub fn release(self: Pin) void {
+                _ = self.slot.state.fetchSub(1, .release);
+            }
+        };
+
+        pub fn init(allocator: std.mem.Allocator) Self {
+            return .{
+                .allocator = allocator,
+                .segments = [_]std.atomic.Value(?*Segment){std.atomic.Value(?*Segment).init(null)} ** max_segments,
+                .next_index = std.atomic.Value(u32).init(0),
+                .free_head = std.atomic.Value(u64).init(0),
+            };
+        }
+
+        /// Frees slot memory. Not thread-safe; remaining live objects are
+        /// passed to `destroy_value` if given.
+        pub fn deinit(self: *Self, destroy_value: ?*const fn (*T) void) void {
+            const used = self.next_index.load(.acquire);
+            for (&self.segments, 0..) |*segment_ptr, seg| {
+                const segment = segment_ptr.load(.acquire) orelse continue;
+                if (destroy_value) |destroy| {
+                    for (segment, 0..) |*slot, off| {
+                        if (seg * segment_size + off >= used) break;
+                        if (slot.state.load(.acquire) & live_bit == 0) continue;
+                        if (slot.value) |value| destroy(value);
+                    }
+                }
+                self.allocator.destroy(segment);
+                segment_ptr.store(null, .release);
+            }
+            self.next_index.store(0, .release);
+            self.free_head.store(0, .release);
+        }
+
+        /// Registers `value` and returns its handle
+        pub fn insert(self: *Self, value: *T) !u64 {
+            const index = try self.allocIndex();
+            const slot = self.slotAt(index);
+            slot.value = value;
+            // Publish: the value store happens-before any successful acquire
+            const prev = slot.state.fetchOr(live_bit, .release);
+            const generation: u32 = @truncate(prev >> gen_shift);
+            return (@as(u64, generation) << gen_shift) | (@as(u64, index) + 1);
+        }
+
+        /// Pins the object behind `handle`, or returns null for an invalid or stale handle
+        pub fn acquire(self: *Self, handle: u64) ?Pin {
+            const slot = self.lookupSlot(handle) orelse return null;
+            const expected = handle >> gen_shift;
+
+            const prev = slot.state.fetchAdd(1, .acquire);
+            if (prev >> gen_shift != expected or prev & live_bit == 0) {
+                _ = slot.state.fetchSub(1, .release);
+                return null;
+            }
+            return .{ .slot = slot, .value = slot.value.? };
+        }
+
+        /// Invalidates `handle` and returns its object once no thread holds a
+        /// pin on it; the caller then owns the object. Null if already removed.
+        /// Never call it while holding a pin on the same handle: it would wait
+        /// for that pin forever.
+        pub fn remove(self: *Self, handle: u64) ?*T {
+            const slot = self.lookupSlot(handle) orelse return null;
+            const expected = handle >> gen_shift;
+
+            var state = slot.state.load(.acquire);
+            while (true) {
+                if (state >> gen_shift != expected or state & live_bit == 0) return null;
+                // Next generation, not live, pins kept
+                const retired = ((expected +% 1) & gen_mask) << gen_shift | (state & pin_mask);
+                state = slot.state.cmpxchgWeak(state, retired, .acq_rel, .acquire) orelse break;
+            }
+
+            // Wait for in-flight users; new acquires fail the generation check
+            var spins: u32 = 0;
+            while (slot.state.load(.acquire) & pin_mask != 0) {
+                if (spins < 128) {
+                    spins += 1;
+                    std.atomic.spinLoopHint();
+                } else {
+                    std.Thread.yield() catch {};
+                }
+            }
+
+            const value = slot.value.?;
+            slot.value = null;
+            self.pushFree(@intCast((handle & 0xFFFF_FFFF) - 1));
+            return value;
+        }
+
+        /// Packs `handle` into a pointer-sized integer, never zero
+        pub fn toAddress(handle: u64) usize {
+            return @intCast((handle >> gen_shift) << index_bits | (handle & 0xFFFF_FFFF));
+        }
+
+        /// Inverse of `toAddress`; garbage addresses give handles `acquire` rejects
+        pub fn fromAddress(address: usize) u64 {
+            const packed_handle: u64 = address;
+            return (packed_handle >> index_bits) << gen_shift | (packed_handle & ((1 << index_bits) - 1));
+        }
+
+        fn lookupSlot(self: *Self, handle: u64) ?*Slot {
+            const low: u32 = @truncate(handle);
+            if (low == 0) return null;
+            const index = low - 1;
+            if (index >= self.next_index.load(.acquire)) return null;
+            const segment = self.segments[index / segment_size].load(.acquire) orelse return null;
+            return &segment[index % segment_size];
+        }
+
+        fn slotAt(self: *Self, index: u32) *Slot {
+            const segment = self.segments[index / segment_size].load(.acquire).?;
+            return &segment[index % segment_size];
+        }
+
+        fn allocIndex(self: *Self) !u32 {
+            if (self.popFree()) |index| return index;
+
+            const index = self.next_index.load(.monotonic);
+            if (index >= segment_size * max_segments) return error.OutOfHandles;
+            try self.ensureSegment(index / segment_size);
+            // Claim the index only after its segment exists, so lookups never see
+            // an index without memory behind it
+            var current = index;
+            while (true) {
+                current = self.next_index.cmpxchgWeak(current, current + 1, .acq_rel, .monotonic) orelse return current;
+                if (current >= segment_size * max_segments) return error.OutOfHandles;
+                try self.ensureSegment(current / segment_size);
+            }
+        }
+
+        fn ensureSegment(self: *Self, seg: usize) !void {
+            if (self.segments[seg].load(.acquire) != null) return;
+
+            const segment = try self.allocator.create(Segment);
+            for (segment) |*slot| {
+                slot.* = .{
+                    .state = std.atomic.Value(u64).init(0),
+                    .value = null,
+                    .next_free = std.atomic.Value(u32).init(0),
+                };
+            }
+            if (self.segments[seg].cmpxchgStrong(null, segment, .acq_rel, .acquire) != null) {
+                self.allocator.destroy(segment); // Another thread published it first
+            }
+        }
+
+        fn popFree(self: *Self) ?u32 {
+            var head = self.free_head.load(.acquire);
+            while (true) {
+                const first: u32 = @truncate(head);
+                if (first == 0) return null;
+                const next = self.slotAt(first - 1).next_free.load(.monotonic);
+                const tag = (head >> 32) +% 1;
+                head = self.free_head.cmpxchgWeak(head, tag << 32 | next, .acq_rel, .acquire) orelse return first - 1;
+            }
+        }
+
+        fn pushFree(self: *Self, index: u32) void {
+            const slot = self.slotAt(index);
+            var head = self.free_head.load(.monotonic);
+            while (true) {
+                slot.next_free.store(@truncate(head), .monotonic);
+                const tag = (head >> 32) +% 1;
+                head = self.free_head.cmpxchgWeak(head, tag << 32 | (@as(u64, index) + 1), .release, .monotonic) orelse return;
+            }
+        }
+    };
+}
+
+test "handle table rejects stale handles after slot reuse" {
+    var table = HandleTable(u32).init(std.testing.allocator);
+    defer table.deinit(null);
+
+    var a: u32 = 1;
+    var b: u32 = 2;
+
+    const ha = try table.insert(&a);
+    const pin = table.acquire(ha).?;
+    try std.testing.expectEqual(@as(u32, 1), pin.value.*);
+    pin.release();
+
+    try std.testing.expectEqual(&a, table.remove(ha).?);
+    try std.testing.expect(table.remove(ha) == null);
+    try std.testing.expect(table.acquire(ha) == null);
+
+    // Same slot, new generation
+    const hb = try table.insert(&b);
+    try std.testing.expectEqual(ha & 0xFFFF_FFFF, hb & 0xFFFF_FFFF);
+    try std.testing.expect(ha != hb);
+    try std.testing.expect(table.acquire(ha) == null);
+    table.acquire(hb).?.release();
+    try std.testing.expect(table.acquire(0) == null);
+}
+
+test "handle table handles survive packing into an address" {
+    const Table = HandleTable(u32);
+    var table = Table.init(std.testing.allocator);
+    defer table.deinit(null);
+
+    var value: u32 = 0;
+    // Cycle one slot through many generations
+    for (0..4096) |_| {
+        const handle = try table.insert(&value);
+        try std.testing.expect(handle >> 32 < @as(u64, 1) << Table.generation_bits);
+        const address = Table.toAddress(handle);
+        try std.testing.expect(address != 0);
+        try std.testing.expectEqual(handle, Table.fromAddress(address));
+        table.acquire(Table.fromAddress(address)).?.release();
+        try std.testing.expectEqual(&value, table.remove(handle).?);
+    }
+}
+
+test "handle table concurrent insert, lookup and remove" {
+    const Table = HandleTable(u64);
+    var table = Table.init(std.testing.allocator);
+    defer table.deinit(null);
+
+    const Worker = struct {
+        fn run(t: *Table, seed: u64, failures: *std.atomic.Value(u32)) void {
+            check(t, seed) catch {
+                _ = failures.fetchAdd(1, .monotonic);
+            };
+        }
+
+        fn check(t: *Table, seed: u64) !void {
+            var values: [64]u64 = undefined;
+            var handles: [64]u64 = undefined;
+            for (0..200) |round| {
+                for (&values, &handles, 0..) |*value, *handle, i| {
+                    value.* = seed * 1_000_000 + round * 64 + i;
+                    handle.* = try t.insert(value);
+                }
+                for (values, handles) |value, handle| {
+                    const pin = t.acquire(handle) orelse return error.LostHandle;
+                    defer pin.release();
+                    if (pin.value.* != value) return error.WrongValue;
+                }
+                for (&values, handles) |*value, handle| {
+                    if (t.remove(handle) != value) return error.WrongValue;
+                }
+            }
+        }
+    };
+
+    var failures = std.atomic.Value(u32).init(0);
+    var threads: [4]std.Thread = undefined;
+    for (&threads, 0..) |*thread, i| {
+        thread.* = try std.Thread.spawn(.{}, Worker.run, .{ &table, i, &failures });
+    }
+    for (threads) |thread| thread.join();
+    try std.testing.expectEqual(@as(u32, 0), failures.load(.monotonic));
+}
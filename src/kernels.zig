@@ -0,0 +1,23 @@
+// Root of the per-tier kernel objects. build.zig compiles this file once per
+// x86 ISA tier, with that tier's CPU features, and links the objects next to
+// the library. Each one exports the `simd.Kernels` entries at the tier's
+// vector width as `zp_kernels_<tier>_<entry>`; `simd.kernels()` picks the
+// best tier the CPU runs when the process first needs a kernel.
+
+const simd_module = @import("simd.zig");
+const IsaLevel = @import("cpu_features.zig").IsaLevel;
+const options = @import("kernel_options");
+
+const level = @field(IsaLevel, options.tier);
+const width = switch (level) {
+    .baseline, .sse42 => 16,
+    .avx2 => 32,
+    .avx512bw => 64,
+};
+
+comptime {
+    const table = simd_module.KernelEntryPoints(width).table(level);
+    for (@typeInfo(simd_module.simd.Kernels).@"struct".fields[1..]) |field| {
+        @export(@field(table, field.name), .{ .name = simd_module.kernelSymbol(level, field.name) });
+    }
+}
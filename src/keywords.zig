@@ -0,0 +1,100 @@
+const std = @import("std");
+
+/// Comptime perfect hash over a keyword list, for reclassifying an
+/// identifier once its span is known: one hash of the length and a few bytes,
+/// one table load and one compare, however many keywords there are.
+///
+/// The hash key packs the length with the first two, middle and last two
+/// bytes; a multiplier is searched at comptime until no two keywords share a
+/// slot. Keywords that agree on all of those bytes and the length cannot be
+/// separated and are rejected at compile time.
+pub fn KeywordSet(comptime keywords: []const []const u8) type {
+    if (keywords.len == 0 or keywords.len > 255) @compileError("KeywordSet needs 1 to 255 keywords");
+
+    return struct {
+        const empty: u8 = 0xFF;
+
+        const min_len = blk: {
+            var len: usize = std.math.maxInt(usize);
+            for (keywords) |kw| len = @min(len, kw.len);
+            break :blk len;
+        };
+        const max_len = blk: {
+            var len: usize = 0;
+            for (keywords) |kw| len = @max(len, kw.len);
+            break :blk len;
+        };
+
+        const Table = struct {
+            multiplier: u64,
+            bits: u6,
+            slots: []const u8,
+        };
+
+        const table: Table = build();
+
+        fn build() Table {
+            @setEvalBranchQuota(10_000_000);
+            for (keywords) |kw| {
+                if (kw.len == 0) @compileError("KeywordSet keywords must not be empty");
+            }
+            const min_bits = @max(1, std.math.log2_int_ceil(usize, keywords.len));
+            for (min_bits..min_bits + 4) |bits| {
+                var seed: u64 = 0x9E3779B97F4A7C15;
+                for (0..2000) |_| {
+                    seed = seed *% 6364136223846793005 +% 1442695040888963407;
+                    const multiplier = seed | 1;
+                    var slots = [_]u8{empty} ** (1 << bits);
+                    const ok = for (keywords, 0..) |kw, i| {
+                        const slot = hashKey(key(kw), multiplier, bits);
+                        if (slots[slot] != empty) break false;
+                        slots[slot] = i;
+                    } else true;
+                    if (ok) {
+                        const frozen = slots;
+                        return .{ .multiplier = multiplier, .bits = bits, .slots = &frozen };
+                    }
+                }
+            }
+            @compileError("KeywordSet: no perfect hash found; keywords differ only in bytes the hash does not read");
+        }
+
+        inline fn key(text: []const u8) u64 {
+            const len = text.len;
+            return @as(u64, @intCast(len)) |
+                @as(u64, text[0]) << 8 |
+                @as(u64, text[@min(1, len - 1)]) << 16 |
+                @as(u64, text[len / 2]) << 24 |
+                @as(u64, text[len - @min(2, len)]) << 32 |
+                @as(u64, text[len - 1]) << 40;
+        }
+
+        inline fn hashKey(k: u64, multiplier: u64, bits: u6) usize {
+            return @intCast((k *% multiplier) >> @intCast(@as(u7, 64) - bits));
+        }
+
+        /// Index of `text` in the keyword list, or null for other identifiers
+        pub fn lookup(text: []const u8) ?usize {
+            if (text.len < min_len or text.len > max_len) return null;
+            const index = table.slots[hashKey(key(text), table.multiplier, table.bits)];
+            if (index == empty or !std.mem.eql(u8, keywords[index], text)) return null;
+            return index;
+        }
+    };
+}
+
+test "keyword set classifies keywords and rejects other identifiers" {
+    const sql = [_][]const u8{
+        "select", "from", "where", "group", "by", "order", "having", "limit",
+        "insert", "into", "values", "update", "set", "delete", "join", "left",
+        "right", "inner", "outer", "on", "as", "and", "or", "not", "null", "is",
+        "in", "like", "between", "distinct", "union", "all", "case", "when",
+        "then", "else", "end", "create", "table", "drop",
+    };
+    const Keywords = KeywordSet(&sql);
+
+    for (sql, 0..) |kw, i| try std.testing.expectEqual(@as(?usize, i), Keywords.lookup(kw));
+    for ([_][]const u8{ "selects", "fro", "x", "orders", "ends", "inn", "tables", "where_", "Select" }) |ident| {
+        try std.testing.expectEqual(@as(?usize, null), Keywords.lookup(ident));
+    }
+}
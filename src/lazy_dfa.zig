@@ -0,0 +1,390 @@
+const std = @import("std");
+const Allocator = std.mem.Allocator;
+const Pattern = @import("pattern.zig").Pattern;
+const Nfa = @import("nfa.zig").Nfa;
+const regex = @import("regex.zig");
+const Accept = @import("dfa_generator.zig").Dfa.Accept;
+
+/// DFA for patterns known only at runtime, determinized on demand.
+///
+/// Comptime grammars get their whole DFA built by `Dfa.build`; a runtime
+/// grammar could blow up exponentially that way. Here a DFA state is made
+/// the first time a search reaches it and kept in a bounded cache, so a
+/// search costs one table load per byte once its states are cached. A full
+/// cache is cleared and refilled. When a search keeps clearing the cache
+/// without getting many bytes out of each state, the states are not being
+/// reused and it finishes by simulating the NFA instead.
+///
+/// Searches update the cache, so one LazyDfa must not be searched from
+/// several threads at once.
+pub const LazyDfa = struct {
+    pub const Options = struct {
+        /// Most DFA states cached at once
+        cache_states: u32 = 512,
+        /// Cache clears a search tolerates before it may fall back
+        max_clears: u32 = 3,
+        /// Fall back when fewer bytes than this were scanned per state
+        /// built since the last clear
+        min_bytes_per_state: usize = 10,
+    };
+
+    pub const Error = Allocator.Error || Nfa.Error || regex.Error;
+
+    const unknown: u32 = std.math.maxInt(u32) - 1;
+    const dead: u32 = std.math.maxInt(u32);
+
+    allocator: Allocator,
+    /// Owns the NFA, and the patterns when parsed from regexes
+    arena: std.heap.ArenaAllocator,
+    nfa: Nfa,
+    classes: Nfa.ByteClasses,
+    options: Options,
+    /// Words per NFA state set
+    words: usize,
+
+    /// State set of each cached state, `words` words each
+    sets: std.ArrayListUnmanaged(u64) = .{},
+    accepts: std.ArrayListUnmanaged(?u32) = .{},
+    /// `classes.count` transitions per cached state: a state, `unknown`
+    /// until computed, or `dead`
+    transitions: std.ArrayListUnmanaged(u32) = .{},
+    index: std.HashMapUnmanaged(u32, void, SetContext, std.hash_map.default_max_load_percentage) = .{},
+    start_state: ?u32 = null,
+    /// Cache clears so far, for statistics and the fallback heuristic
+    clears: u64 = 0,
+
+    /// Scratch state sets and closure stack
+    current: []u64,
+    next_set: []u64,
+    stack: []u32,
+
+    /// Engine for `patterns[i]` accepted as pattern i. The patterns must
+    /// outlive the engine unless they live in its arena.
+    pub fn init(allocator: Allocator, patterns: []const Pattern, options: Options) Error!LazyDfa {
+        var arena = std.heap.ArenaAllocator.init(allocator);
+        errdefer arena.deinit();
+        return initIn(allocator, &arena, try Nfa.init(arena.allocator(), patterns), options);
+    }
+
+    /// Engine for regexes (see `regex.parse`), e.g. from a C caller;
+    /// `diagnostic` receives the source index and position of a syntax error
+    pub fn initRegex(
+        allocator: Allocator,
+        sources: []const []const u8,
+        options: Options,
+        diagnostic: ?*regex.Diagnostic,
+    ) Error!LazyDfa {
+        var arena = std.heap.ArenaAllocator.init(allocator);
+        errdefer arena.deinit();
+        const patterns = try arena.allocator().alloc(Pattern, sources.len);
+        for (patterns, sources, 0..) |*p, source, i| {
+            p.* = regex.parseAlloc(arena.allocator(), source, diagnostic) catch |err| {
+                if (diagnostic) |d| d.source = i;
+                return err;
+            };
+        }
+        return initIn(allocator, &arena, try Nfa.init(arena.allocator(), patterns), options);
+    }
+
+    /// Takes over `arena` once every allocation has succeeded
+    fn initIn(allocator: Allocator, arena: *std.heap.ArenaAllocator, nfa: Nfa, options: Options) Error!LazyDfa {
+        const words = (nfa.states.len + 63) / 64;
+        const current = try arena.allocator().alloc(u64, words);
+        const next_set = try arena.allocator().alloc(u64, words);
+        const stack = try arena.allocator().alloc(u32, nfa.states.len);
+        return .{
+            .allocator = allocator,
+            .arena = arena.*,
+            .nfa = nfa,
+            .classes = nfa.byteClasses(),
+            .options = .{
+                .cache_states = @max(options.cache_states, 2),
+                .max_clears = options.max_clears,
+                .min_bytes_per_state = options.min_bytes_per_state,
+            },
+            .words = words,
+            .current = current,
+            .next_set = next_set,
+            .stack = stack,
+        };
+    }
+
+    pub fn deinit(self: *LazyDfa) void {
+        self.sets.deinit(self.allocator);
+        self.accepts.deinit(self.allocator);
+        self.transitions.deinit(self.allocator);
+        self.index.deinit(self.allocator);
+        self.arena.deinit();
+    }
+
+    /// Number of DFA states currently cached
+    pub fn cachedStates(self: *const LazyDfa) usize {
+        return self.accepts.items.len;
+    }
+
+    /// Longest prefix of `input[start..]` matched by some pattern, and the
+    /// lowest-numbered pattern matching that much
+    pub fn longest(self: *LazyDfa, input: []const u8, start: usize) Allocator.Error!?Accept {
+        var state = try self.startState();
+        var last: ?Accept = if (self.accepts.items[state]) |id| .{ .pattern = id, .len = 0 } else null;
+        var search_clears: u32 = 0;
+        var since_clear = start;
+        var pos = start;
+        while (pos < input.len) {
+            const class = self.classes.of[input[pos]];
+            var target = self.transitions.items[state * self.classes.count + class];
+            if (target == unknown) {
+                const clears = self.clears;
+                target = try self.computeTransition(state, class);
+                if (self.clears != clears) {
+                    search_clears += 1;
+                    const scanned = pos - since_clear;
+                    since_clear = pos;
+                    if (search_clears > self.options.max_clears and
+                        scanned < self.options.min_bytes_per_state * self.options.cache_states)
+                    {
+                        return self.simulate(input, start);
+                    }
+                }
+            }
+            if (target == dead) break;
+            state = target;
+            pos += 1;
+            if (self.accepts.items[state]) |id| last = .{ .pattern = id, .len = pos - start };
+        }
+        return last;
+    }
+
+    /// `longest` by NFA simulation, without the cache
+    pub fn simulate(self: *LazyDfa, input: []const u8, start: usize) ?Accept {
+        @memset(self.current, 0);
+        setBit(self.current, self.nfa.start);
+        self.closure(self.current);
+        var last: ?Accept = if (self.acceptOf(self.current)) |id| .{ .pattern = id, .len = 0 } else null;
+        var pos = start;
+        while (pos < input.len) {
+            if (!self.move(self.current, input[pos], self.next_set)) break;
+            std.mem.swap([]u64, &self.current, &self.next_set);
+            pos += 1;
+            if (self.acceptOf(self.current)) |id| last = .{ .pattern = id, .len = pos - start };
+        }
+        return last;
+    }
+
+    fn startState(self: *LazyDfa) Allocator.Error!u32 {
+        if (self.start_state) |state| return state;
+        @memset(self.current, 0);
+        setBit(self.current, self.nfa.start);
+        self.closure(self.current);
+        const state = try self.intern(self.current);
+        self.start_state = state;
+        return state;
+    }
+
+    fn computeTransition(self: *LazyDfa, state: u32, class: u8) Allocator.Error!u32 {
+        @memcpy(self.current, self.setOf(state));
+        if (!self.move(self.current, self.classes.representative[class], self.next_set)) {
+            self.transitions.items[state * self.classes.count + class] = dead;
+            return dead;
+        }
+        const clears = self.clears;
+        const target = try self.intern(self.next_set);
+        // A clear dropped `state`; the search continues from `target` alone
+        if (self.clears == clears) self.transitions.items[state * self.classes.count + class] = target;
+        return target;
+    }
+
+    /// Cached state for the closed set `set`, built if new
+    fn intern(self: *LazyDfa, set: []const u64) Allocator.Error!u32 {
+        if (self.index.getKeyAdapted(set, SetAdapter{ .dfa = self })) |state| return state;
+        if (self.cachedStates() >= self.options.cache_states) self.clearCache();
+
+        // Reserve first: a failure halfway would leave the tables out of step
+        const context = SetContext{ .dfa = self };
+        try self.sets.ensureUnusedCapacity(self.allocator, set.len);
+        try self.accepts.ensureUnusedCapacity(self.allocator, 1);
+        try self.transitions.ensureUnusedCapacity(self.allocator, self.classes.count);
+        try self.index.ensureUnusedCapacityContext(self.allocator, 1, context);
+
+        const state: u32 = @intCast(self.cachedStates());
+        self.sets.appendSliceAssumeCapacity(set);
+        self.accepts.appendAssumeCapacity(self.acceptOf(set));
+        self.transitions.appendNTimesAssumeCapacity(unknown, self.classes.count);
+        self.index.putAssumeCapacityNoClobberContext(state, {}, context);
+        return state;
+    }
+
+    fn clearCache(self: *LazyDfa) void {
+        self.sets.clearRetainingCapacity();
+        self.accepts.clearRetainingCapacity();
+        self.transitions.clearRetainingCapacity();
+        self.index.clearRetainingCapacity();
+        self.start_state = null;
+        self.clears += 1;
+    }
+
+    fn setOf(self: *const LazyDfa, state: u32) []const u64 {
+        return self.sets.items[state * self.words ..][0..self.words];
+    }
+
+    /// `to` = closure of the states `from` reaches on `byte`; false if none
+    fn move(self: *LazyDfa, from: []const u64, byte: u8, to: []u64) bool {
+        @memset(to, 0);
+        var any = false;
+        for (from, 0..) |word, w| {
+            var bits = word;
+            while (bits != 0) : (bits &= bits - 1) {
+                const s = w * 64 + @ctz(bits);
+                for (self.nfa.states[s].edges) |edge| {
+                    if (edge.bytes.contains(byte)) {
+                        setBit(to, edge.to);
+                        any = true;
+                    }
+                }
+            }
+        }
+        if (any) self.closure(to);
+        return any;
+    }
+
+    /// Adds every state reachable from `set` by epsilon moves
+    fn closure(self: *LazyDfa, set: []u64) void {
+        var top: usize = 0;
+        for (set, 0..) |word, w| {
+            var bits = word;
+            while (bits != 0) : (bits &= bits - 1) {
+                self.stack[top] = @intCast(w * 64 + @ctz(bits));
+                top += 1;
+            }
+        }
+        while (top > 0) {
+            top -= 1;
+            for (self.nfa.states[self.stack[top]].eps) |to| {
+                if (isSet(set, to)) continue;
+                setBit(set, to);
+                self.stack[top] = to;
+                top += 1;
+            }
+        }
+    }
+
+    fn acceptOf(self: *const LazyDfa, set: []const u64) ?u32 {
+        var accept: ?u32 = null;
+        for (set, 0..) |word, w| {
+            var bits = word;
+            while (bits != 0) : (bits &= bits - 1) {
+                if (self.nfa.states[w * 64 + @ctz(bits)].accept) |id| accept = @min(accept orelse id, id);
+            }
+        }
+        return accept;
+    }
+
+    fn setBit(set: []u64, state: u32) void {
+        set[state / 64] |= @as(u64, 1) << @intCast(state % 64);
+    }
+
+    fn isSet(set: []const u64, state: u32) bool {
+        return set[state / 64] & (@as(u64, 1) << @intCast(state % 64)) != 0;
+    }
+
+    /// Hashes cached states by their NFA state sets
+    const SetContext = struct {
+        dfa: *const LazyDfa,
+
+        pub fn hash(ctx: SetContext, state: u32) u64 {
+            return hashSet(ctx.dfa.setOf(state));
+        }
+
+        pub fn eql(ctx: SetContext, a: u32, b: u32) bool {
+            return std.mem.eql(u64, ctx.dfa.setOf(a), ctx.dfa.setOf(b));
+        }
+    };
+
+    /// Looks cached states up by a set not yet in the cache
+    const SetAdapter = struct {
+        dfa: *const LazyDfa,
+
+        pub fn hash(_: SetAdapter, set: []const u64) u64 {
+            return hashSet(set);
+        }
+
+        pub fn eql(ctx: SetAdapter, set: []const u64, state: u32) bool {
+            return std.mem.eql(u64, set, ctx.dfa.setOf(state));
+        }
+    };
+
+    fn hashSet(set: []const u64) u64 {
+        return std.hash.Wyhash.hash(0, std.mem.sliceAsBytes(set));
+    }
+};
+
+test "lazy DFA agrees with the comptime DFA" {
+    const match = @import("pattern.zig").match;
+    const Dfa = @import("dfa_generator.zig").Dfa;
+    const patterns = comptime [_]Pattern{
+        match.regex("0x[0-9a-f]+|\\d+(\\.\\d+)?"),
+        match.regex("[A-Za-z_]\\w*"),
+        match.regex("\"([^\"\\\\]|\\\\.)*\""),
+        match.regex("\\s+"),
+        match.literal("=="),
+        match.anyOf("=+-*/();"),
+    };
+    const dfa = comptime Dfa.build(Nfa.fromPatterns(&patterns));
+
+    var lazy = try LazyDfa.init(std.testing.allocator, &patterns, .{});
+    defer lazy.deinit();
+
+    const input = "x1 == 0x1f + 3.25*(\"a\\\"b\" - y_2);";
+    for (0..input.len) |start| {
+        const expected = dfa.longest(input, start);
+        try std.testing.expectEqual(expected, try lazy.longest(input, start));
+        try std.testing.expectEqual(expected, lazy.simulate(input, start));
+    }
+}
+
+test "lazy DFA stays consistent when adding a state runs out of memory" {
+    const input = "abaabbbaababababbbaaab";
+    for (0..32) |k| {
+        var failing = std.testing.FailingAllocator.init(std.testing.allocator, .{});
+        var lazy = try LazyDfa.initRegex(failing.allocator(), &.{"[ab]*a[ab]{3}"}, .{}, null);
+        defer lazy.deinit();
+
+        failing.fail_index = failing.alloc_index + k;
+        var failed = false;
+        for (0..input.len) |start| {
+            _ = lazy.longest(input, start) catch {
+                failed = true;
+                break;
+            };
+        }
+        try std.testing.expectEqual(lazy.cachedStates() * lazy.words, lazy.sets.items.len);
+        try std.testing.expectEqual(lazy.cachedStates() * lazy.classes.count, lazy.transitions.items.len);
+        try std.testing.expectEqual(lazy.cachedStates(), lazy.index.count());
+
+        failing.fail_index = std.math.maxInt(usize);
+        for (0..input.len) |start| {
+            try std.testing.expectEqual(lazy.simulate(input, start), try lazy.longest(input, start));
+        }
+        if (!failed) break;
+    }
+}
+
+test "lazy DFA keeps working through cache clears" {
+    // (a|b)*a(a|b){8}: the DFA needs 2^9 states, far more than the cache
+    var lazy = try LazyDfa.initRegex(std.testing.allocator, &.{"[ab]*a[ab]{8}"}, .{ .cache_states = 16, .max_clears = 1_000_000 }, null);
+    defer lazy.deinit();
+
+    var input: [400]u8 = undefined;
+    var prng = std.Random.DefaultPrng.init(5);
+    for (&input) |*c| c.* = if (prng.random().boolean()) 'a' else 'b';
+
+    for (0..input.len) |start| {
+        try std.testing.expectEqual(lazy.simulate(&input, start), try lazy.longest(&input, start));
+    }
+    try std.testing.expect(lazy.clears > 0);
+    try std.testing.expect(lazy.cachedStates() <= 16);
+
+    var diagnostic = @import("regex.zig").Diagnostic{};
+    try std.testing.expectError(error.InvalidRegex, LazyDfa.initRegex(std.testing.allocator, &.{ "ab", "a|(" }, .{}, &diagnostic));
+    try std.testing.expectEqual(@as(usize, 1), diagnostic.source);
+}
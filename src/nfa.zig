@@ -0,0 +1,269 @@
+const std = @import("std");
+const char_class = @import("char_class.zig");
+const pattern = @import("pattern.zig");
+
+const Pattern = pattern.Pattern;
+const ByteSet = char_class.ByteSet;
+
+/// Thompson NFA over bytes, built from Patterns at comptime or, for grammars
+/// that arrive at runtime, into an arena. Each state moves on byte sets and
+/// on epsilon edges; the automaton engines (DFA and friends) are built from
+/// this one form.
+pub const Nfa = struct {
+    states: []const State,
+    start: u32,
+
+    pub const Edge = struct {
+        bytes: ByteSet,
+        to: u32,
+    };
+
+    pub const State = struct {
+        edges: []const Edge = &.{},
+        /// Moves taken without consuming input
+        eps: []const u32 = &.{},
+        /// Pattern accepted on reaching this state
+        accept: ?u32 = null,
+    };
+
+    pub const Error = error{ OutOfMemory, Unsupported };
+
+    /// NFA of one pattern, accepting as pattern 0
+    pub fn fromPattern(comptime p: Pattern) Nfa {
+        return fromPatterns(&.{p});
+    }
+
+    /// NFA accepting `patterns[i]` as pattern i
+    pub fn fromPatterns(comptime patterns: []const Pattern) Nfa {
+        comptime {
+            @setEvalBranchQuota(1_000_000);
+            for (patterns) |p| {
+                if (!supports(p)) @compileError("pattern has no automaton form: until() needs a single-byte delimiter");
+            }
+            var builder = Builder{};
+            return builder.finish(patterns) catch unreachable;
+        }
+    }
+
+    /// Runtime form of `fromPatterns`; states and edge lists are allocated
+    /// in `arena`
+    pub fn init(arena: std.mem.Allocator, patterns: []const Pattern) Error!Nfa {
+        for (patterns) |p| {
+            if (!supports(p)) return error.Unsupported;
+        }
+        var builder = Builder{ .arena = arena };
+        return builder.finish(patterns);
+    }
+
+    pub const ByteClasses = struct {
+        /// Class of each byte; bytes of one class move alike everywhere
+        of: [256]u8,
+        /// One byte of each class
+        representative: [256]u8,
+        count: usize,
+    };
+
+    /// Coarsest partition of the bytes that no edge set splits, so automata
+    /// need one transition per class instead of per byte
+    pub fn byteClasses(self: Nfa) ByteClasses {
+        var of = [_]u8{0} ** 256;
+        var count: usize = 1;
+        for (self.states) |state| {
+            for (state.edges) |edge| {
+                var remap = [_][2]?u8{.{ null, null }} ** 256;
+                var new_count: usize = 0;
+                for (&of, 0..) |*class, byte| {
+                    const side = @intFromBool(edge.bytes.contains(@intCast(byte)));
+                    if (remap[class.*][side] == null) {
+                        remap[class.*][side] = @intCast(new_count);
+                        new_count += 1;
+                    }
+                    class.* = remap[class.*][side].?;
+                }
+                count = new_count;
+            }
+        }
+        var representative: [256]u8 = undefined;
+        var byte: usize = 256;
+        while (byte > 0) {
+            byte -= 1;
+            representative[of[byte]] = @intCast(byte);
+        }
+        return .{ .of = of, .representative = representative, .count = count };
+    }
+};
+
+/// Whether `p` compiles to an automaton. `until` scans to the first
+/// delimiter match, which an automaton can only follow for single-byte
+/// delimiters, where it is a run of the other bytes.
+pub fn supports(p: Pattern) bool {
+    return switch (p) {
+        .sequence, .alternation => |parts| for (parts) |part| {
+            if (!supports(part)) break false;
+        } else true,
+        .one_or_more, .zero_or_more, .optional_pattern => |sub| supports(sub.*),
+        .until => |delimiter| singleByteSet(delimiter.*) != null,
+        .keyword_ident => |ki| supports(ki.ident),
+        else => true,
+    };
+}
+
+/// Bytes of a single-byte pattern, or null; `pattern.byteSet` for code that
+/// also runs at runtime
+pub fn singleByteSet(p: Pattern) ?ByteSet {
+    return switch (p) {
+        .char_class => |class| ByteSet.fromClass(class),
+        .range => |r| ByteSet.range(r.min, r.max),
+        .any_of => |chars| ByteSet.of(chars),
+        .byte_set => |bytes| bytes,
+        .literal => |lit| if (lit.len == 1) ByteSet.of(lit) else null,
+        .any => ByteSet.full(),
+        .alternation => |alternatives| blk: {
+            var bytes = ByteSet.empty();
+            for (alternatives) |alternative| bytes = bytes.unionWith(singleByteSet(alternative) orelse break :blk null);
+            break :blk bytes;
+        },
+        else => null,
+    };
+}
+
+/// Appends states. Patterns are built back to front: each one gets the state
+/// its matches continue to and returns its entry state. Comptime builds
+/// grow frozen slices; runtime builds allocate in the arena.
+const Builder = struct {
+    arena: ?std.mem.Allocator = null,
+    states: []const Nfa.State = &.{},
+    list: std.ArrayListUnmanaged(Nfa.State) = .{},
+
+    const Error = std.mem.Allocator.Error;
+
+    fn finish(self: *Builder, patterns: []const Pattern) Error!Nfa {
+        var entries: []const u32 = &.{};
+        for (patterns, 0..) |p, i| {
+            const accept = try self.add(.{ .accept = @as(u32, @intCast(i)) });
+            entries = try self.appendId(entries, try self.build(p, accept));
+        }
+        const start = try self.add(.{ .eps = entries });
+        return .{ .states = if (@inComptime()) self.states else self.list.items, .start = start };
+    }
+
+    fn add(self: *Builder, state: Nfa.State) Error!u32 {
+        if (@inComptime()) {
+            self.states = self.states ++ &[_]Nfa.State{state};
+            return self.states.len - 1;
+        }
+        try self.list.append(self.arena.?, state);
+        return @intCast(self.list.items.len - 1);
+    }
+
+    fn set(self: *Builder, id: u32, state: Nfa.State) void {
+        if (@inComptime()) {
+            const n = self.states.len;
+            var states: [n]Nfa.State = self.states[0..n].*;
+            states[id] = state;
+            const frozen = states;
+            self.states = &frozen;
+        } else {
+            self.list.items[id] = state;
+        }
+    }
+
+    fn appendId(self: *Builder, list: []const u32, id: u32) Error![]const u32 {
+        if (@inComptime()) return list ++ &[_]u32{id};
+        const grown = try self.arena.?.alloc(u32, list.len + 1);
+        @memcpy(grown[0..list.len], list);
+        grown[list.len] = id;
+        return grown;
+    }
+
+    fn split(self: *Builder, a: u32, b: u32) Error!Nfa.State {
+        return .{ .eps = try self.appendId(try self.appendId(&.{}, a), b) };
+    }
+
+    fn byteEdge(self: *Builder, bytes: ByteSet, to: u32) Error!u32 {
+        const edge = Nfa.Edge{ .bytes = bytes, .to = to };
+        if (@inComptime()) return self.add(.{ .edges = &[_]Nfa.Edge{edge} });
+        const edges = try self.arena.?.alloc(Nfa.Edge, 1);
+        edges[0] = edge;
+        return self.add(.{ .edges = edges });
+    }
+
+    fn build(self: *Builder, p: Pattern, next: u32) Error!u32 {
+        if (singleByteSet(p)) |bytes| return self.byteEdge(bytes, next);
+
+        switch (p) {
+            .literal => |lit| {
+                var entry = next;
+                var i = lit.len;
+                while (i > 0) {
+                    i -= 1;
+                    entry = try self.byteEdge(ByteSet.of(lit[i..][0..1]), entry);
+                }
+                return entry;
+            },
+            .sequence => |seq| {
+                var entry = next;
+                var i = seq.len;
+                while (i > 0) {
+                    i -= 1;
+                    entry = try self.build(seq[i], entry);
+                }
+                return entry;
+            },
+            .alternation => |alternatives| {
+                var entries: []const u32 = &.{};
+                for (alternatives) |alternative| entries = try self.appendId(entries, try self.build(alternative, next));
+                return self.add(.{ .eps = entries });
+            },
+            .one_or_more, .zero_or_more => |sub| {
+                const loop = try self.add(.{});
+                const body = try self.build(sub.*, loop);
+                self.set(loop, try self.split(body, next));
+                return if (p == .one_or_more) body else loop;
+            },
+            .optional_pattern => |sub| {
+                const body = try self.build(sub.*, next);
+                return self.add(try self.split(body, next));
+            },
+            .until => |delimiter| {
+                const stop = singleByteSet(delimiter.*).?;
+                const loop = try self.add(.{});
+                const body = try self.byteEdge(stop.negate(), loop);
+                self.set(loop, try self.split(body, next));
+                return loop;
+            },
+            .keyword_ident => |ki| return self.build(ki.ident, next),
+            // Single-byte patterns were handled above
+            .char_class, .range, .any_of, .byte_set, .any => unreachable,
+        }
+    }
+};
+
+test "nfa of a literal alternation" {
+    const nfa = comptime Nfa.fromPattern(pattern.match.literal("ab").orElse(pattern.match.literal("c")));
+    // Accept, "b", "a", "c", the split, and the start
+    try std.testing.expectEqual(@as(usize, 6), nfa.states.len);
+    try std.testing.expectEqual(@as(usize, 1), nfa.states[nfa.start].eps.len);
+    try std.testing.expect(!supports(pattern.match.until(pattern.match.literal("*/"))));
+    try std.testing.expect(supports(pattern.match.quoted('"')));
+}
+
+test "runtime nfa matches the comptime one" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+
+    const p = comptime pattern.match.alpha.then(pattern.match.alphanumeric.zeroOrMore()).orElse(pattern.match.quoted('"'));
+    const expected = comptime Nfa.fromPattern(p);
+    const actual = try Nfa.init(arena.allocator(), &.{p});
+    try std.testing.expectEqual(expected.states.len, actual.states.len);
+    try std.testing.expectEqual(expected.start, actual.start);
+    for (expected.states, actual.states) |e, a| {
+        try std.testing.expectEqualSlices(u32, e.eps, a.eps);
+        try std.testing.expectEqual(e.edges.len, a.edges.len);
+        for (e.edges, a.edges) |ee, ae| {
+            try std.testing.expectEqual(ee.to, ae.to);
+            try std.testing.expect(ee.bytes.bits.eql(ae.bytes.bits));
+        }
+    }
+    try std.testing.expectEqual(expected.byteClasses().count, actual.byteClasses().count);
+}
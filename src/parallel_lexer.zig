@@ -0,0 +1,262 @@
+const std = @import("std");
+
+/// Chunk-parallel tokenization for any DFA-based token set.
+///
+/// Tokens are found like `DFATokenizer` does: the longest non-empty match at
+/// the current position, the first declared pattern among equally long ones,
+/// and a byte where nothing matches is skipped. The lexer therefore backs off
+/// to the last accepting state when the DFA dies (a float pattern splits
+/// "12.x" into "12", "." and "x"), and the position after a token depends
+/// only on where the token started, not on how that position was reached:
+///
+/// 1. Every chunk is lexed speculatively, in parallel with the others, as if
+///    a token started at its first byte.
+/// 2. Chunks are stitched in order. The true lexer enters each chunk at the
+///    end of the last token of the previous one and is re-run from there
+///    until it lands on a token start of the speculative run; from that point
+///    both agree, so the rest of the speculative tokens are taken as they are.
+///    Chains usually meet within a token or two, at the next separator; one
+///    that never does is simply lexed sequentially to the end of the chunk.
+///
+/// `Dfa` must provide `start_state`, `dead_state`,
+/// `next(state: u32, byte: u8) u32` and `accepting(state: u32) ?u32`.
+pub fn ParallelLexer(comptime Dfa: type) type {
+    return struct {
+        pub const Token = struct {
+            start: usize,
+            end: usize,
+            /// Pattern index
+            id: u32,
+        };
+
+        pub const Options = struct {
+            /// Number of chunks (and threads); 0 = one per CPU
+            chunks: usize = 0,
+            /// Inputs are not split into chunks smaller than this
+            min_chunk_size: usize = 64 * 1024,
+        };
+
+        /// Step id of a skipped byte; steps are tokens plus skips
+        const skipped: u32 = std.math.maxInt(u32);
+
+        const ChunkResult = struct {
+            start: usize,
+            end: usize,
+            /// Steps of the run that starts at `start`; the last one may end
+            /// past `end`
+            steps: std.ArrayList(Token),
+            err: ?anyerror = null,
+        };
+
+        /// Single-threaded reference implementation with the same semantics
+        pub fn tokenizeSequential(allocator: std.mem.Allocator, input: []const u8) ![]Token {
+            var tokens = std.ArrayList(Token).init(allocator);
+            errdefer tokens.deinit();
+            var pos: usize = 0;
+            while (pos < input.len) {
+                const step = scan(input, pos);
+                if (step.id != skipped) try tokens.append(step);
+                pos = step.end;
+            }
+            return tokens.toOwnedSlice();
+        }
+
+        /// Tokenizes `input` on multiple threads. Caller owns the returned slice.
+        pub fn tokenize(allocator: std.mem.Allocator, input: []const u8, options: Options) ![]Token {
+            const wanted = if (options.chunks != 0) options.chunks else std.Thread.getCpuCount() catch 1;
+            const chunk_count = @max(1, @min(wanted, input.len / @max(options.min_chunk_size, 1)));
+            if (chunk_count == 1) return tokenizeSequential(allocator, input);
+
+            const chunks = try allocator.alloc(ChunkResult, chunk_count);
+            defer allocator.free(chunks);
+            for (chunks, 0..) |*chunk, i| {
+                chunk.* = .{
+                    .start = input.len * i / chunk_count,
+                    .end = input.len * (i + 1) / chunk_count,
+                    .steps = std.ArrayList(Token).init(allocator),
+                };
+            }
+            defer for (chunks) |*chunk| chunk.steps.deinit();
+
+            // Phase 1: speculative lexing, one thread per chunk after the first
+            const threads = try allocator.alloc(std.Thread, chunk_count - 1);
+            defer allocator.free(threads);
+            var spawned: usize = 0;
+            defer for (threads[0..spawned]) |thread| thread.join();
+            while (spawned < threads.len) : (spawned += 1) {
+                threads[spawned] = try std.Thread.spawn(.{}, speculate, .{ input, &chunks[spawned + 1] });
+            }
+            // The first chunk's run is the true one
+            speculate(input, &chunks[0]);
+            for (threads[0..spawned]) |thread| thread.join();
+            spawned = 0;
+
+            // Phase 2: stitch in order
+            var tokens = std.ArrayList(Token).init(allocator);
+            errdefer tokens.deinit();
+            var pos: usize = 0;
+            for (chunks) |*chunk| {
+                if (chunk.err) |err| return err;
+                const speculative = chunk.steps.items;
+                var i: usize = 0;
+                while (pos < chunk.end) {
+                    while (i < speculative.len and speculative[i].start < pos) i += 1;
+                    if (i < speculative.len and speculative[i].start == pos) {
+                        for (speculative[i..]) |step| {
+                            if (step.id != skipped) try tokens.append(step);
+                        }
+                        pos = speculative[speculative.len - 1].end;
+                        break;
+                    }
+                    const step = scan(input, pos);
+                    if (step.id != skipped) try tokens.append(step);
+                    pos = step.end;
+                }
+            }
+            return tokens.toOwnedSlice();
+        }
+
+        fn speculate(input: []const u8, chunk: *ChunkResult) void {
+            var pos = chunk.start;
+            while (pos < chunk.end) {
+                const step = scan(input, pos);
+                chunk.steps.append(step) catch |err| {
+                    chunk.err = err;
+                    return;
+                };
+                pos = step.end;
+            }
+        }
+
+        /// Longest match at `start`, or a skip of one byte if nothing matches.
+        /// The match may run past the end of the chunk.
+        fn scan(input: []const u8, start: usize) Token {
+            var step = Token{ .start = start, .end = start + 1, .id = skipped };
+            var state = Dfa.start_state;
+            var pos = start;
+            while (pos < input.len) {
+                state = Dfa.next(state, input[pos]);
+                if (state == Dfa.dead_state) break;
+                pos += 1;
+                if (Dfa.accepting(state)) |id| {
+                    step.end = pos;
+                    step.id = id;
+                }
+            }
+            return step;
+        }
+    };
+}
+
+// Hand-built DFA: 0 start, 1 word [a-z]+, 2 number [0-9]+, 3 spaces ' '+,
+// 4 inside "...", 5 closed string
+const TestDfa = struct {
+    pub const start_state: u32 = 0;
+    pub const dead_state: u32 = std.math.maxInt(u32);
+
+    pub fn next(state: u32, c: u8) u32 {
+        return switch (state) {
+            0 => switch (c) {
+                'a'...'z' => 1,
+                '0'...'9' => 2,
+                ' ' => 3,
+                '"' => 4,
+                else => dead_state,
+            },
+            1 => if (c >= 'a' and c <= 'z') 1 else dead_state,
+            2 => if (c >= '0' and c <= '9') 2 else dead_state,
+            3 => if (c == ' ') 3 else dead_state,
+            4 => if (c == '"') 5 else 4,
+            else => dead_state,
+        };
+    }
+
+    pub fn accepting(state: u32) ?u32 {
+        return switch (state) {
+            1 => 0,
+            2 => 1,
+            3 => 2,
+            5 => 3,
+            else => null,
+        };
+    }
+};
+
+test "parallel lexer matches sequential lexing" {
+    const Lexer = ParallelLexer(TestDfa);
+    const allocator = std.testing.allocator;
+
+    const input = try allocator.alloc(u8, 64 * 1024);
+    defer allocator.free(input);
+    var prng = std.Random.DefaultPrng.init(42);
+    const alphabet = "abcxyz0123   ;\"";
+    for (input) |*c| c.* = alphabet[prng.random().uintLessThan(usize, alphabet.len)];
+
+    const expected = try Lexer.tokenizeSequential(allocator, input);
+    defer allocator.free(expected);
+
+    for ([_]usize{ 2, 8, 61 }) |chunks| {
+        const actual = try Lexer.tokenize(allocator, input, .{ .chunks = chunks, .min_chunk_size = 1 });
+        defer allocator.free(actual);
+        try std.testing.expectEqualSlices(Lexer.Token, expected, actual);
+    }
+}
+
+test "parallel lexer token boundaries" {
+    const Lexer = ParallelLexer(TestDfa);
+    const tokens = try Lexer.tokenizeSequential(std.testing.allocator, "ab 12;\"x y\"");
+    defer std.testing.allocator.free(tokens);
+
+    // ';' matches nothing and is skipped
+    const ids = [_]u32{ 0, 2, 1, 3 };
+    try std.testing.expectEqual(ids.len, tokens.len);
+    for (tokens, ids) |token, id| try std.testing.expectEqual(id, token.id);
+    try std.testing.expectEqual(@as(usize, 6), tokens[3].start);
+}
+
+test "parallel lexer agrees with DFATokenizer" {
+    const dfa_generator = @import("dfa_generator.zig");
+    const match = @import("pattern.zig").match;
+    const int = comptime match.digit.oneOrMore();
+    const patterns = comptime .{
+        .number = match.choice(.{ int, int.then(match.literal(".")).then(int) }),
+        .ident = match.alpha.then(match.alphanumeric.zeroOrMore()),
+        .dot = match.literal("."),
+        .space = match.anyOf(" \t").oneOrMore(),
+    };
+    const TokenType = enum { number, ident, dot, space };
+    const Lexer = ParallelLexer(dfa_generator.DFAGenerator(patterns));
+    const Reference = dfa_generator.DFATokenizer(TokenType, patterns);
+    const allocator = std.testing.allocator;
+
+    // The DFA dies after "12." here, so the lexer must back off to "12"
+    const short = try Lexer.tokenizeSequential(allocator, "12.x");
+    defer allocator.free(short);
+    try std.testing.expectEqualSlices(Lexer.Token, &.{
+        .{ .start = 0, .end = 2, .id = 0 },
+        .{ .start = 2, .end = 3, .id = 2 },
+        .{ .start = 3, .end = 4, .id = 1 },
+    }, short);
+
+    const input = try allocator.alloc(u8, 16 * 1024);
+    defer allocator.free(input);
+    var prng = std.Random.DefaultPrng.init(7);
+    const alphabet = "12.x.5a \t;";
+    for (input) |*c| c.* = alphabet[prng.random().uintLessThan(usize, alphabet.len)];
+
+    var expected = std.ArrayList(Lexer.Token).init(allocator);
+    defer expected.deinit();
+    var reference = Reference.init(input);
+    while (reference.next()) |token| {
+        const start = @intFromPtr(token.text.ptr) - @intFromPtr(input.ptr);
+        try expected.append(.{ .start = start, .end = start + token.text.len, .id = @intFromEnum(token.type) });
+    }
+
+    const sequential = try Lexer.tokenizeSequential(allocator, input);
+    defer allocator.free(sequential);
+    try std.testing.expectEqualSlices(Lexer.Token, expected.items, sequential);
+
+    const parallel = try Lexer.tokenize(allocator, input, .{ .chunks = 8, .min_chunk_size = 1 });
+    defer allocator.free(parallel);
+    try std.testing.expectEqualSlices(Lexer.Token, expected.items, parallel);
+}
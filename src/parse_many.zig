@@ -0,0 +1,324 @@
+const std = @import("std");
+
+/// Per-document outcome stored in the caller's preallocated result slots
+pub fn Outcome(comptime R: type) type {
+    return union(enum) {
+        ok: R,
+        err: anyerror,
+    };
+}
+
+pub const ParseManyConfig = struct {
+    /// Worker threads including the caller; 0 = one per CPU
+    threads: usize = 0,
+    /// Documents are packed into batches of about this many input bytes,
+    /// so one unit of work is large enough to amortize scheduling but still
+    /// fits in L1/L2 together with the worker's scratch state
+    batch_bytes: usize = 32 * 1024,
+};
+
+pub const ParseManyStats = struct {
+    documents: usize = 0,
+    batches: usize = 0,
+    /// Successful steals across all workers
+    steals: usize = 0,
+    threads: usize = 0,
+};
+
+/// Per-thread state handed to the handler. The scratch arena is reset after
+/// every batch (keeping its capacity), so nothing allocated from it may be
+/// stored in a result.
+pub const Worker = struct {
+    id: usize,
+    arena: std.heap.ArenaAllocator,
+    /// Handler-owned per-worker state, e.g. a warm tokenizer
+    state: ?*anyopaque = null,
+    documents: usize = 0,
+    batches: usize = 0,
+    steals: usize = 0,
+
+    pub fn scratch(self: *Worker) std.mem.Allocator {
+        return self.arena.allocator();
+    }
+};
+
+/// Parses every input on a pool of work-stealing workers.
+///
+/// `handler` is a pointer; `handler.parse(*Worker, index, input) !R` is called once per document and
+/// its outcome lands in `results[index]`. Optional `initWorker(*Worker) !void`
+/// and `deinitWorker(*Worker) void` hooks set up per-thread state.
+///
+/// Documents are grouped into batches of consecutive inputs. Each worker owns
+/// a contiguous range of batches and pops from its front; an idle worker
+/// steals the back half of another worker's range.
+pub fn parseMany(
+    comptime R: type,
+    allocator: std.mem.Allocator,
+    inputs: []const []const u8,
+    results: []Outcome(R),
+    handler: anytype,
+    config: ParseManyConfig,
+) !ParseManyStats {
+    if (results.len != inputs.len) return error.ResultSlotMismatch;
+    if (inputs.len == 0) return .{};
+
+    const batches = try packBatches(allocator, inputs, config.batch_bytes);
+    defer allocator.free(batches);
+    if (batches.len >= max_batches) return error.TooManyBatches;
+
+    const thread_count = @max(1, @min(
+        if (config.threads != 0) config.threads else std.Thread.getCpuCount() catch 1,
+        batches.len,
+    ));
+
+    const Pool = WorkPool(R, @TypeOf(handler));
+    const queues = try allocator.alloc(Pool.Queue, thread_count);
+    defer allocator.free(queues);
+    const workers = try allocator.alloc(Worker, thread_count);
+    defer allocator.free(workers);
+
+    var pool = Pool{
+        .inputs = inputs,
+        .results = results,
+        .handler = handler,
+        .batches = batches,
+        .remaining = std.atomic.Value(usize).init(batches.len),
+        .queues = queues,
+        .workers = workers,
+    };
+
+    // Initial split: contiguous runs of batches per worker
+    for (pool.queues, pool.workers, 0..) |*queue, *worker, i| {
+        const front = batches.len * i / thread_count;
+        const back = batches.len * (i + 1) / thread_count;
+        queue.* = .{ .range = std.atomic.Value(u64).init(packRange(.{ .front = @intCast(front), .back = @intCast(back), .tag = 0 })) };
+        worker.* = .{ .id = i, .arena = std.heap.ArenaAllocator.init(allocator) };
+    }
+    defer for (pool.workers) |*worker| worker.arena.deinit();
+
+    var initialized: usize = 0;
+    defer if (@hasDecl(@TypeOf(handler.*), "deinitWorker")) {
+        for (pool.workers[0..initialized]) |*worker| handler.deinitWorker(worker);
+    };
+    if (@hasDecl(@TypeOf(handler.*), "initWorker")) {
+        while (initialized < thread_count) : (initialized += 1) {
+            try handler.initWorker(&pool.workers[initialized]);
+        }
+    }
+
+    // Worker 0 runs on the calling thread
+    const threads = try allocator.alloc(std.Thread, thread_count - 1);
+    defer allocator.free(threads);
+    var spawned: usize = 0;
+    defer for (threads[0..spawned]) |thread| thread.join();
+    errdefer pool.remaining.store(0, .release);
+    while (spawned < threads.len) : (spawned += 1) {
+        threads[spawned] = try std.Thread.spawn(.{}, Pool.run, .{ &pool, spawned + 1 });
+    }
+    pool.run(0);
+    for (threads[0..spawned]) |thread| thread.join();
+    spawned = 0;
+
+    var stats = ParseManyStats{ .threads = thread_count, .batches = batches.len };
+    for (pool.workers) |worker| {
+        stats.documents += worker.documents;
+        stats.steals += worker.steals;
+    }
+    return stats;
+}
+
+const Batch = struct {
+    start: usize,
+    end: usize,
+};
+
+// Batch ranges are packed into one word so owner pops and steals are single CAS operations
+const max_batches = std.math.maxInt(u24);
+
+const Range = packed struct(u64) {
+    front: u24,
+    back: u24,
+    /// Bumped on every update so a stale CAS cannot succeed after a refill
+    tag: u16,
+};
+
+fn packRange(range: Range) u64 {
+    return @bitCast(range);
+}
+
+fn unpackRange(word: u64) Range {
+    return @bitCast(word);
+}
+
+fn packBatches(allocator: std.mem.Allocator, inputs: []const []const u8, batch_bytes: usize) ![]Batch {
+    var batches = std.ArrayList(Batch).init(allocator);
+    errdefer batches.deinit();
+
+    var start: usize = 0;
+    var bytes: usize = 0;
+    for (inputs, 0..) |input, i| {
+        if (i > start and bytes + input.len > batch_bytes) {
+            try batches.append(.{ .start = start, .end = i });
+            start = i;
+            bytes = 0;
+        }
+        bytes += input.len;
+    }
+    try batches.append(.{ .start = start, .end = inputs.len });
+    return batches.toOwnedSlice();
+}
+
+fn WorkPool(comptime R: type, comptime Handler: type) type {
+    return struct {
+        const Self = @This();
+
+        const Queue = struct {
+            range: std.atomic.Value(u64),
+            // Keep neighbouring queues off each other's cache line
+            _pad: [std.atomic.cache_line - @sizeOf(u64)]u8 = undefined,
+        };
+
+        inputs: []const []const u8,
+        results: []Outcome(R),
+        handler: Handler,
+        batches: []const Batch,
+        /// Batches not yet processed; workers exit when it reaches zero
+        remaining: std.atomic.Value(usize),
+        queues: []Queue,
+        workers: []Worker,
+
+        fn run(self: *Self, id: usize) void {
+            const worker = &self.workers[id];
+            var spins: u32 = 0;
+
+            while (self.remaining.load(.acquire) != 0) {
+                if (self.popFront(id)) |batch_index| {
+                    self.processBatch(worker, self.batches[batch_index]);
+                    _ = self.remaining.fetchSub(1, .acq_rel);
+                    spins = 0;
+                    continue;
+                }
+
+                // Own range is empty: try every other worker once, nearest first
+                var stolen = false;
+                for (1..self.queues.len) |step| {
+                    const victim = (id + step) % self.queues.len;
+                    if (self.stealHalf(victim, id)) {
+                        worker.steals += 1;
+                        stolen = true;
+                        break;
+                    }
+                }
+                if (stolen) continue;
+
+                // Work is in flight elsewhere; back off until it finishes
+                if (spins < 64) {
+                    spins += 1;
+                    std.atomic.spinLoopHint();
+                } else {
+                    std.Thread.yield() catch {};
+                }
+            }
+        }
+
+        fn processBatch(self: *Self, worker: *Worker, batch: Batch) void {
+            for (batch.start..batch.end) |i| {
+                self.results[i] = if (self.handler.parse(worker, i, self.inputs[i])) |value|
+                    .{ .ok = value }
+                else |err|
+                    .{ .err = err };
+            }
+            worker.documents += batch.end - batch.start;
+            worker.batches += 1;
+            _ = worker.arena.reset(.retain_capacity);
+        }
+
+        fn popFront(self: *Self, id: usize) ?usize {
+            const queue = &self.queues[id].range;
+            var word = queue.load(.acquire);
+            while (true) {
+                const range = unpackRange(word);
+                if (range.front >= range.back) return null;
+                const next = Range{ .front = range.front + 1, .back = range.back, .tag = range.tag +% 1 };
+                word = queue.cmpxchgWeak(word, packRange(next), .acq_rel, .acquire) orelse return range.front;
+            }
+        }
+
+        /// Moves the back half of `victim`'s range into `thief`'s (empty) range
+        fn stealHalf(self: *Self, victim: usize, thief: usize) bool {
+            const source = &self.queues[victim].range;
+            var word = source.load(.acquire);
+            const taken = while (true) {
+                const range = unpackRange(word);
+                if (range.front >= range.back) return false;
+                const count = (range.back - range.front + 1) / 2;
+                const next = Range{ .front = range.front, .back = range.back - count, .tag = range.tag +% 1 };
+                word = source.cmpxchgWeak(word, packRange(next), .acq_rel, .acquire) orelse
+                    break Range{ .front = range.back - count, .back = range.back, .tag = 0 };
+            };
+
+            // Nobody modifies an empty range, so a plain update of our own word is safe
+            const own = &self.queues[thief].range;
+            const current = unpackRange(own.load(.acquire));
+            own.store(packRange(.{ .front = taken.front, .back = taken.back, .tag = current.tag +% 1 }), .release);
+            return true;
+        }
+    };
+}
+
+test "parseMany fills every result slot" {
+    const json = @import("parsers/json.zig");
+
+    const Counter = struct {
+        pub fn parse(self: *@This(), worker: *Worker, index: usize, input: []const u8) !usize {
+            _ = self;
+            _ = index;
+            // Exercise the scratch arena; it is reset after the batch
+            const copy = try worker.scratch().dupe(u8, input);
+            var parser = json.JsonParser.init(copy);
+            var events: usize = 0;
+            while (try parser.parseValue()) |_| events += 1;
+            return events;
+        }
+    };
+
+    var inputs: [500][]const u8 = undefined;
+    for (&inputs, 0..) |*input, i| {
+        input.* = if (i % 3 == 0) "{\"a\": [1, 2, 3]}" else "[true, null]";
+    }
+    var results: [500]Outcome(usize) = undefined;
+    var counter = Counter{};
+
+    const stats = try parseMany(usize, std.testing.allocator, &inputs, &results, &counter, .{
+        .threads = 4,
+        .batch_bytes = 64,
+    });
+
+    try std.testing.expectEqual(@as(usize, 500), stats.documents);
+    for (results, 0..) |result, i| {
+        // JsonParser reports every token, punctuation and whitespace included
+        const expected: usize = if (i % 3 == 0) 14 else 6;
+        try std.testing.expectEqual(expected, result.ok);
+    }
+}
+
+test "parseMany reports per-document errors" {
+    const Failing = struct {
+        pub fn parse(self: *@This(), worker: *Worker, index: usize, input: []const u8) !u8 {
+            _ = self;
+            _ = worker;
+            _ = index;
+            if (input.len == 0) return error.EmptyDocument;
+            return input[0];
+        }
+    };
+
+    const inputs = [_][]const u8{ "a", "", "c" };
+    var results: [3]Outcome(u8) = undefined;
+    var handler = Failing{};
+    _ = try parseMany(u8, std.testing.allocator, &inputs, &results, &handler, .{ .threads = 2, .batch_bytes = 1 });
+
+    try std.testing.expectEqual(@as(u8, 'a'), results[0].ok);
+    try std.testing.expectEqual(error.EmptyDocument, results[1].err);
+    try std.testing.expectEqual(@as(u8, 'c'), results[2].ok);
+}
@@ -28,6 +28,8 @@ pub const StateMachineConfig = struct {
 const ParserData = struct {
     allocator: std.mem.Allocator,
     stream: ?ByteStream,
+    /// Buffer behind `stream` once incremental chunks have been appended
+    stream_buffer: ?[]u8,
     tokenizer: ?Tokenizer,
     state_machine: StateMachine,
     context: ParserContext,
@@ -39,6 +41,7 @@ const ParserData = struct {
         return .{
             .allocator = allocator,
             .stream = null,
+            .stream_buffer = null,
             .tokenizer = null,
             .state_machine = undefined, // Will be initialized later
             .context = try ParserContext.init(allocator),
@@ -50,6 +53,7 @@ const ParserData = struct {
 
     fn deinit(self: *ParserData) void {
         if (self.stream) |*stream| stream.deinit();
+        if (self.stream_buffer) |buffer| self.allocator.free(buffer);
         if (self.tokenizer) |*tokenizer| tokenizer.deinit();
         self.context.deinit();
         if (self.error_message) |msg| self.allocator.free(msg);
@@ -75,8 +79,7 @@ const ParserHandle = struct {
         errdefer allocator.destroy(data);
         data.* = try ParserData.init(allocator);
 
-        // In a real implementation, we would use a handle manager
-        // to track and validate handles across API boundaries
+        // Handles crossing the C boundary are validated by the C API's handle table
         return ParserHandle{
             .id = generateUniqueId(),
             .data = data,
@@ -211,9 +214,10 @@ pub const Parser = struct {
             );
             // Can't use errdefer with const tokenizer
             
-            // Store components
+            // Store components; the tokenizer must point at the stored stream
             data.stream = stream;
             data.tokenizer = tokenizer;
+            data.tokenizer.?.stream = &data.stream.?;
             
             // Emit start document event
             try data.event_emitter.emit(Event.init(.START_DOCUMENT, data.stream.?.getPosition()));
@@ -272,9 +276,12 @@ pub const Parser = struct {
             };
             const tokenizer = tokenizer_mut;
             
-            // Store new components
+            // Store new components; the previous buffer is no longer referenced
             data.stream = stream;
             data.tokenizer = tokenizer;
+            data.tokenizer.?.stream = &data.stream.?;
+            if (data.stream_buffer) |buffer| data.allocator.free(buffer);
+            data.stream_buffer = new_content;
         }
         
         // Process tokens until we run out of input
@@ -351,16 +358,16 @@ fn initParserComponents(
         state_machine_config.initial_state_id,
     );
 
-    // Store components in parser data
+    // Store components in parser data; the tokenizer must point at the stored stream
     data.stream = stream;
     data.tokenizer = tokenizer;
+    data.tokenizer.?.stream = &data.stream.?;
     data.state_machine = state_machine;
 }
 
-// Generate a unique ID for handles
+// Generate a unique ID for handles. The counter is atomic; C API handles
+// are issued separately by the lock-free table in handle_table.zig.
 fn generateUniqueId() u64 {
-    // In a real implementation, this would use atomic operations
-    // and proper handle management
     const static = struct {
         var next_id: u64 = 1;
     };
@@ -1,6 +1,7 @@
 const std = @import("std");
 const zigparse = @import("../zigparse.zig");
 const fast_matcher = @import("../fast_matcher.zig");
+const BlockClassifier = @import("../block_classifier.zig").BlockClassifier;
 
 /// High-performance CSV tokenizer with zero allocations
 /// Handles CSV parsing with proper quote escaping and delimiter detection
@@ -309,15 +310,30 @@ pub const UltraFastCsvTokenizer = struct {
     line: usize = 1,
     column: usize = 1,
     config: CsvTokenizer.Config,
+    /// Specials are the delimiter (bit 0), quote character (bit 1) and
+    /// escape character (bit 2, the quote again when there is none)
+    classifier: BlockClassifier,
+    
+    const field_stops = BlockClassifier.Selector.of(&.{.newline}).withSpecials(0b011);
+    const quoted_stops = BlockClassifier.Selector.of(&.{.newline}).withSpecials(0b010);
+    const escaped_quoted_stops = BlockClassifier.Selector.of(&.{.newline}).withSpecials(0b110);
     
     pub fn init(input: []const u8, config: CsvTokenizer.Config) UltraFastCsvTokenizer {
         return .{
             .input = input,
             .config = config,
+            .classifier = BlockClassifier.init(input, &.{ config.delimiter, config.quote_char, config.escape_char orelse config.quote_char }),
         };
     }
     
     pub fn next(self: *UltraFastCsvTokenizer) ?CsvTokenizer.Token {
+        if (self.config.trim_whitespace) {
+            while (self.pos < self.input.len and isWhitespace(self.input[self.pos])) {
+                self.pos += 1;
+                self.column += 1;
+            }
+        }
+        
         if (self.pos >= self.input.len) {
             return .{
                 .type = .eof,
@@ -387,11 +403,14 @@ pub const UltraFastCsvTokenizer = struct {
         self.pos += 1; // Skip opening quote
         self.column += 1;
         
-        while (self.pos < self.input.len) {
-            const c = self.input[self.pos];
+        // Jump between quotes, escapes and line breaks; everything else is content
+        const stops = if (self.config.escape_char != null) escaped_quoted_stops else quoted_stops;
+        while (self.classifier.find(self.pos, stops)) |stop| {
+            const c = self.input[stop];
+            self.column += stop - self.pos;
+            self.pos = stop + 1;
             
             if (c == self.config.quote_char) {
-                self.pos += 1;
                 self.column += 1;
                 
                 // Check for escaped quote
@@ -403,13 +422,31 @@ pub const UltraFastCsvTokenizer = struct {
                 break;
             }
             
+            // The escaped byte is content, even a quote or line break
+            if (self.config.escape_char) |escape| {
+                if (c == escape and self.pos < self.input.len) {
+                    self.column += 1;
+                    self.pos += 1;
+                    if (self.input[self.pos - 1] == '\n') {
+                        self.line += 1;
+                        self.column = 1;
+                    } else {
+                        self.column += 1;
+                    }
+                    continue;
+                }
+            }
+            
             if (c == '\n') {
                 self.line += 1;
                 self.column = 1;
             } else {
                 self.column += 1;
             }
-            self.pos += 1;
+        } else {
+            // Unterminated quote runs to the end of input
+            self.column += self.input.len - self.pos;
+            self.pos = self.input.len;
         }
         
         return .{
@@ -425,23 +462,21 @@ pub const UltraFastCsvTokenizer = struct {
         const start_line = self.line;
         const start_column = self.column;
         
-        // Use SIMD-accelerated search for field boundaries
-        const remaining = self.input[self.pos..];
-        var end_pos: usize = 0;
+        // Field ends at the first delimiter, quote or line break in the block masks
+        const end_pos = self.classifier.find(self.pos, field_stops) orelse self.input.len;
         
-        for (remaining) |c| {
-            if (c == self.config.delimiter or c == '\n' or c == '\r' or c == self.config.quote_char) {
-                break;
-            }
-            end_pos += 1;
-        }
+        self.column += end_pos - self.pos;
+        self.pos = end_pos;
         
-        self.pos += end_pos;
-        self.column += end_pos;
+        // Trailing spaces are consumed but not part of the field
+        var text_end = end_pos;
+        if (self.config.trim_whitespace) {
+            while (text_end > start_pos and isWhitespace(self.input[text_end - 1])) text_end -= 1;
+        }
         
         return .{
             .type = .field,
-            .text = self.input[start_pos..self.pos],
+            .text = self.input[start_pos..text_end],
             .line = start_line,
             .column = start_column,
         };
@@ -529,6 +564,41 @@ test "ultra fast CSV tokenizer" {
     try std.testing.expectEqual(@as(usize, 12), token_count); // a,b,c,\n,1,2,3,\n = 12 tokens
 }
 
+test "ultra fast CSV tokenizer quoted fields across blocks" {
+    const input = "id;\"" ++ "x" ** 70 ++ "\"\"y\ny\";z\r\n";
+    var tokenizer = UltraFastCsvTokenizer.init(input, .{ .delimiter = ';' });
+    
+    try std.testing.expectEqualStrings("id", tokenizer.next().?.text);
+    try std.testing.expectEqual(CsvTokenizer.TokenType.comma, tokenizer.next().?.type);
+    const quoted = tokenizer.next().?;
+    try std.testing.expectEqual(CsvTokenizer.TokenType.quoted_field, quoted.type);
+    try std.testing.expectEqual(@as(usize, 77), quoted.text.len);
+    try std.testing.expectEqual(@as(usize, 2), tokenizer.line);
+    try std.testing.expectEqual(@as(usize, 3), tokenizer.column);
+    try std.testing.expectEqual(CsvTokenizer.TokenType.comma, tokenizer.next().?.type);
+    try std.testing.expectEqualStrings("z", tokenizer.next().?.text);
+    try std.testing.expectEqualStrings("\r\n", tokenizer.next().?.text);
+}
+
+test "ultra fast CSV tokenizer matches CsvTokenizer with escapes and trimming" {
+    const input = "  a ,\"x\\\"y\", b\t\n\"p\\\nq\" ,c";
+    const config = CsvTokenizer.Config{ .escape_char = '\\', .trim_whitespace = true };
+    var fast = UltraFastCsvTokenizer.init(input, config);
+    var reference = CsvTokenizer.init(input, config);
+    
+    var count: usize = 0;
+    while (true) : (count += 1) {
+        const expected = reference.next().?;
+        const actual = fast.next().?;
+        try std.testing.expectEqual(expected.type, actual.type);
+        try std.testing.expectEqualStrings(expected.text, actual.text);
+        try std.testing.expectEqual(expected.line, actual.line);
+        if (expected.type == .eof) break;
+    }
+    // a , "x\"y" , b \n "p\<newline>q" , c
+    try std.testing.expectEqual(@as(usize, 9), count);
+}
+
 test "CSV performance comparison" {
     const input = "name,age,city,country\n" ** 1000 ++ "John,25,NYC,USA\n" ** 1000;
     
@@ -1,17 +1,22 @@
 const std = @import("std");
 const char_class = @import("char_class.zig");
+const KeywordSet = @import("keywords.zig").KeywordSet;
+const regex_syntax = @import("regex.zig");
 
 pub const PatternType = enum {
     literal,
     char_class,
     range,
     any_of,
+    byte_set,
     sequence,
+    alternation,
     one_or_more,
     zero_or_more,
     optional_pattern,
     until,
     any,
+    keyword_ident,
 };
 
 pub const Pattern = union(PatternType) {
@@ -19,12 +24,16 @@ pub const Pattern = union(PatternType) {
     char_class: char_class.CharClass,
     range: struct { min: u8, max: u8 },
     any_of: []const u8,
+    byte_set: char_class.ByteSet,
     sequence: []const Pattern,
+    /// Longest-matching alternative; the earliest one on ties
+    alternation: []const Pattern,
     one_or_more: *const Pattern,
     zero_or_more: *const Pattern,
     optional_pattern: *const Pattern,
     until: *const Pattern,
     any: void,
+    keyword_ident: *const KeywordIdent,
     
     pub fn oneOrMore(self: Pattern) Pattern {
         const ptr = &self;
@@ -44,6 +53,25 @@ pub const Pattern = union(PatternType) {
     pub fn then(self: Pattern, other: Pattern) Pattern {
         return .{ .sequence = &[_]Pattern{ self, other } };
     }
+    
+    /// `self` or `other`, whichever matches longer
+    pub fn orElse(self: Pattern, other: Pattern) Pattern {
+        return .{ .alternation = &[_]Pattern{ self, other } };
+    }
+};
+
+/// Identifier whose text is reclassified as a keyword token when it is one;
+/// see `match.identifierWithKeywords`
+pub const KeywordIdent = struct {
+    ident: Pattern,
+    /// Keyword texts, and the token type names they map to
+    keywords: []const []const u8,
+    names: []const []const u8,
+    
+    /// Index of `text` among the keywords, via a comptime perfect hash
+    pub fn keywordIndex(comptime self: *const KeywordIdent, text: []const u8) ?usize {
+        return KeywordSet(self.keywords).lookup(text);
+    }
 };
 
 // Static patterns to avoid pointer issues
@@ -100,10 +128,79 @@ pub const match = struct {
         return .{ .any_of = chars };
     }
     
+    /// One byte of a user-defined class, e.g.
+    /// `ByteSet.fromClass(.digit).unionWith(ByteSet.of("-.:"))`
+    pub fn set(byte_set: char_class.ByteSet) Pattern {
+        return .{ .byte_set = byte_set };
+    }
+    
+    /// Alternation over a tuple of patterns, e.g. `choice(.{ hex, float, int })`.
+    /// Alternatives are decided together, by the longest match, so their
+    /// order only matters on ties
+    pub fn choice(comptime alternatives: anytype) Pattern {
+        comptime {
+            const fields = std.meta.fields(@TypeOf(alternatives));
+            var patterns: [fields.len]Pattern = undefined;
+            for (fields, 0..) |field, i| patterns[i] = @field(alternatives, field.name);
+            const frozen = patterns;
+            return .{ .alternation = &frozen };
+        }
+    }
+    
+    /// Byte-set algebra over single-byte patterns (classes, ranges, sets,
+    /// one-byte literals and alternations of them); the result is one set
+    pub fn unionOf(comptime a: Pattern, comptime b: Pattern) Pattern {
+        return set(bytesOf(a).unionWith(bytesOf(b)));
+    }
+    
+    pub fn intersectionOf(comptime a: Pattern, comptime b: Pattern) Pattern {
+        return set(bytesOf(a).intersectWith(bytesOf(b)));
+    }
+    
+    /// Bytes of `a` that are not bytes of `b`, e.g. `except(any, quote)`
+    pub fn except(comptime a: Pattern, comptime b: Pattern) Pattern {
+        return set(bytesOf(a).without(bytesOf(b)));
+    }
+    
+    pub fn complementOf(comptime a: Pattern) Pattern {
+        return set(bytesOf(a).negate());
+    }
+    
+    fn bytesOf(comptime p: Pattern) char_class.ByteSet {
+        const bytes = byteSet(p) orelse @compileError("set algebra needs single-byte patterns");
+        return char_class.ByteSet.fromArray(bytes);
+    }
+    
+    /// Pattern from a regular expression parsed at comptime, e.g.
+    /// `regex("[A-Za-z_][A-Za-z0-9_]*")`; see `regex.parse` for the syntax
+    pub fn regex(comptime source: []const u8) Pattern {
+        return regex_syntax.parse(source);
+    }
+    
     pub fn until(delimiter: Pattern) Pattern {
         return .{ .until = &delimiter };
     }
     
+    /// Matches `ident` once, then reclassifies the span with a perfect hash:
+    /// `identifierWithKeywords(ident, .{ .kw_if = "if", .kw_else = "else" })`
+    /// yields token type `kw_if` for "if" and the field's own type otherwise,
+    /// without trying each keyword as a separate literal pattern first
+    pub fn identifierWithKeywords(comptime ident: Pattern, comptime keywords: anytype) Pattern {
+        comptime {
+            const fields = std.meta.fields(@TypeOf(keywords));
+            var texts: [fields.len][]const u8 = undefined;
+            var names: [fields.len][]const u8 = undefined;
+            for (fields, 0..) |field, i| {
+                texts[i] = @field(keywords, field.name);
+                names[i] = field.name;
+            }
+            const frozen_texts = texts;
+            const frozen_names = names;
+            const keyword_ident = KeywordIdent{ .ident = ident, .keywords = &frozen_texts, .names = &frozen_names };
+            return .{ .keyword_ident = &keyword_ident };
+        }
+    }
+    
     pub fn quoted(quote_char: u8) Pattern {
         const quote_pattern = literal(&[_]u8{quote_char});
         return .{
@@ -114,6 +211,18 @@ pub const match = struct {
             },
         };
     }
+    
+    /// Quoted string in which `escape_char` makes the next byte part of the
+    /// string, e.g. `quotedEscaped('"', '\\')` for "say \"hi\"". Compiled
+    /// matchers skip the bytes between escapes a vector block at a time.
+    pub fn quotedEscaped(comptime quote_char: u8, comptime escape_char: u8) Pattern {
+        comptime {
+            const quote = literal(&[_]u8{quote_char});
+            const plain = except(any, anyOf(&[_]u8{ quote_char, escape_char }));
+            const escaped = literal(&[_]u8{escape_char}).then(any);
+            return quote.then(plain.orElse(escaped).zeroOrMore()).then(quote);
+        }
+    }
 };
 
 // Pattern matching result
@@ -169,6 +278,13 @@ pub fn matchPattern(pattern: Pattern, input: []const u8, pos: usize) MatchResult
             return .{ .matched = false, .len = 0 };
         },
         
+        .byte_set => |set| {
+            if (set.contains(input[pos])) {
+                return .{ .matched = true, .len = 1 };
+            }
+            return .{ .matched = false, .len = 0 };
+        },
+        
         .sequence => |seq| {
             var current_pos = pos;
             for (seq) |sub_pattern| {
@@ -179,6 +295,15 @@ pub fn matchPattern(pattern: Pattern, input: []const u8, pos: usize) MatchResult
             return .{ .matched = true, .len = current_pos - pos };
         },
         
+        .alternation => |alternatives| {
+            var best = MatchResult{ .matched = false, .len = 0 };
+            for (alternatives) |alternative| {
+                const result = matchPattern(alternative, input, pos);
+                if (result.matched and (!best.matched or result.len > best.len)) best = result;
+            }
+            return best;
+        },
+        
         .one_or_more => |sub| {
             var current_pos = pos;
             var count: usize = 0;
@@ -217,6 +342,11 @@ pub fn matchPattern(pattern: Pattern, input: []const u8, pos: usize) MatchResult
         },
         
         .until => |delimiter| {
+            if (delimiter.* == .literal and delimiter.literal.len > 0) {
+                const end = std.mem.indexOfPos(u8, input, pos, delimiter.literal) orelse input.len;
+                return .{ .matched = true, .len = end - pos };
+            }
+            
             var current_pos = pos;
             
             while (current_pos < input.len) {
@@ -237,6 +367,42 @@ pub fn matchPattern(pattern: Pattern, input: []const u8, pos: usize) MatchResult
             }
             return .{ .matched = false, .len = 0 };
         },
+        
+        .keyword_ident => |ki| return matchPattern(ki.ident, input, pos),
+    }
+}
+
+/// Bytes accepted by a single-byte pattern, or null if the pattern can span
+/// several bytes; lets hot loops replace the pattern with a vector test
+pub fn byteSet(comptime p: Pattern) ?[256]bool {
+    comptime {
+        @setEvalBranchQuota(10_000);
+        var set = [_]bool{false} ** 256;
+        switch (p) {
+            .char_class => |class| {
+                for (0..256) |c| set[c] = char_class.char_table[c] == class;
+            },
+            .range => |r| {
+                for (r.min..@as(usize, r.max) + 1) |c| set[c] = true;
+            },
+            .any_of => |chars| {
+                for (chars) |c| set[c] = true;
+            },
+            .byte_set => |bytes| set = bytes.toArray(),
+            .literal => |lit| {
+                if (lit.len != 1) return null;
+                set[lit[0]] = true;
+            },
+            .any => set = [_]bool{true} ** 256,
+            .alternation => |alternatives| {
+                for (alternatives) |alternative| {
+                    const bytes = byteSet(alternative) orelse return null;
+                    for (bytes, 0..) |member, c| set[c] = set[c] or member;
+                }
+            },
+            else => return null,
+        }
+        return set;
     }
 }
 
@@ -262,4 +428,33 @@ test "pattern matching" {
     const digit_result = matchPattern(match.digit.oneOrMore(), input, 5);
     try std.testing.expect(digit_result.matched);
     try std.testing.expectEqual(@as(usize, 3), digit_result.len);
-}
\ No newline at end of file
+}
+
+test "user-defined byte set pattern" {
+    const ident = comptime match.set(char_class.ByteSet.fromClass(.alpha_lower)
+        .unionWith(char_class.ByteSet.range('0', '9'))
+        .unionWith(char_class.ByteSet.of("-.:")));
+    const input = "node-1.example:80 rest";
+    
+    const result = matchPattern(ident.oneOrMore(), input, 0);
+    try std.testing.expect(result.matched);
+    try std.testing.expectEqual(@as(usize, 17), result.len);
+    try std.testing.expect(!matchPattern(ident, input, 17).matched);
+    try std.testing.expect(byteSet(ident).?[':']);
+}
+
+test "alternation takes the longest alternative" {
+    const int = comptime match.digit.oneOrMore();
+    const float = comptime int.then(match.literal(".")).then(int);
+    const hex = comptime match.literal("0x").then(match.unionOf(match.digit, match.range('a', 'f')).oneOrMore());
+    const number = comptime match.choice(.{ int, float, hex });
+    
+    try std.testing.expectEqual(@as(usize, 4), matchPattern(number, "12.5;", 0).len);
+    try std.testing.expectEqual(@as(usize, 4), matchPattern(number, "0x1f;", 0).len);
+    try std.testing.expectEqual(@as(usize, 2), matchPattern(number, "12;", 0).len);
+    try std.testing.expect(!matchPattern(number, "x12", 0).matched);
+    
+    const not_quote = comptime match.except(match.any, match.quote);
+    try std.testing.expect(byteSet(not_quote).?['a'] and !byteSet(not_quote).?['"']);
+    try std.testing.expect(byteSet(match.literal("+").orElse(match.literal("-"))).?['-']);
+}
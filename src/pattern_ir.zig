@@ -0,0 +1,560 @@
+const std = @import("std");
+const char_class = @import("char_class.zig");
+const pattern = @import("pattern.zig");
+const simd_module = @import("simd.zig");
+const simd = simd_module.simd;
+const nfa = @import("nfa.zig");
+const Dfa = @import("dfa_generator.zig").Dfa;
+const Glushkov = @import("glushkov.zig").Glushkov;
+
+const Pattern = pattern.Pattern;
+const MatchResult = pattern.MatchResult;
+const ByteSet = char_class.ByteSet;
+
+/// Byte-set repetitions with more ranges than this scan with shufti lookups
+const max_span_ranges = 6;
+
+/// Comptime rewrite of a Pattern tree into an equivalent, cheaper one:
+///
+/// - single-byte patterns (`char_class`, `range`, `any_of`, one-byte
+///   literals) fold into `byte_set`, one bit test each;
+/// - nested sequences are flattened, adjacent literals merged, and
+///   one-element sequences unwrapped;
+/// - `optional`/`zeroOrMore`/`oneOrMore` nests collapse to the single
+///   repetition they are equivalent to (e.g. `optional(zeroOrMore(p))` is
+///   `zeroOrMore(p)`), which also removes loops over empty matches;
+/// - nested alternations are flattened and their single-byte alternatives
+///   merged into one set.
+///
+/// `Compiled` matches the result with vector span scans for byte-set
+/// repetitions and rejects positions early on the literal prefix and the set
+/// of possible first bytes.
+pub fn optimize(comptime p: Pattern) Pattern {
+    comptime {
+        @setEvalBranchQuota(100_000);
+        return switch (p) {
+            .char_class, .range, .any_of => .{ .byte_set = ByteSet.fromArray(pattern.byteSet(p).?) },
+            .literal => |lit| if (lit.len == 1) .{ .byte_set = ByteSet.of(lit) } else p,
+            .byte_set, .any => p,
+            .sequence => |seq| optimizeSequence(seq),
+            .alternation => |alternatives| optimizeAlternation(alternatives),
+            .one_or_more => |sub| repeat(.one_or_more, optimize(sub.*)),
+            .zero_or_more => |sub| repeat(.zero_or_more, optimize(sub.*)),
+            .optional_pattern => |sub| repeat(.optional_pattern, optimize(sub.*)),
+            .until => |delimiter| .{ .until = ref(optimize(delimiter.*)) },
+            .keyword_ident => |ki| blk: {
+                const optimized = pattern.KeywordIdent{ .ident = optimize(ki.ident), .keywords = ki.keywords, .names = ki.names };
+                break :blk .{ .keyword_ident = &optimized };
+            },
+        };
+    }
+}
+
+/// `kind` applied to the optimized `inner`. Two nested repetitions of the
+/// same kind are one; any other pair is `zeroOrMore`, since it allows both
+/// zero and several repeats
+fn repeat(comptime kind: pattern.PatternType, comptime inner: Pattern) Pattern {
+    const body, const inner_kind = switch (inner) {
+        .one_or_more, .zero_or_more, .optional_pattern => |sub| .{ sub, std.meta.activeTag(inner) },
+        else => return @unionInit(Pattern, @tagName(kind), ref(inner)),
+    };
+    if (kind == inner_kind) return inner;
+    return .{ .zero_or_more = body };
+}
+
+fn ref(comptime p: Pattern) *const Pattern {
+    const frozen = p;
+    return &frozen;
+}
+
+fn optimizeSequence(comptime seq: []const Pattern) Pattern {
+    var parts: []const Pattern = &.{};
+    for (seq) |sub| {
+        const optimized = optimize(sub);
+        const pieces: []const Pattern = if (optimized == .sequence) optimized.sequence else &.{optimized};
+        for (pieces) |piece| {
+            // Merge adjacent literals; one-byte literals were folded into sets
+            const piece_lit = literalBytes(piece);
+            if (parts.len > 0 and piece_lit != null) {
+                if (literalBytes(parts[parts.len - 1])) |prev| {
+                    parts = parts[0 .. parts.len - 1] ++ &[_]Pattern{.{ .literal = prev ++ piece_lit.? }};
+                    continue;
+                }
+            }
+            parts = parts ++ &[_]Pattern{piece};
+        }
+    }
+    if (parts.len == 1) return parts[0];
+    return .{ .sequence = parts };
+}
+
+fn optimizeAlternation(comptime alternatives: []const Pattern) Pattern {
+    var bytes = ByteSet.empty();
+    var has_bytes = false;
+    var rest: []const Pattern = &.{};
+    for (alternatives) |alternative| {
+        const optimized = optimize(alternative);
+        const pieces: []const Pattern = if (optimized == .alternation) optimized.alternation else &.{optimized};
+        for (pieces) |piece| {
+            // Single-byte alternatives all match one byte, so their order is moot
+            if (piece == .byte_set) {
+                bytes = bytes.unionWith(piece.byte_set);
+                has_bytes = true;
+            } else {
+                rest = rest ++ &[_]Pattern{piece};
+            }
+        }
+    }
+    const parts: []const Pattern = if (has_bytes) &[_]Pattern{.{ .byte_set = bytes }} ++ rest else rest;
+    if (parts.len == 1) return parts[0];
+    return .{ .alternation = parts };
+}
+
+/// Exact bytes a pattern matches, if it matches only one string
+fn literalBytes(comptime p: Pattern) ?[]const u8 {
+    return switch (p) {
+        .literal => |lit| lit,
+        .byte_set => |set| if (set.count() == 1) &[_]u8{@intCast(set.bits.findFirstSet().?)} else null,
+        else => null,
+    };
+}
+
+/// Literal every match of `p` starts with (possibly empty)
+pub fn literalPrefix(comptime p: Pattern) []const u8 {
+    comptime {
+        return switch (p) {
+            .sequence => |seq| blk: {
+                var prefix: []const u8 = "";
+                for (seq) |sub| {
+                    const bytes = literalBytes(sub) orelse {
+                        prefix = prefix ++ literalPrefix(sub);
+                        break;
+                    };
+                    prefix = prefix ++ bytes;
+                }
+                break :blk prefix;
+            },
+            .alternation => |alternatives| blk: {
+                if (alternatives.len == 0) break :blk "";
+                var prefix = literalPrefix(alternatives[0]);
+                for (alternatives[1..]) |alternative| {
+                    const other = literalPrefix(alternative);
+                    prefix = prefix[0..std.mem.indexOfDiff(u8, prefix, other) orelse prefix.len];
+                }
+                break :blk prefix;
+            },
+            .one_or_more => |sub| literalPrefix(sub.*),
+            .keyword_ident => |ki| literalPrefix(ki.ident),
+            else => literalBytes(p) orelse "",
+        };
+    }
+}
+
+/// Bytes a non-empty match of `p` can start with; null if `p` can match
+/// the empty string (then the next byte says nothing)
+pub fn firstBytes(comptime p: Pattern) ?ByteSet {
+    return if (nullable(p)) null else startBytes(p);
+}
+
+/// Whether `p` can match the empty string
+pub fn nullable(comptime p: Pattern) bool {
+    return switch (p) {
+        .literal => |lit| lit.len == 0,
+        .sequence => |seq| for (seq) |sub| {
+            if (!nullable(sub)) break false;
+        } else true,
+        .alternation => |alternatives| for (alternatives) |alternative| {
+            if (nullable(alternative)) break true;
+        } else false,
+        .one_or_more => |sub| nullable(sub.*),
+        .zero_or_more, .optional_pattern, .until => true,
+        .keyword_ident => |ki| nullable(ki.ident),
+        .char_class, .range, .any_of, .byte_set, .any => false,
+    };
+}
+
+/// Bytes a non-empty match of `p` can start with
+fn startBytes(comptime p: Pattern) ByteSet {
+    comptime {
+        return switch (p) {
+            .literal => |lit| ByteSet.of(lit[0..@min(lit.len, 1)]),
+            .char_class, .range, .any_of, .byte_set, .any => ByteSet.fromArray(pattern.byteSet(p).?),
+            .sequence => |seq| blk: {
+                var set = ByteSet.empty();
+                for (seq) |sub| {
+                    set = set.unionWith(startBytes(sub));
+                    // Only a part that may match empty lets the next one start the match
+                    if (!nullable(sub)) break;
+                }
+                break :blk set;
+            },
+            .alternation => |alternatives| blk: {
+                var set = ByteSet.empty();
+                for (alternatives) |alternative| set = set.unionWith(startBytes(alternative));
+                break :blk set;
+            },
+            .one_or_more, .zero_or_more, .optional_pattern => |sub| startBytes(sub.*),
+            .until => |delimiter| untilBytes(delimiter.*),
+            .keyword_ident => |ki| startBytes(ki.ident),
+        };
+    }
+}
+
+/// Bytes with which a greedy match of `p` may go on after a point where it
+/// could also have stopped
+fn tailBytes(comptime p: Pattern) ByteSet {
+    comptime {
+        return switch (p) {
+            .literal, .char_class, .range, .any_of, .byte_set, .any => ByteSet.empty(),
+            .sequence => |seq| blk: {
+                var set = ByteSet.empty();
+                var i = seq.len;
+                while (i > 0) {
+                    i -= 1;
+                    set = set.unionWith(tailBytes(seq[i]));
+                    if (!nullable(seq[i])) break;
+                }
+                break :blk set;
+            },
+            .one_or_more, .zero_or_more, .optional_pattern => |sub| startBytes(sub.*).unionWith(tailBytes(sub.*)),
+            .until => |delimiter| untilBytes(delimiter.*),
+            .keyword_ident => |ki| tailBytes(ki.ident),
+            // Alternatives may be prefixes of each other
+            .alternation => |alternatives| if (disjointAlternatives(alternatives)) blk: {
+                var set = ByteSet.empty();
+                for (alternatives) |alternative| set = set.unionWith(tailBytes(alternative));
+                break :blk set;
+            } else ByteSet.full(),
+        };
+    }
+}
+
+/// Bytes `until(delimiter)` consumes: anything but a single-byte delimiter
+fn untilBytes(comptime delimiter: Pattern) ByteSet {
+    const stop = pattern.byteSet(delimiter) orelse return ByteSet.full();
+    return ByteSet.fromArray(stop).negate();
+}
+
+/// How a compiled pattern is executed after the first-byte and prefix checks
+pub const Engine = enum {
+    /// Walk the pattern tree, unrolled at comptime
+    direct,
+    /// Run a DFA built from the pattern; decides alternations in one pass
+    dfa,
+    /// Run the Glushkov automaton bit-parallel, for patterns whose DFA
+    /// would be too large
+    bit_parallel,
+};
+
+/// DFA states a pattern may need before it runs bit-parallel instead
+const dfa_state_budget = 64;
+
+/// Engine for an optimized pattern. The direct walk is greedy: a repetition
+/// takes all it can and never gives any back, and alternatives would each be
+/// tried from the same position. Patterns where a repetition could starve
+/// the rest of the pattern (`.*;`, `a?ab`) and alternations go to the DFA,
+/// or bit-parallel when the DFA would exceed `dfa_state_budget` states and
+/// the pattern has at most 63 positions.
+pub fn selectEngine(comptime p: Pattern) Engine {
+    if (greedyIsExact(p) or !nfa.supports(p)) return .direct;
+    if (Glushkov.fromPattern(p)) |g| {
+        if (g.dfaStates(dfa_state_budget) > dfa_state_budget) return .bit_parallel;
+    }
+    return .dfa;
+}
+
+/// Whether the greedy walk finds the longest match of `p`
+fn greedyIsExact(comptime p: Pattern) bool {
+    comptime {
+        return switch (p) {
+            .alternation => |alternatives| disjointAlternatives(alternatives) and for (alternatives) |alternative| {
+                if (!greedyIsExact(alternative)) break false;
+            } else true,
+            .sequence => |seq| for (seq, 0..) |sub, i| {
+                if (!greedyIsExact(sub)) break false;
+                if (i + 1 < seq.len and overlaps(tailBytes(sub), startBytes(.{ .sequence = seq[i + 1 ..] }))) break false;
+            } else true,
+            .one_or_more, .zero_or_more => |sub| greedyIsExact(sub.*) and !overlaps(tailBytes(sub.*), startBytes(sub.*)),
+            .optional_pattern => |sub| greedyIsExact(sub.*),
+            .keyword_ident => |ki| greedyIsExact(ki.ident),
+            else => true,
+        };
+    }
+}
+
+/// Whether at most one alternative can match at any position: none matches
+/// empty and no two start with the same byte
+fn disjointAlternatives(comptime alternatives: []const Pattern) bool {
+    comptime {
+        var seen = ByteSet.empty();
+        for (alternatives) |alternative| {
+            const start = startBytes(alternative);
+            if (nullable(alternative) or overlaps(seen, start)) return false;
+            seen = seen.unionWith(start);
+        }
+        return true;
+    }
+}
+
+fn overlaps(a: ByteSet, b: ByteSet) bool {
+    return a.intersectWith(b).count() != 0;
+}
+
+/// Matcher specialized at comptime for the optimized form of `source`.
+///
+/// Matches like `pattern.matchPattern`, except that zero-width patterns
+/// (`zeroOrMore`, `optional`, `until`) also succeed at the end of input, so
+/// e.g. an identifier ending the input is still an identifier. Patterns run
+/// on the DFA engine match their longest prefix in the pattern's language,
+/// with backtracking where the direct walk is greedy.
+pub fn Compiled(comptime source: Pattern) type {
+    return struct {
+        pub const ir = optimize(source);
+        pub const prefix = literalPrefix(ir);
+        pub const first = firstBytes(ir);
+        pub const engine = selectEngine(ir);
+        const dfa = if (engine == .dfa) Dfa.build(nfa.Nfa.fromPattern(ir)) else {};
+        const glushkov = if (engine == .bit_parallel) Glushkov.fromPattern(ir).? else {};
+
+        pub fn match(input: []const u8, pos: usize) MatchResult {
+            if (comptime first) |set| {
+                if (pos >= input.len or !set.contains(input[pos])) return fail;
+            }
+            if (comptime prefix.len > 1) {
+                if (!std.mem.startsWith(u8, input[pos..], prefix)) return fail;
+            }
+            switch (engine) {
+                .direct => return matchNode(ir, input, pos),
+                .dfa => {
+                    const found = dfa.longest(input, pos) orelse return fail;
+                    return ok(found.len);
+                },
+                .bit_parallel => return ok(glushkov.longest(input, pos) orelse return fail),
+            }
+        }
+    };
+}
+
+const fail = MatchResult{ .matched = false, .len = 0 };
+
+inline fn ok(len: usize) MatchResult {
+    return .{ .matched = true, .len = len };
+}
+
+fn matchNode(comptime p: Pattern, input: []const u8, pos: usize) MatchResult {
+    switch (p) {
+        .literal => |lit| {
+            if (!std.mem.startsWith(u8, input[pos..], lit)) return fail;
+            return ok(lit.len);
+        },
+        .byte_set => |set| {
+            if (pos >= input.len or !set.contains(input[pos])) return fail;
+            return ok(1);
+        },
+        .char_class, .range, .any_of => return matchNode(comptime optimize(p), input, pos),
+        .any => return if (pos < input.len) ok(1) else fail,
+        .sequence => |seq| {
+            var current = pos;
+            inline for (seq) |sub| {
+                const result = matchNode(sub, input, current);
+                if (!result.matched) return fail;
+                current += result.len;
+            }
+            return ok(current - pos);
+        },
+        .one_or_more => |sub| {
+            const end = repeatEnd(sub.*, input, pos);
+            return if (end > pos) ok(end - pos) else fail;
+        },
+        .zero_or_more => |sub| return ok(repeatEnd(sub.*, input, pos) - pos),
+        .optional_pattern => |sub| {
+            const result = matchNode(sub.*, input, pos);
+            return if (result.matched) result else ok(0);
+        },
+        .alternation => |alternatives| {
+            var best = fail;
+            inline for (alternatives) |alternative| {
+                const result = matchNode(alternative, input, pos);
+                if (result.matched and (!best.matched or result.len > best.len)) best = result;
+            }
+            return best;
+        },
+        .until => |delimiter| return ok(untilEnd(delimiter.*, input, pos) - pos),
+        .keyword_ident => |ki| return matchNode(ki.ident, input, pos),
+    }
+}
+
+/// End of the longest run of `sub` matches starting at `pos`
+fn repeatEnd(comptime sub: Pattern, input: []const u8, pos: usize) usize {
+    if (sub == .byte_set) {
+        const ranges = comptime simd_module.byteRanges(sub.byte_set.toArray());
+        if (comptime ranges.len <= max_span_ranges) return simd.runEnd(input, pos, ranges);
+        return simd.setRunEnd(input, pos, sub.byte_set);
+    }
+    if (sub == .any) return input.len;
+    if (comptime sub == .alternation and sub.alternation[0] == .byte_set and disjointAlternatives(sub.alternation)) {
+        // Runs of the set alternative (the clean bytes of an escaped string)
+        // are skipped a block at a time; the other alternatives are tried
+        // only where a run stops
+        const rest = comptime if (sub.alternation.len == 2) sub.alternation[1] else Pattern{ .alternation = sub.alternation[1..] };
+        var current = pos;
+        while (true) {
+            current = repeatEnd(sub.alternation[0], input, current);
+            if (current >= input.len) break;
+            const result = matchNode(rest, input, current);
+            if (!result.matched or result.len == 0) break;
+            current += result.len;
+        }
+        return current;
+    }
+
+    var current = pos;
+    while (current < input.len) {
+        const result = matchNode(sub, input, current);
+        if (!result.matched or result.len == 0) break;
+        current += result.len;
+    }
+    return current;
+}
+
+/// Start of the first `delimiter` match at or after `pos`, or the end of input
+fn untilEnd(comptime delimiter: Pattern, input: []const u8, pos: usize) usize {
+    switch (delimiter) {
+        .literal => |lit| return simd.findLiteral(input, pos, lit) orelse input.len,
+        .byte_set => |set| return simd.findInSet(input, pos, set) orelse input.len,
+        else => {},
+    }
+    var current = pos;
+    while (current < input.len) : (current += 1) {
+        if (matchNode(delimiter, input, current).matched) break;
+    }
+    return current;
+}
+
+test "optimizer folds, flattens and collapses" {
+    const p = comptime optimize(pattern.match.literal("<").then(pattern.match.literal("!--")
+        .then(pattern.match.digit.zeroOrMore().optional())));
+    try std.testing.expect(p == .sequence);
+    try std.testing.expectEqual(@as(usize, 2), p.sequence.len);
+    try std.testing.expectEqualStrings("<!--", p.sequence[0].literal);
+    try std.testing.expect(p.sequence[1] == .zero_or_more);
+    try std.testing.expect(p.sequence[1].zero_or_more.* == .byte_set);
+    try std.testing.expectEqualStrings("<!--", comptime literalPrefix(p));
+
+    const nested = comptime optimize(pattern.match.alpha.oneOrMore().oneOrMore());
+    try std.testing.expect(nested == .one_or_more and nested.one_or_more.* == .byte_set);
+
+    const ident = comptime pattern.match.alpha.then(pattern.match.alphanumeric.zeroOrMore());
+    const first = comptime firstBytes(optimize(ident)).?;
+    try std.testing.expect(first.contains('q') and !first.contains('7'));
+    try std.testing.expectEqual(@as(?ByteSet, null), comptime firstBytes(pattern.match.digit.zeroOrMore()));
+}
+
+test "compiled patterns agree with matchPattern away from end of input" {
+    const patterns = comptime [_]Pattern{
+        pattern.match.alpha.then(pattern.match.alphanumeric.zeroOrMore()),
+        pattern.match.digit.oneOrMore().then(pattern.match.literal(".").then(pattern.match.digit.oneOrMore()).optional()),
+        pattern.match.literal("/*").then(pattern.match.until(pattern.match.literal("*/"))),
+        pattern.match.anyOf("aXz0_.;(\n").oneOrMore(),
+        pattern.match.quoted('"'),
+        pattern.match.literal("ab").then(pattern.match.range('a', 'c')),
+    };
+
+    var input: [300]u8 = undefined;
+    var prng = std.Random.DefaultPrng.init(29);
+    const alphabet = "ab c09./*\"X;(\n";
+    for (&input) |*c| c.* = alphabet[prng.random().uintLessThan(usize, alphabet.len)];
+    // Sentinel tail, so no match runs into the end of input
+    @memcpy(input[input.len - 4 ..], "\x01\x01*/");
+
+    inline for (patterns) |p| {
+        for (0..input.len - 4) |pos| {
+            const expected = pattern.matchPattern(p, &input, pos);
+            const actual = Compiled(p).match(&input, pos);
+            try std.testing.expectEqual(expected.matched, actual.matched);
+            if (expected.matched) try std.testing.expectEqual(expected.len, actual.len);
+        }
+    }
+}
+
+test "alternations run on the DFA engine" {
+    const int = comptime pattern.match.digit.oneOrMore();
+    const Number = Compiled(pattern.match.choice(.{
+        int,
+        int.then(pattern.match.literal(".")).then(int),
+        pattern.match.literal("0x").then(pattern.match.anyOf("0123456789abcdef").oneOrMore()),
+    }));
+    try std.testing.expectEqual(Engine.dfa, Number.engine);
+    try std.testing.expectEqual(MatchResult{ .matched = true, .len = 4 }, Number.match("12.5)", 0));
+    try std.testing.expectEqual(MatchResult{ .matched = true, .len = 2 }, Number.match("12.)", 0));
+    try std.testing.expectEqual(MatchResult{ .matched = true, .len = 6 }, Number.match("0xbeef", 0));
+    try std.testing.expectEqual(fail, Number.match("x1", 0));
+
+    const Sign = Compiled(pattern.match.literal("+").orElse(pattern.match.literal("-")));
+    try std.testing.expect(Sign.ir == .byte_set);
+    try std.testing.expectEqual(Engine.direct, Sign.engine);
+}
+
+test "engine selection follows greedy ambiguity" {
+    const m = pattern.match;
+    const ident = comptime m.alpha.then(m.alphanumeric.zeroOrMore());
+    const float = comptime m.digit.oneOrMore().then(m.literal(".")).then(m.digit.oneOrMore());
+    const upto_semicolon = comptime m.except(m.any, m.newline).zeroOrMore().then(m.literal(";"));
+    try std.testing.expectEqual(Engine.direct, comptime selectEngine(optimize(ident)));
+    try std.testing.expectEqual(Engine.direct, comptime selectEngine(optimize(float)));
+    try std.testing.expectEqual(Engine.direct, comptime selectEngine(optimize(m.quoted('"'))));
+    try std.testing.expectEqual(Engine.dfa, comptime selectEngine(optimize(upto_semicolon)));
+
+    // The greedy walk would take every ';' and fail
+    try std.testing.expectEqual(MatchResult{ .matched = true, .len = 4 }, Compiled(upto_semicolon).match("a;b;c\n", 0));
+}
+
+test "bounded repeats run bit-parallel" {
+    // The DFA would need 2^9 states to remember the last nine bytes
+    const Tail = Compiled(pattern.match.regex("[ab]*a[ab]{8}"));
+    try std.testing.expectEqual(Engine.bit_parallel, Tail.engine);
+
+    const input = "abbbaabababbbbbabaaabx";
+    for (0..input.len) |start| {
+        // Longest: up to the last 'a' followed by eight of [ab]
+        var expected: ?usize = null;
+        var end = start + 9;
+        while (end <= input.len and input[end - 1] != 'x') : (end += 1) {
+            if (input[end - 9] == 'a') expected = end - start;
+        }
+        const actual = Tail.match(input, start);
+        try std.testing.expectEqual(expected != null, actual.matched);
+        if (expected) |len| try std.testing.expectEqual(len, actual.len);
+    }
+}
+
+test "until and escaped strings skip in bulk" {
+    const m = pattern.match;
+    const Comment = Compiled(m.literal("/*").then(m.until(m.literal("*/"))).then(m.literal("*/")));
+    const body = "x * y / z\n" ** 50;
+    const comment = "/*" ++ body ++ "*/ rest";
+    try std.testing.expectEqual(MatchResult{ .matched = true, .len = body.len + 4 }, Comment.match(comment, 0));
+
+    const String = Compiled(m.quotedEscaped('"', '\\'));
+    try std.testing.expectEqual(Engine.direct, String.engine);
+    const inputs = [_][]const u8{
+        "\"say \\\"hi\\\" now\" tail",
+        "\"" ++ "plain text " ** 20 ++ "\\\\\"",
+        "\"ends with escape\\",
+        "\"unterminated",
+    };
+    for (inputs) |input| {
+        const expected = pattern.matchPattern(m.quotedEscaped('"', '\\'), input, 0);
+        const actual = String.match(input, 0);
+        try std.testing.expectEqual(expected.matched, actual.matched);
+        if (expected.matched) try std.testing.expectEqual(expected.len, actual.len);
+    }
+    try std.testing.expectEqual(MatchResult{ .matched = true, .len = 16 }, String.match(inputs[0], 0));
+}
+
+test "compiled identifier matches at end of input" {
+    const Ident = Compiled(pattern.match.alpha.then(pattern.match.alphanumeric.zeroOrMore()));
+    try std.testing.expectEqual(MatchResult{ .matched = true, .len = 1 }, Ident.match("a", 0));
+    try std.testing.expectEqual(MatchResult{ .matched = true, .len = 3 }, Ident.match("x = ab1", 4));
+    try std.testing.expectEqual(fail, Ident.match("1ab", 0));
+}
@@ -100,6 +100,11 @@ pub fn matchPatternOptimized(pattern: Pattern, input: []const u8, pos: usize) Ma
             return .{ .matched = false, .len = 0 };
         },
         
+        .byte_set => |set| {
+            const matched = set.contains(input[pos]);
+            return .{ .matched = matched, .len = if (matched) 1 else 0 };
+        },
+        
         .one_or_more => |sub| {
             // Optimized one_or_more with specialized cases
             if (isSimpleCharClass(sub.*)) {
@@ -134,6 +139,15 @@ pub fn matchPatternOptimized(pattern: Pattern, input: []const u8, pos: usize) Ma
             return matchSequenceOptimized(seq, input, pos);
         },
         
+        .alternation => |alternatives| {
+            var best = MatchResult{ .matched = false, .len = 0 };
+            for (alternatives) |alternative| {
+                const result = matchPatternOptimized(alternative, input, pos);
+                if (result.matched and (!best.matched or result.len > best.len)) best = result;
+            }
+            return best;
+        },
+        
         .any => {
             return .{ .matched = true, .len = 1 };
         },
@@ -141,6 +155,10 @@ pub fn matchPatternOptimized(pattern: Pattern, input: []const u8, pos: usize) Ma
         .until => |delimiter| {
             return matchUntilOptimized(delimiter.*, input, pos);
         },
+        
+        .keyword_ident => |ki| {
+            return matchPatternOptimized(ki.ident, input, pos);
+        },
     }
 }
 
@@ -319,6 +337,12 @@ fn matchUntilOptimized(delimiter: Pattern, input: []const u8, pos: usize) MatchR
         return .{ .matched = true, .len = remaining.len };
     }
     
+    // Multi-byte literal delimiters (comment ends, heredoc terminators)
+    if (delimiter == .literal and delimiter.literal.len > 1) {
+        const found = simd.findStringPattern(input[pos..], delimiter.literal) orelse input.len - pos;
+        return .{ .matched = true, .len = found };
+    }
+    
     // Generic until implementation
     var current_pos = pos;
     while (current_pos < input.len) {
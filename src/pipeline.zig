@@ -0,0 +1,867 @@
+const std = @import("std");
+const ByteStream = @import("byte_stream.zig").ByteStream;
+const TokenStream = @import("token_stream.zig").TokenStream;
+const event_emitter = @import("event_emitter.zig");
+const EventEmitter = event_emitter.EventEmitter;
+const Event = event_emitter.Event;
+const EventType = event_emitter.EventType;
+const Position = @import("common.zig").Position;
+const format_engine = @import("format_engine.zig");
+const FormatEngine = format_engine.FormatEngine;
+const FormatEvent = format_engine.FormatEvent;
+const event_pipeline = @import("event_pipeline.zig");
+const SpscRing = event_pipeline.SpscRing;
+const ChunkEpoch = event_pipeline.ChunkEpoch;
+
+/// Unit of work passed between pipeline stages.
+/// Each descriptor owns one reference on `epoch` (if any); the runner drops it
+/// once the receiving stage has processed the descriptor.
+pub const Descriptor = struct {
+    data: []const u8,
+    /// Stage-defined tag: token type for tokenizer output, event type for parser output
+    tag: u32 = 0,
+    /// Sequence number assigned by the producing stage
+    seq: u64 = 0,
+    /// Pins `data` when it lives in a transient buffer; null for caller-owned memory
+    epoch: ?*ChunkEpoch = null,
+};
+
+pub const SourceFn = *const fn (ctx: ?*anyopaque, out: *Output) anyerror!bool;
+pub const ProcessFn = *const fn (ctx: ?*anyopaque, item: Descriptor, out: *Output) anyerror!void;
+pub const FlushFn = *const fn (ctx: ?*anyopaque, out: *Output) anyerror!void;
+
+pub const Stage = struct {
+    name: []const u8,
+    ctx: ?*anyopaque,
+    /// Set for the first stage only; returns false once the input is exhausted
+    source_fn: ?SourceFn = null,
+    /// Set for every later stage
+    process_fn: ?ProcessFn = null,
+    /// Optional end-of-stream hook, e.g. to emit a held-back token
+    flush_fn: ?FlushFn = null,
+};
+
+/// Per-stage timing, collected by the stage's own thread
+pub const StageStats = struct {
+    name: []const u8 = "",
+    /// Time spent inside the stage function, excluding time blocked on output
+    busy_ns: u64 = 0,
+    /// Time spent waiting for input
+    idle_ns: u64 = 0,
+    /// Time spent waiting for room in the output queue (backpressure)
+    blocked_ns: u64 = 0,
+    items_in: u64 = 0,
+    /// Descriptors handed downstream; for the last stage, descriptors consumed
+    items_out: u64 = 0,
+};
+
+/// Depth samples for the queue between stage `i` and stage `i + 1`
+pub const QueueStats = struct {
+    capacity: usize = 0,
+    max_depth: usize = 0,
+    depth_sum: u64 = 0,
+    samples: u64 = 0,
+
+    pub fn averageDepth(self: QueueStats) f64 {
+        if (self.samples == 0) return 0;
+        return @as(f64, @floatFromInt(self.depth_sum)) / @as(f64, @floatFromInt(self.samples));
+    }
+};
+
+pub const Report = struct {
+    stages: []const StageStats,
+    queues: []const QueueStats,
+    elapsed_ns: u64,
+
+    /// Index of the stage with the most busy time, i.e. the one to optimize first
+    pub fn bottleneck(self: Report) ?usize {
+        if (self.stages.len == 0) return null;
+        var best: usize = 0;
+        for (self.stages, 0..) |stage, i| {
+            if (stage.busy_ns > self.stages[best].busy_ns) best = i;
+        }
+        return best;
+    }
+
+    pub fn format(
+        self: Report,
+        comptime fmt: []const u8,
+        options: std.fmt.FormatOptions,
+        writer: anytype,
+    ) !void {
+        _ = fmt;
+        _ = options;
+        try writer.print("{s:<12} {s:>12} {s:>12} {s:>12} {s:>10} {s:>10}\n", .{
+            "stage", "busy ms", "idle ms", "blocked ms", "in", "out",
+        });
+        for (self.stages, 0..) |stage, i| {
+            try writer.print("{s:<12} {d:>12.2} {d:>12.2} {d:>12.2} {d:>10} {d:>10}\n", .{
+                stage.name,
+                nsToMs(stage.busy_ns),
+                nsToMs(stage.idle_ns),
+                nsToMs(stage.blocked_ns),
+                stage.items_in,
+                stage.items_out,
+            });
+            if (i < self.queues.len) {
+                const queue = self.queues[i];
+                try writer.print("  queue -> depth avg {d:.1}, max {d}/{d}\n", .{
+                    queue.averageDepth(),
+                    queue.max_depth,
+                    queue.capacity,
+                });
+            }
+        }
+    }
+};
+
+fn nsToMs(ns: u64) f64 {
+    return @as(f64, @floatFromInt(ns)) / 1_000_000.0;
+}
+
+pub const RunnerConfig = struct {
+    /// Descriptors in flight between two adjacent stages
+    queue_capacity: usize = 256,
+    /// Busy-wait iterations before yielding when a queue is full or empty
+    spin_limit: u32 = 128,
+};
+
+/// Handle through which a stage emits descriptors to the next stage.
+/// Emitting blocks while the downstream queue is full, which is what
+/// propagates backpressure up to the source.
+pub const Output = struct {
+    runner: *PipelineRunner,
+    ring: ?*SpscRing(Descriptor),
+    stats: *StageStats,
+    queue_stats: ?*QueueStats,
+    blocked_ns: u64 = 0,
+    next_seq: u64 = 0,
+
+    /// Hands `item` (and its epoch reference) to the next stage
+    pub fn emit(self: *Output, item: Descriptor) !void {
+        var owned = item;
+        owned.seq = self.next_seq;
+        self.next_seq += 1;
+
+        const ring = self.ring orelse {
+            // Last stage: nothing downstream, just drop the reference
+            if (owned.epoch) |epoch| epoch.release();
+            return;
+        };
+
+        if (self.queue_stats) |queue_stats| {
+            const depth = ring.len();
+            queue_stats.max_depth = @max(queue_stats.max_depth, depth);
+            queue_stats.depth_sum += depth;
+            queue_stats.samples += 1;
+        }
+
+        if (!ring.tryPush(owned)) {
+            var timer = std.time.Timer.start() catch null;
+            var spins: u32 = 0;
+            while (!ring.tryPush(owned)) {
+                if (self.runner.aborted.load(.acquire)) {
+                    if (owned.epoch) |epoch| epoch.release();
+                    return error.PipelineAborted;
+                }
+                backoff(&spins, self.runner.config.spin_limit);
+            }
+            if (timer) |*t| self.blocked_ns += t.read();
+        }
+        // Only descriptors that reached the queue count
+        self.stats.items_out += 1;
+    }
+
+    /// Emits a sub-slice of `parent`, taking an extra reference on its epoch
+    pub fn emitView(self: *Output, parent: Descriptor, data: []const u8, tag: u32) !void {
+        if (parent.epoch) |epoch| epoch.retain();
+        try self.emit(.{ .data = data, .tag = tag, .epoch = parent.epoch });
+    }
+};
+
+/// Runs a linear chain of stages (read -> decompress -> tokenize -> parse -> handle)
+/// with one thread per stage and bounded lock-free queues in between.
+pub const PipelineRunner = struct {
+    allocator: std.mem.Allocator,
+    config: RunnerConfig,
+    stages: std.ArrayList(Stage),
+
+    // Per-run state
+    queues: []SpscRing(Descriptor),
+    producer_done: []std.atomic.Value(bool),
+    stage_stats: []StageStats,
+    queue_stats: []QueueStats,
+    aborted: std.atomic.Value(bool),
+    error_mutex: std.Thread.Mutex,
+    first_error: ?anyerror,
+
+    pub fn init(allocator: std.mem.Allocator, config: RunnerConfig) PipelineRunner {
+        return .{
+            .allocator = allocator,
+            .config = config,
+            .stages = std.ArrayList(Stage).init(allocator),
+            .queues = &.{},
+            .producer_done = &.{},
+            .stage_stats = &.{},
+            .queue_stats = &.{},
+            .aborted = std.atomic.Value(bool).init(false),
+            .error_mutex = .{},
+            .first_error = null,
+        };
+    }
+
+    pub fn deinit(self: *PipelineRunner) void {
+        self.freeRunState();
+        self.stages.deinit();
+    }
+
+    pub fn addSource(self: *PipelineRunner, name: []const u8, ctx: ?*anyopaque, source_fn: SourceFn) !void {
+        if (self.stages.items.len != 0) return error.SourceMustBeFirst;
+        try self.stages.append(.{ .name = name, .ctx = ctx, .source_fn = source_fn });
+    }
+
+    pub fn addStage(
+        self: *PipelineRunner,
+        name: []const u8,
+        ctx: ?*anyopaque,
+        process_fn: ProcessFn,
+        flush_fn: ?FlushFn,
+    ) !void {
+        if (self.stages.items.len == 0) return error.MissingSource;
+        try self.stages.append(.{ .name = name, .ctx = ctx, .process_fn = process_fn, .flush_fn = flush_fn });
+    }
+
+    /// Runs the pipeline to completion. The returned report stays valid until
+    /// the next `run()` or `deinit()`.
+    pub fn run(self: *PipelineRunner) !Report {
+        const stage_count = self.stages.items.len;
+        if (stage_count == 0) return error.MissingSource;
+
+        self.freeRunState();
+        try self.allocRunState(stage_count);
+        self.aborted.store(false, .release);
+        self.first_error = null;
+
+        var timer = try std.time.Timer.start();
+
+        const threads = try self.allocator.alloc(std.Thread, stage_count);
+        defer self.allocator.free(threads);
+
+        var spawned: usize = 0;
+        errdefer {
+            self.aborted.store(true, .release);
+            for (threads[0..spawned]) |thread| thread.join();
+        }
+        while (spawned < stage_count) : (spawned += 1) {
+            threads[spawned] = try std.Thread.spawn(.{}, stageMain, .{ self, spawned });
+        }
+        for (threads) |thread| thread.join();
+
+        if (self.first_error) |err| return err;
+
+        return .{
+            .stages = self.stage_stats,
+            .queues = self.queue_stats,
+            .elapsed_ns = timer.read(),
+        };
+    }
+
+    fn allocRunState(self: *PipelineRunner, stage_count: usize) !void {
+        errdefer self.freeRunState();
+        const queue_count = stage_count - 1;
+
+        self.stage_stats = try self.allocator.alloc(StageStats, stage_count);
+        for (self.stage_stats, self.stages.items) |*stats, stage| stats.* = .{ .name = stage.name };
+
+        self.queue_stats = try self.allocator.alloc(QueueStats, queue_count);
+        self.producer_done = try self.allocator.alloc(std.atomic.Value(bool), queue_count);
+        for (self.producer_done) |*done| done.* = std.atomic.Value(bool).init(false);
+
+        self.queues = try self.allocator.alloc(SpscRing(Descriptor), queue_count);
+        var initialized: usize = 0;
+        errdefer for (self.queues[0..initialized]) |*queue| queue.deinit();
+        while (initialized < queue_count) : (initialized += 1) {
+            self.queues[initialized] = try SpscRing(Descriptor).init(self.allocator, self.config.queue_capacity);
+            self.queue_stats[initialized] = .{ .capacity = self.queues[initialized].capacity() };
+        }
+    }
+
+    fn freeRunState(self: *PipelineRunner) void {
+        for (self.queues) |*queue| {
+            // Drop references still held by descriptors left behind by an aborted run
+            while (queue.tryPop()) |item| {
+                if (item.epoch) |epoch| epoch.release();
+            }
+            queue.deinit();
+        }
+        if (self.queues.len != 0) self.allocator.free(self.queues);
+        if (self.producer_done.len != 0) self.allocator.free(self.producer_done);
+        if (self.stage_stats.len != 0) self.allocator.free(self.stage_stats);
+        if (self.queue_stats.len != 0) self.allocator.free(self.queue_stats);
+        self.queues = &.{};
+        self.producer_done = &.{};
+        self.stage_stats = &.{};
+        self.queue_stats = &.{};
+    }
+
+    fn fail(self: *PipelineRunner, err: anyerror) void {
+        self.error_mutex.lock();
+        defer self.error_mutex.unlock();
+        if (self.first_error == null and err != error.PipelineAborted) {
+            self.first_error = err;
+        }
+        self.aborted.store(true, .release);
+    }
+
+    fn stageMain(self: *PipelineRunner, index: usize) void {
+        const stage = self.stages.items[index];
+        const is_last = index + 1 == self.stages.items.len;
+        var out = Output{
+            .runner = self,
+            .ring = if (is_last) null else &self.queues[index],
+            .stats = &self.stage_stats[index],
+            .queue_stats = if (is_last) null else &self.queue_stats[index],
+        };
+
+        if (stage.source_fn) |source_fn| {
+            self.runSource(stage, source_fn, &out) catch |err| self.fail(err);
+        } else {
+            self.runProcessor(index, stage, &out) catch |err| self.fail(err);
+        }
+
+        // Signal end of stream downstream, even on failure, so nobody waits forever
+        if (!is_last) self.producer_done[index].store(true, .release);
+    }
+
+    fn runSource(self: *PipelineRunner, stage: Stage, source_fn: SourceFn, out: *Output) !void {
+        var timer = try std.time.Timer.start();
+        while (!self.aborted.load(.acquire)) {
+            out.blocked_ns = 0;
+            timer.reset();
+            const more = try source_fn(stage.ctx, out);
+            const elapsed = timer.read();
+            out.stats.blocked_ns += out.blocked_ns;
+            out.stats.busy_ns += elapsed -| out.blocked_ns;
+            if (!more) break;
+        }
+    }
+
+    fn runProcessor(self: *PipelineRunner, index: usize, stage: Stage, out: *Output) !void {
+        const process_fn = stage.process_fn orelse return error.MissingProcessFn;
+        const input = &self.queues[index - 1];
+        const input_done = &self.producer_done[index - 1];
+
+        var timer = try std.time.Timer.start();
+        var spins: u32 = 0;
+        var idle_since: ?u64 = null;
+        var clock = try std.time.Timer.start();
+
+        while (true) {
+            const item = input.tryPop() orelse {
+                if (input_done.load(.acquire)) {
+                    // Re-check after observing the flag: the producer may have pushed just before setting it
+                    if (input.tryPop()) |late| {
+                        try self.processOne(stage, process_fn, late, out, &timer);
+                        continue;
+                    }
+                    break;
+                }
+                if (idle_since == null) idle_since = clock.read();
+                backoff(&spins, self.config.spin_limit);
+                continue;
+            };
+
+            if (idle_since) |since| {
+                out.stats.idle_ns += clock.read() - since;
+                idle_since = null;
+            }
+            spins = 0;
+
+            if (self.aborted.load(.acquire)) {
+                // Drain without processing so upstream epochs get released
+                if (item.epoch) |epoch| epoch.release();
+                continue;
+            }
+            try self.processOne(stage, process_fn, item, out, &timer);
+        }
+
+        if (idle_since) |since| out.stats.idle_ns += clock.read() - since;
+
+        if (stage.flush_fn) |flush_fn| {
+            if (!self.aborted.load(.acquire)) {
+                out.blocked_ns = 0;
+                timer.reset();
+                try flush_fn(stage.ctx, out);
+                out.stats.blocked_ns += out.blocked_ns;
+                out.stats.busy_ns += timer.read() -| out.blocked_ns;
+            }
+        }
+    }
+
+    fn processOne(
+        self: *PipelineRunner,
+        stage: Stage,
+        process_fn: ProcessFn,
+        item: Descriptor,
+        out: *Output,
+        timer: *std.time.Timer,
+    ) !void {
+        _ = self;
+        defer if (item.epoch) |epoch| epoch.release();
+        out.stats.items_in += 1;
+        out.blocked_ns = 0;
+        timer.reset();
+        try process_fn(stage.ctx, item, out);
+        out.stats.blocked_ns += out.blocked_ns;
+        out.stats.busy_ns += timer.read() -| out.blocked_ns;
+        // The last stage has no queue to emit into; what it consumes is its output
+        if (out.ring == null) out.stats.items_out += 1;
+    }
+};
+
+fn backoff(spins: *u32, spin_limit: u32) void {
+    if (spins.* < spin_limit) {
+        spins.* += 1;
+        std.atomic.spinLoopHint();
+    } else {
+        std.Thread.yield() catch {};
+    }
+}
+
+//
+// Built-in stages
+//
+
+/// Read stage over an in-memory ByteStream. Emits zero-copy views of the
+/// stream content in `chunk_size` pieces; line/column tracking is not updated.
+pub const ByteStreamSource = struct {
+    stream: *ByteStream,
+    chunk_size: usize,
+
+    pub fn init(stream: *ByteStream, chunk_size: usize) ByteStreamSource {
+        return .{ .stream = stream, .chunk_size = @max(chunk_size, 1) };
+    }
+
+    pub fn source(ctx: ?*anyopaque, out: *Output) anyerror!bool {
+        const self: *ByteStreamSource = @ptrCast(@alignCast(ctx.?));
+        const content = self.stream.content;
+        if (self.stream.position >= content.len) {
+            self.stream.exhausted = true;
+            return false;
+        }
+        const len = @min(self.chunk_size, content.len - self.stream.position);
+        const chunk = content[self.stream.position..][0..len];
+        self.stream.position += len;
+        try out.emit(.{ .data = chunk });
+        return true;
+    }
+};
+
+/// Read stage over any reader with a `read([]u8) !usize` method.
+/// Every chunk gets its own buffer, pinned by an epoch and freed once the
+/// last descriptor referencing it has been processed downstream.
+pub fn ReaderSource(comptime Reader: type) type {
+    return struct {
+        const Self = @This();
+
+        allocator: std.mem.Allocator,
+        reader: Reader,
+        chunk_size: usize,
+
+        pub fn init(allocator: std.mem.Allocator, reader: Reader, chunk_size: usize) Self {
+            return .{ .allocator = allocator, .reader = reader, .chunk_size = @max(chunk_size, 1) };
+        }
+
+        pub fn source(ctx: ?*anyopaque, out: *Output) anyerror!bool {
+            const self: *Self = @ptrCast(@alignCast(ctx.?));
+            const buffer = try self.allocator.alloc(u8, self.chunk_size);
+            const len = self.reader.read(buffer) catch |err| {
+                self.allocator.free(buffer);
+                return err;
+            };
+            if (len == 0) {
+                self.allocator.free(buffer);
+                return false;
+            }
+            const epoch = ChunkEpoch.create(self.allocator, buffer, 0, freeBuffer, self) catch |err| {
+                self.allocator.free(buffer);
+                return err;
+            };
+            try out.emit(.{ .data = buffer[0..len], .epoch = epoch });
+            return true;
+        }
+
+        fn freeBuffer(bytes: []const u8, ctx: ?*anyopaque) void {
+            const self: *Self = @ptrCast(@alignCast(ctx.?));
+            self.allocator.free(@constCast(bytes));
+        }
+    };
+}
+
+/// Identity stage, the default for the decompress slot
+pub fn passthrough(ctx: ?*anyopaque, item: Descriptor, out: *Output) anyerror!void {
+    _ = ctx;
+    try out.emitView(item, item.data, item.tag);
+}
+
+/// Tag of a byte no pattern matches, emitted by `TokenizeStage` on its own
+pub const unknown_tag: u32 = std.math.maxInt(u32);
+
+/// Tokenize stage: turns byte chunks into token descriptors (tag = token type).
+/// A token that touches the end of a chunk may continue in the next one, so it
+/// is held back and re-matched together with the start of the next chunk.
+/// Bytes no pattern matches are passed on one at a time as `unknown_tag`, so
+/// the descriptors always cover the whole input.
+pub fn TokenizeStage(comptime TokenType: type, comptime patterns: anytype) type {
+    return struct {
+        const Self = @This();
+
+        allocator: std.mem.Allocator,
+        /// Bytes of the held-back token
+        carry: std.ArrayList(u8),
+        /// How far into the next chunk to look when completing a held-back token;
+        /// longer tokens that straddle a boundary are split at this length
+        max_token_len: usize,
+
+        pub fn init(allocator: std.mem.Allocator, max_token_len: usize) Self {
+            return .{
+                .allocator = allocator,
+                .carry = std.ArrayList(u8).init(allocator),
+                .max_token_len = @max(max_token_len, 1),
+            };
+        }
+
+        pub fn deinit(self: *Self) void {
+            self.carry.deinit();
+        }
+
+        pub fn process(ctx: ?*anyopaque, item: Descriptor, out: *Output) anyerror!void {
+            const self: *Self = @ptrCast(@alignCast(ctx.?));
+            var chunk_pos: usize = 0;
+
+            if (self.carry.items.len != 0) {
+                chunk_pos = try self.completeCarry(item.data, out);
+                if (chunk_pos == item.data.len) return; // Whole chunk absorbed into the carried token
+            }
+
+            var stream = TokenStream.init(item.data[chunk_pos..]);
+            while (!stream.isAtEnd()) {
+                var text: []const u8 = undefined;
+                var tag: u32 = unknown_tag;
+                if (stream.next(TokenType, patterns)) |token| {
+                    text = token.text;
+                    tag = @intFromEnum(token.type);
+                } else {
+                    // No pattern matched here, but one may once the next chunk arrives
+                    text = stream.advance(1);
+                }
+                if (stream.isAtEnd()) {
+                    // May continue in the next chunk
+                    try self.carry.appendSlice(text);
+                    return;
+                }
+                try out.emitView(item, text, tag);
+            }
+        }
+
+        pub fn flush(ctx: ?*anyopaque, out: *Output) anyerror!void {
+            const self: *Self = @ptrCast(@alignCast(ctx.?));
+            if (self.carry.items.len == 0) return;
+            try self.emitJoined(self.carry.items, out);
+            self.carry.clearRetainingCapacity();
+        }
+
+        /// Re-matches the carried token against carry ++ head of `chunk`.
+        /// Returns how many bytes of `chunk` were consumed.
+        fn completeCarry(self: *Self, chunk: []const u8, out: *Output) !usize {
+            const carry_len = self.carry.items.len;
+            const look = @min(chunk.len, self.max_token_len);
+            try self.carry.appendSlice(chunk[0..look]);
+
+            var stream = TokenStream.init(self.carry.items);
+            const token = stream.next(TokenType, patterns);
+            const token_len = if (token) |t| t.text.len else carry_len;
+
+            if (token_len >= self.carry.items.len and look == chunk.len) {
+                // Still running at the end of this chunk too: keep carrying
+                return chunk.len;
+            }
+
+            const end = @max(token_len, carry_len);
+            try self.emitJoined(self.carry.items[0..end], out);
+            self.carry.clearRetainingCapacity();
+            return end - carry_len;
+        }
+
+        /// Emits a token assembled from several chunks; it gets its own buffer and epoch
+        fn emitJoined(self: *Self, bytes: []const u8, out: *Output) !void {
+            var stream = TokenStream.init(bytes);
+            const tag: u32 = if (stream.next(TokenType, patterns)) |t| @intFromEnum(t.type) else unknown_tag;
+
+            const owned = try self.allocator.dupe(u8, bytes);
+            const epoch = ChunkEpoch.create(self.allocator, owned, 0, freeOwned, self) catch |err| {
+                self.allocator.free(owned);
+                return err;
+            };
+            try out.emit(.{ .data = owned, .tag = tag, .epoch = epoch });
+        }
+
+        fn freeOwned(bytes: []const u8, ctx: ?*anyopaque) void {
+            const self: *Self = @ptrCast(@alignCast(ctx.?));
+            self.allocator.free(@constCast(bytes));
+        }
+    };
+}
+
+/// Parse stage: feeds byte chunks to a FormatEngine and emits its events as
+/// descriptors (tag = event type). Event flags are not carried. Payloads that
+/// lie in the incoming chunk are emitted as views of it; those assembled from
+/// bytes the engine held back across chunks get their own buffer and epoch.
+/// A syntax error is emitted as an ERROR descriptor and then fails the run.
+pub const ParseStage = struct {
+    allocator: std.mem.Allocator,
+    engine: FormatEngine,
+
+    pub fn init(allocator: std.mem.Allocator, format: format_engine.Format, options: format_engine.Options) ParseStage {
+        return .{
+            .allocator = allocator,
+            .engine = FormatEngine.init(allocator, format, options),
+        };
+    }
+
+    pub fn deinit(self: *ParseStage) void {
+        self.engine.deinit();
+    }
+
+    pub fn process(ctx: ?*anyopaque, item: Descriptor, out: *Output) anyerror!void {
+        const self: *ParseStage = @ptrCast(@alignCast(ctx.?));
+        var sink = Sink{ .stage = self, .out = out, .parent = item };
+        try self.engine.feed(item.data, &sink);
+    }
+
+    pub fn flush(ctx: ?*anyopaque, out: *Output) anyerror!void {
+        const self: *ParseStage = @ptrCast(@alignCast(ctx.?));
+        var sink = Sink{ .stage = self, .out = out, .parent = null };
+        try self.engine.finish(&sink);
+    }
+
+    const Sink = struct {
+        stage: *ParseStage,
+        out: *Output,
+        /// Chunk being fed; null while finishing
+        parent: ?Descriptor,
+
+        pub fn event(self: *Sink, ev: FormatEvent) !void {
+            const tag: u32 = @intFromEnum(ev.type);
+            // Empty and detached payloads are static strings
+            if (ev.data.len == 0 or ev.flags & format_engine.flags.detached != 0) {
+                return self.out.emit(.{ .data = ev.data, .tag = tag });
+            }
+            if (self.parent) |parent| {
+                const start = @intFromPtr(parent.data.ptr);
+                const ptr = @intFromPtr(ev.data.ptr);
+                if (ptr >= start and ptr + ev.data.len <= start + parent.data.len) {
+                    return self.out.emitView(parent, ev.data, tag);
+                }
+            }
+
+            const allocator = self.stage.allocator;
+            const owned = try allocator.dupe(u8, ev.data);
+            const epoch = ChunkEpoch.create(allocator, owned, 0, freeOwned, self.stage) catch |err| {
+                allocator.free(owned);
+                return err;
+            };
+            try self.out.emit(.{ .data = owned, .tag = tag, .epoch = epoch });
+        }
+    };
+
+    fn freeOwned(bytes: []const u8, ctx: ?*anyopaque) void {
+        const self: *ParseStage = @ptrCast(@alignCast(ctx.?));
+        self.allocator.free(@constCast(bytes));
+    }
+};
+
+/// Handle stage: delivers descriptors to an EventEmitter.
+/// The descriptor tag is interpreted as an EventType; payloads become `string_value`.
+pub const EmitterSink = struct {
+    emitter: *EventEmitter,
+
+    pub fn init(emitter: *EventEmitter) EmitterSink {
+        return .{ .emitter = emitter };
+    }
+
+    pub fn process(ctx: ?*anyopaque, item: Descriptor, out: *Output) anyerror!void {
+        _ = out;
+        const self: *EmitterSink = @ptrCast(@alignCast(ctx.?));
+        const event_type = std.meta.intToEnum(EventType, item.tag) catch EventType.VALUE;
+        var event = Event.init(event_type, Position.init(item.seq, 0, 0));
+        switch (event_type) {
+            .ERROR => event.data = .{ .error_info = .{ .message = item.data } },
+            else => event.data = .{ .string_value = item.data },
+        }
+        try self.emitter.emit(event);
+    }
+};
+
+test "pipeline tokenizes across chunk boundaries with backpressure" {
+    const pattern = @import("pattern.zig");
+    const Token = enum { word, number, whitespace };
+    const patterns = comptime .{
+        .word = pattern.match.alpha.oneOrMore(),
+        .number = pattern.match.digit.oneOrMore(),
+        .whitespace = pattern.match.whitespace.oneOrMore(),
+    };
+
+    const Collector = struct {
+        words: usize = 0,
+        numbers: usize = 0,
+        saw_split_word: bool = false,
+
+        fn process(ctx: ?*anyopaque, item: Descriptor, out: *Output) anyerror!void {
+            _ = out;
+            const self: *@This() = @ptrCast(@alignCast(ctx.?));
+            switch (@as(Token, @enumFromInt(item.tag))) {
+                .word => {
+                    self.words += 1;
+                    if (std.mem.eql(u8, item.data, "streaming")) self.saw_split_word = true;
+                },
+                .number => self.numbers += 1,
+                .whitespace => {},
+            }
+        }
+    };
+
+    const input = "alpha 12 streaming 345 omega " ** 20;
+    var stream = try ByteStream.init(std.testing.allocator, input, 0);
+    defer stream.deinit();
+
+    var source = ByteStreamSource.init(&stream, 7);
+    const Tokenizer = TokenizeStage(Token, patterns);
+    var tokenizer = Tokenizer.init(std.testing.allocator, 64);
+    defer tokenizer.deinit();
+    var collector = Collector{};
+
+    var runner = PipelineRunner.init(std.testing.allocator, .{ .queue_capacity = 2 });
+    defer runner.deinit();
+    try runner.addSource("read", &source, ByteStreamSource.source);
+    try runner.addStage("decompress", null, passthrough, null);
+    try runner.addStage("tokenize", &tokenizer, Tokenizer.process, Tokenizer.flush);
+    try runner.addStage("handle", &collector, Collector.process, null);
+
+    const report = try runner.run();
+
+    try std.testing.expectEqual(@as(usize, 60), collector.words);
+    try std.testing.expectEqual(@as(usize, 40), collector.numbers);
+    try std.testing.expect(collector.saw_split_word);
+    try std.testing.expectEqual(@as(usize, 4), report.stages.len);
+    try std.testing.expectEqual(@as(usize, 3), report.queues.len);
+    try std.testing.expect(report.queues[0].max_depth <= report.queues[0].capacity);
+    try std.testing.expect(report.bottleneck() != null);
+}
+
+test "pipeline tokenize stage passes unmatched bytes on as unknown tokens" {
+    const pattern = @import("pattern.zig");
+    const Token = enum { word, number, whitespace };
+    const patterns = comptime .{
+        .word = pattern.match.alpha.oneOrMore(),
+        .number = pattern.match.digit.oneOrMore(),
+        .whitespace = pattern.match.whitespace.oneOrMore(),
+    };
+
+    const Collector = struct {
+        text: std.ArrayList(u8),
+        unknown: usize = 0,
+
+        fn process(ctx: ?*anyopaque, item: Descriptor, out: *Output) anyerror!void {
+            _ = out;
+            const self: *@This() = @ptrCast(@alignCast(ctx.?));
+            if (item.tag == unknown_tag) self.unknown += 1;
+            try self.text.appendSlice(item.data);
+        }
+    };
+
+    const input = "a+b = 12; x!!y " ** 10;
+    var stream = try ByteStream.init(std.testing.allocator, input, 0);
+    defer stream.deinit();
+
+    var source = ByteStreamSource.init(&stream, 3);
+    const Tokenizer = TokenizeStage(Token, patterns);
+    var tokenizer = Tokenizer.init(std.testing.allocator, 64);
+    defer tokenizer.deinit();
+    var collector = Collector{ .text = std.ArrayList(u8).init(std.testing.allocator) };
+    defer collector.text.deinit();
+
+    var runner = PipelineRunner.init(std.testing.allocator, .{ .queue_capacity = 2 });
+    defer runner.deinit();
+    try runner.addSource("read", &source, ByteStreamSource.source);
+    try runner.addStage("tokenize", &tokenizer, Tokenizer.process, Tokenizer.flush);
+    try runner.addStage("handle", &collector, Collector.process, null);
+    const report = try runner.run();
+
+    // Nothing is dropped: '+', '=', ';' and both '!' of every repetition arrive
+    try std.testing.expectEqualStrings(input, collector.text.items);
+    try std.testing.expectEqual(@as(usize, 50), collector.unknown);
+    try std.testing.expectEqual(report.stages[1].items_out, report.stages[2].items_in);
+}
+
+test "pipeline parses JSON split across chunks into emitter events" {
+    const Collector = struct {
+        counts: [std.meta.fields(EventType).len]usize = [_]usize{0} ** std.meta.fields(EventType).len,
+        split_names: usize = 0,
+
+        fn handle(event: Event, ctx: ?*anyopaque) !void {
+            const self: *@This() = @ptrCast(@alignCast(ctx.?));
+            self.counts[@intFromEnum(event.type)] += 1;
+            if (event.type == .VALUE and std.mem.eql(u8, event.data.string_value, "streaming")) self.split_names += 1;
+        }
+    };
+
+    const input = "[" ++ "{\"id\": 12345, \"name\": \"streaming\"}, " ** 20 ++ "{\"id\": 0, \"name\": \"end\"}]";
+    var stream = try ByteStream.init(std.testing.allocator, input, 0);
+    defer stream.deinit();
+
+    var source = ByteStreamSource.init(&stream, 7);
+    var parser = ParseStage.init(std.testing.allocator, .json, .{});
+    defer parser.deinit();
+    var collector = Collector{};
+    var emitter = EventEmitter.init(std.testing.allocator);
+    emitter.setHandler(event_emitter.EventHandler.init(Collector.handle, &collector));
+    var sink = EmitterSink.init(&emitter);
+
+    var runner = PipelineRunner.init(std.testing.allocator, .{ .queue_capacity = 4 });
+    defer runner.deinit();
+    try runner.addSource("read", &source, ByteStreamSource.source);
+    try runner.addStage("parse", &parser, ParseStage.process, ParseStage.flush);
+    try runner.addStage("handle", &sink, EmitterSink.process, null);
+
+    const report = try runner.run();
+
+    // 21 objects in one array; every key and value is a VALUE event
+    try std.testing.expectEqual(@as(usize, 1), collector.counts[@intFromEnum(EventType.START_DOCUMENT)]);
+    try std.testing.expectEqual(@as(usize, 22), collector.counts[@intFromEnum(EventType.START_ELEMENT)]);
+    try std.testing.expectEqual(@as(usize, 22), collector.counts[@intFromEnum(EventType.END_ELEMENT)]);
+    try std.testing.expectEqual(@as(usize, 84), collector.counts[@intFromEnum(EventType.VALUE)]);
+    try std.testing.expectEqual(@as(usize, 1), collector.counts[@intFromEnum(EventType.END_DOCUMENT)]);
+    try std.testing.expectEqual(@as(usize, 20), collector.split_names);
+
+    // The runner counts what the last stage consumed as its output
+    try std.testing.expectEqual(@as(u64, 130), report.stages[1].items_out);
+    try std.testing.expectEqual(@as(u64, 130), report.stages[2].items_in);
+    try std.testing.expectEqual(@as(u64, 130), report.stages[2].items_out);
+}
+
+test "pipeline parse stage fails the run on malformed input" {
+    const input = "{\"a\": 1 \"b\": 2}";
+    var stream = try ByteStream.init(std.testing.allocator, input, 0);
+    defer stream.deinit();
+
+    var source = ByteStreamSource.init(&stream, 4);
+    var parser = ParseStage.init(std.testing.allocator, .json, .{});
+    defer parser.deinit();
+
+    var runner = PipelineRunner.init(std.testing.allocator, .{});
+    defer runner.deinit();
+    try runner.addSource("read", &source, ByteStreamSource.source);
+    try runner.addStage("parse", &parser, ParseStage.process, ParseStage.flush);
+    try std.testing.expectError(error.UnexpectedToken, runner.run());
+}
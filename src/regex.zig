@@ -0,0 +1,318 @@
+const std = @import("std");
+const char_class = @import("char_class.zig");
+const pattern = @import("pattern.zig");
+
+const Pattern = pattern.Pattern;
+const ByteSet = char_class.ByteSet;
+
+/// Largest count accepted in `{n,m}`; each repeat is a copy of the pattern
+pub const max_repeat = 255;
+
+pub const Error = error{ InvalidRegex, OutOfMemory };
+
+/// Where and why a runtime parse failed
+pub const Diagnostic = struct {
+    pos: usize = 0,
+    message: [:0]const u8 = "",
+    /// Index of the failing source, for callers that parse a list of them
+    source: usize = 0,
+};
+
+/// Parses a regular expression at comptime into a Pattern, lowered to the
+/// same combinators `match` builds, so the optimizer and the automaton
+/// engines see no difference between the two.
+///
+/// Supported: literals and escapes (`\n \t \r \f \v \0 \xHH`, escaped
+/// metacharacters), `.` (any byte but newline), classes `[a-z_]`, `[^"\\]`
+/// with `\d \w \s` and their negations inside or outside, groups `(...)` and
+/// `(?:...)`, alternation `|`, and the repeats `* + ? {n} {n,} {n,m}`.
+/// Patterns are anchored at the token position and match the longest
+/// prefix, so anchors, lazy repeats, backreferences and lookaround are
+/// rejected at compile time.
+pub fn parse(comptime source: []const u8) Pattern {
+    comptime {
+        @setEvalBranchQuota(1_000_000);
+        var parser = Parser{ .source = source };
+        return parser.parseAll() catch
+            @compileError(std.fmt.comptimePrint("regex \"{s}\", offset {d}: {s}", .{ source, parser.pos, parser.message }));
+    }
+}
+
+/// Runtime form of `parse`, for grammars that arrive at runtime. Pattern
+/// nodes are allocated in `arena`; free them all together.
+pub fn parseAlloc(arena: std.mem.Allocator, source: []const u8, diagnostic: ?*Diagnostic) Error!Pattern {
+    var parser = Parser{ .source = source, .arena = arena };
+    return parser.parseAll() catch |err| {
+        if (diagnostic) |d| d.* = .{ .pos = parser.pos, .message = parser.message };
+        return err;
+    };
+}
+
+/// Recursive-descent parser shared by both forms. Node storage differs:
+/// comptime parses freeze values in place, runtime parses use the arena.
+const Parser = struct {
+    source: []const u8,
+    pos: usize = 0,
+    arena: ?std.mem.Allocator = null,
+    message: [:0]const u8 = "",
+
+    fn fail(self: *Parser, message: [:0]const u8) Error {
+        self.message = message;
+        return error.InvalidRegex;
+    }
+
+    fn parseAll(self: *Parser) Error!Pattern {
+        const result = try self.alternation();
+        if (self.pos < self.source.len) return self.fail("unmatched ')'");
+        return result;
+    }
+
+    fn peek(self: *const Parser) ?u8 {
+        return if (self.pos < self.source.len) self.source[self.pos] else null;
+    }
+
+    fn eat(self: *Parser, c: u8) bool {
+        if (self.peek() != c) return false;
+        self.pos += 1;
+        return true;
+    }
+
+    fn take(self: *Parser) Error!u8 {
+        const c = self.peek() orelse return self.fail("unexpected end");
+        self.pos += 1;
+        return c;
+    }
+
+    fn ref(self: *Parser, p: Pattern) Error!*const Pattern {
+        if (@inComptime()) {
+            const frozen = p;
+            return &frozen;
+        }
+        const node = try self.arena.?.create(Pattern);
+        node.* = p;
+        return node;
+    }
+
+    fn append(self: *Parser, list: []const Pattern, p: Pattern) Error![]const Pattern {
+        if (@inComptime()) return list ++ &[_]Pattern{p};
+        const grown = try self.arena.?.alloc(Pattern, list.len + 1);
+        @memcpy(grown[0..list.len], list);
+        grown[list.len] = p;
+        return grown;
+    }
+
+    /// alternation := concat ('|' concat)*
+    fn alternation(self: *Parser) Error!Pattern {
+        var alternatives = try self.append(&.{}, try self.concat());
+        while (self.eat('|')) alternatives = try self.append(alternatives, try self.concat());
+        if (alternatives.len == 1) return alternatives[0];
+        return .{ .alternation = alternatives };
+    }
+
+    /// concat := repeat*
+    fn concat(self: *Parser) Error!Pattern {
+        var parts: []const Pattern = &.{};
+        while (self.peek()) |c| {
+            if (c == '|' or c == ')') break;
+            parts = try self.append(parts, try self.repeat());
+        }
+        return sequence(parts);
+    }
+
+    /// repeat := atom ('*' | '+' | '?' | '{' bounds '}')*
+    fn repeat(self: *Parser) Error!Pattern {
+        var result = try self.atom();
+        while (self.peek()) |c| {
+            switch (c) {
+                '*' => result = .{ .zero_or_more = try self.ref(result) },
+                '+' => result = .{ .one_or_more = try self.ref(result) },
+                '?' => result = .{ .optional_pattern = try self.ref(result) },
+                '{' => {
+                    self.pos += 1;
+                    const min = try self.count();
+                    const max: ?usize = if (!self.eat(',')) min else if (self.peek() == '}') null else try self.count();
+                    if (!self.eat('}')) return self.fail("expected '}'");
+                    if (max != null and max.? < min) return self.fail("repeat bounds out of order");
+                    result = try self.bounded(result, min, max);
+                    try self.lazyCheck();
+                    continue;
+                },
+                else => break,
+            }
+            self.pos += 1;
+            try self.lazyCheck();
+        }
+        return result;
+    }
+
+    fn lazyCheck(self: *Parser) Error!void {
+        if (self.peek() == '?') return self.fail("lazy repeats are not supported: patterns match the longest prefix");
+    }
+
+    fn count(self: *Parser) Error!usize {
+        const start = self.pos;
+        while (self.peek()) |c| {
+            if (c < '0' or c > '9') break;
+            self.pos += 1;
+        }
+        if (self.pos == start) return self.fail("expected a repeat count");
+        const n = std.fmt.parseInt(usize, self.source[start..self.pos], 10) catch return self.fail("repeat count too large");
+        if (n > max_repeat) return self.fail("repeat count above max_repeat");
+        return n;
+    }
+
+    /// `p` repeated `min` to `max` times (unbounded for null): `min` copies,
+    /// then nested optionals, so x{2,4} is `x x (x x?)?`
+    fn bounded(self: *Parser, p: Pattern, min: usize, max: ?usize) Error!Pattern {
+        var parts: []const Pattern = &.{};
+        for (0..min) |_| parts = try self.append(parts, p);
+        if (max) |limit| {
+            var tail: ?Pattern = null;
+            for (0..limit - min) |_| {
+                const body = if (tail) |rest| sequence(try self.append(try self.append(&.{}, p), rest)) else p;
+                tail = .{ .optional_pattern = try self.ref(body) };
+            }
+            if (tail) |rest| parts = try self.append(parts, rest);
+        } else {
+            parts = try self.append(parts, .{ .zero_or_more = try self.ref(p) });
+        }
+        return sequence(parts);
+    }
+
+    /// atom := '(' alternation ')' | '[' class ']' | '.' | escape | byte
+    fn atom(self: *Parser) Error!Pattern {
+        const c = try self.take();
+        switch (c) {
+            '(' => {
+                if (self.eat('?') and !self.eat(':')) return self.fail("only (?:...) groups are supported");
+                const inner = try self.alternation();
+                if (!self.eat(')')) return self.fail("expected ')'");
+                return inner;
+            },
+            '[' => return .{ .byte_set = try self.class() },
+            '.' => return .{ .byte_set = ByteSet.of("\n").negate() },
+            '\\' => return .{ .byte_set = try self.escape() },
+            '^', '$' => return self.fail("anchors are not supported: patterns are matched at the token position"),
+            '*', '+', '?', '{' => return self.fail("nothing to repeat"),
+            // One-byte sets; the optimizer merges runs of them into literals
+            else => return .{ .byte_set = ByteSet.of(&[_]u8{c}) },
+        }
+    }
+
+    /// Set of a `[...]` class; the opening bracket is consumed
+    fn class(self: *Parser) Error!ByteSet {
+        const negated = self.eat('^');
+        var set = ByteSet.empty();
+        var first = true;
+        while (true) : (first = false) {
+            const c = self.peek() orelse return self.fail("unterminated class");
+            if (c == ']' and !first) break;
+            const lo = try self.classByte();
+            // A '-' before ']' is a literal dash
+            if (self.peek() == '-' and self.pos + 1 < self.source.len and self.source[self.pos + 1] != ']') {
+                self.pos += 1;
+                const hi = try self.classByte();
+                if (lo.count() != 1 or hi.count() != 1) return self.fail("class ranges need single-byte ends");
+                const min: u8 = @intCast(lo.bits.findFirstSet().?);
+                const max: u8 = @intCast(hi.bits.findFirstSet().?);
+                if (max < min) return self.fail("class range out of order");
+                set = set.unionWith(ByteSet.range(min, max));
+            } else {
+                set = set.unionWith(lo);
+            }
+        }
+        self.pos += 1;
+        return if (negated) set.negate() else set;
+    }
+
+    fn classByte(self: *Parser) Error!ByteSet {
+        const c = try self.take();
+        if (c == '\\') return self.escape();
+        return ByteSet.of(&[_]u8{c});
+    }
+
+    /// Set of an escape; the backslash is consumed
+    fn escape(self: *Parser) Error!ByteSet {
+        const c = try self.take();
+        const word = ByteSet.range('a', 'z').unionWith(ByteSet.range('A', 'Z'))
+            .unionWith(ByteSet.range('0', '9')).unionWith(ByteSet.of("_"));
+        const space = ByteSet.of(" \t\n\r\x0B\x0C");
+        return switch (c) {
+            'd' => ByteSet.range('0', '9'),
+            'D' => ByteSet.range('0', '9').negate(),
+            'w' => word,
+            'W' => word.negate(),
+            's' => space,
+            'S' => space.negate(),
+            'n' => ByteSet.of("\n"),
+            't' => ByteSet.of("\t"),
+            'r' => ByteSet.of("\r"),
+            'f' => ByteSet.of("\x0C"),
+            'v' => ByteSet.of("\x0B"),
+            '0' => ByteSet.of("\x00"),
+            'x' => blk: {
+                if (self.pos + 2 > self.source.len) return self.fail("\\x needs two hex digits");
+                const byte = std.fmt.parseInt(u8, self.source[self.pos..][0..2], 16) catch return self.fail("\\x needs two hex digits");
+                self.pos += 2;
+                break :blk ByteSet.of(&[_]u8{byte});
+            },
+            'a'...'c', 'e', 'g'...'m', 'o'...'q', 'u', 'y', 'z', 'A'...'C', 'E'...'R', 'T'...'V', 'X'...'Z', '1'...'9' => return self.fail("unsupported escape"),
+            else => ByteSet.of(&[_]u8{c}),
+        };
+    }
+};
+
+fn sequence(parts: []const Pattern) Pattern {
+    return switch (parts.len) {
+        0 => .{ .literal = "" },
+        1 => parts[0],
+        else => .{ .sequence = parts },
+    };
+}
+
+test "regex identifier lowers to a set and a repeat" {
+    const ident = comptime parse("[A-Za-z_][A-Za-z0-9_]*");
+    try std.testing.expect(ident == .sequence);
+    try std.testing.expect(ident.sequence[0].byte_set.contains('_'));
+    try std.testing.expect(!ident.sequence[0].byte_set.contains('7'));
+    try std.testing.expect(ident.sequence[1].zero_or_more.byte_set.contains('7'));
+
+    const Ident = @import("pattern_ir.zig").Compiled(ident);
+    try std.testing.expectEqual(pattern.MatchResult{ .matched = true, .len = 5 }, Ident.match("foo_1 bar", 0));
+    try std.testing.expect(!Ident.match("1abc", 0).matched);
+}
+
+test "regex alternation, groups and bounded repeats" {
+    const Compiled = @import("pattern_ir.zig").Compiled;
+    const cases = .{
+        .{ "0x[0-9a-fA-F]+|\\d+(\\.\\d+)?([eE][+-]?\\d+)?", "3.14e-2,", 7 },
+        .{ "0x[0-9a-fA-F]+|\\d+(\\.\\d+)?([eE][+-]?\\d+)?", "0x1F;", 4 },
+        .{ "0x[0-9a-fA-F]+|\\d+(\\.\\d+)?([eE][+-]?\\d+)?", "42.", 2 },
+        .{ "\\d{3}-\\d{2,4}", "555-12345", 8 },
+        .{ "\\d{3}-\\d{2,4}", "555-12x", 6 },
+        .{ "\"([^\"\\\\]|\\\\.)*\"", "\"a\\\"b\" x", 6 },
+        .{ "(?:ab|a)*c", "ababac!", 6 },
+        .{ ".*;", "a;b;c\n;", 4 },
+        .{ "[-+]?\\x41{2,}", "-AAAB", 4 },
+    };
+    inline for (cases) |case| {
+        const result = Compiled(comptime parse(case[0])).match(case[1], 0);
+        try std.testing.expect(result.matched);
+        try std.testing.expectEqual(@as(usize, case[2]), result.len);
+    }
+    try std.testing.expect(!Compiled(comptime parse("\\d{3}-\\d{2,4}")).match("555-1", 0).matched);
+}
+
+test "runtime regex parse reports errors" {
+    var arena = std.heap.ArenaAllocator.init(std.testing.allocator);
+    defer arena.deinit();
+
+    const number = try parseAlloc(arena.allocator(), "-?\\d+(\\.\\d+)?", null);
+    try std.testing.expectEqual(pattern.MatchResult{ .matched = true, .len = 5 }, pattern.matchPattern(number, "-3.25;", 0));
+
+    var diagnostic = Diagnostic{};
+    try std.testing.expectError(error.InvalidRegex, parseAlloc(arena.allocator(), "a{3,1}", &diagnostic));
+    try std.testing.expectEqualStrings("repeat bounds out of order", diagnostic.message);
+    try std.testing.expectError(error.InvalidRegex, parseAlloc(arena.allocator(), "(ab", &diagnostic));
+    try std.testing.expectEqual(@as(usize, 3), diagnostic.pos);
+}
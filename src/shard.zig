@@ -0,0 +1,444 @@
+const std = @import("std");
+const CsvConfig = @import("parsers/csv.zig").CsvTokenizer.Config;
+
+/// Byte-range sharding, so independent processes can each parse a slice of
+/// one large file.
+///
+/// `shard(data, k, n)` cuts at `size * k / n` and moves forward to the next
+/// record start. The cut is a pure function of the bytes, so shard k's end is
+/// always shard k+1's start. For CSV the quote state at the cut is unknown.
+/// Both hypotheses (inside or outside a quoted field) are scanned forward
+/// until one of them hits malformed CSV. If neither does within `max_probe`
+/// bytes, the cut assumes "outside" and is marked speculative. Each worker then
+/// scans its range with a `Summarizer`. `verifyBoundaries` checks that the
+/// ranges tile the file and that every shard ended on a real record boundary.
+/// That check also confirms speculative cuts.
+pub const Format = enum {
+    lines,
+    /// One JSON document per line; raw newlines cannot occur inside values
+    ndjson,
+    csv,
+};
+
+pub const Options = struct {
+    format: Format = .lines,
+    csv: CsvConfig = .{},
+    /// CSV: bytes scanned to disambiguate the quote state at a cut
+    max_probe: usize = 256 * 1024,
+};
+
+pub const ShardRange = struct {
+    start: u64,
+    end: u64,
+    /// The start was chosen by the quote heuristic without proof
+    speculative_start: bool = false,
+
+    pub fn len(self: ShardRange) u64 {
+        return self.end - self.start;
+    }
+};
+
+/// Small fixed-size record a worker reports for the merge step
+pub const BoundarySummary = struct {
+    shard: u32,
+    shard_count: u32,
+    start: u64,
+    end: u64,
+    records: u64,
+    /// The range ends on a record boundary (or at EOF) outside any quoted field
+    clean_end: bool,
+    speculative_start: bool,
+    /// CSV bytes that violated quoting rules; expected to be 0
+    anomalies: u64 = 0,
+};
+
+pub const VerifyError = error{
+    MissingShard,
+    ShardGap,
+    UnterminatedShard,
+};
+
+/// Byte range of shard `k` out of `n` within `data`
+pub fn shard(data: []const u8, k: usize, n: usize, options: Options) !ShardRange {
+    var no_buf: [0]u8 = .{};
+    return shardOf(SliceSource{ .data = data }, k, n, options, &no_buf);
+}
+
+/// Byte range of shard `k` out of `n` within `file`, probing with positional reads
+pub fn shardFile(file: std.fs.File, k: usize, n: usize, options: Options) !ShardRange {
+    var buf: [64 * 1024]u8 = undefined;
+    return shardOf(FileSource{ .file = file, .file_size = try file.getEndPos() }, k, n, options, &buf);
+}
+
+/// Shards `data` and scans the range in one go
+pub fn summarize(data: []const u8, k: usize, n: usize, options: Options) !BoundarySummary {
+    const range = try shard(data, k, n, options);
+    var summarizer = Summarizer.init(range, k, n, data.len, options);
+    summarizer.feed(data[@intCast(range.start)..@intCast(range.end)]);
+    return summarizer.finish();
+}
+
+/// Builds a BoundarySummary while a worker streams through its range
+pub const Summarizer = struct {
+    summary: BoundarySummary,
+    format: Format,
+    csv: CsvScanner,
+    total_size: u64,
+    fed: u64 = 0,
+    last: ?u8 = null,
+
+    pub fn init(range: ShardRange, k: usize, n: usize, total_size: u64, options: Options) Summarizer {
+        return .{
+            .summary = .{
+                .shard = @intCast(k),
+                .shard_count = @intCast(n),
+                .start = range.start,
+                .end = range.end,
+                .records = 0,
+                .clean_end = false,
+                .speculative_start = range.speculative_start,
+            },
+            .format = options.format,
+            // Shards start on a record boundary
+            .csv = CsvScanner.init(options.csv, .field_start),
+            .total_size = total_size,
+        };
+    }
+
+    pub fn feed(self: *Summarizer, bytes: []const u8) void {
+        if (bytes.len == 0) return;
+        switch (self.format) {
+            .lines, .ndjson => self.summary.records += std.mem.count(u8, bytes, "\n"),
+            .csv => for (bytes) |c| {
+                if (self.csv.step(c)) self.summary.records += 1;
+                if (self.csv.state == .invalid) {
+                    self.summary.anomalies += 1;
+                    self.csv.state = .unquoted;
+                }
+            },
+        }
+        self.fed += bytes.len;
+        self.last = bytes[bytes.len - 1];
+    }
+
+    pub fn finish(self: *const Summarizer) BoundarySummary {
+        var summary = self.summary;
+        const in_quotes = self.format == .csv and self.csv.inQuotes();
+        const open_record = self.last != null and self.last.? != '\n';
+        const at_eof = summary.end == self.total_size;
+
+        if (open_record and at_eof and !in_quotes) summary.records += 1;
+        summary.clean_end = self.fed == summary.end - summary.start and
+            !in_quotes and (!open_record or at_eof);
+        return summary;
+    }
+};
+
+/// Checks summaries, ordered by shard index, against each other and the file size
+pub fn verifyBoundaries(summaries: []const BoundarySummary, total_size: u64) VerifyError!void {
+    if (summaries.len == 0) return error.MissingShard;
+
+    var expected_start: u64 = 0;
+    for (summaries, 0..) |summary, i| {
+        if (summary.shard != i or summary.shard_count != summaries.len) return error.MissingShard;
+        if (summary.start != expected_start or summary.end < summary.start) return error.ShardGap;
+        // A speculative cut is confirmed by the previous shard ending cleanly on it
+        if (!summary.clean_end) return error.UnterminatedShard;
+        expected_start = summary.end;
+    }
+    if (expected_start != total_size) return error.ShardGap;
+}
+
+const Resync = struct {
+    offset: u64,
+    speculative: bool = false,
+};
+
+const SliceSource = struct {
+    data: []const u8,
+
+    fn size(self: SliceSource) u64 {
+        return self.data.len;
+    }
+
+    fn window(self: SliceSource, offset: u64, buf: []u8) error{}![]const u8 {
+        _ = buf;
+        return self.data[@intCast(offset)..];
+    }
+};
+
+const FileSource = struct {
+    file: std.fs.File,
+    file_size: u64,
+
+    fn size(self: FileSource) u64 {
+        return self.file_size;
+    }
+
+    fn window(self: FileSource, offset: u64, buf: []u8) ![]const u8 {
+        const n = try self.file.pread(buf, offset);
+        return buf[0..n];
+    }
+};
+
+fn shardOf(source: anytype, k: usize, n: usize, options: Options, buf: []u8) !ShardRange {
+    if (n == 0 or k >= n) return error.InvalidShard;
+    const size = source.size();
+
+    const start = try recordStart(source, nominalCut(size, k, n), options, buf);
+    const end = if (k + 1 == n) size else (try recordStart(source, nominalCut(size, k + 1, n), options, buf)).offset;
+    return .{
+        .start = start.offset,
+        .end = @max(start.offset, end),
+        .speculative_start = start.speculative,
+    };
+}
+
+fn nominalCut(size: u64, k: usize, n: usize) u64 {
+    return @intCast(@as(u128, size) * k / n);
+}
+
+fn recordStart(source: anytype, pos: u64, options: Options, buf: []u8) !Resync {
+    if (pos == 0) return .{ .offset = 0 };
+    return switch (options.format) {
+        .lines, .ndjson => .{ .offset = try nextLineStart(source, pos, buf) },
+        .csv => csvRecordStart(source, pos, options, buf),
+    };
+}
+
+/// First offset >= pos that directly follows a newline
+fn nextLineStart(source: anytype, pos: u64, buf: []u8) !u64 {
+    var offset = pos - 1;
+    while (offset < source.size()) {
+        const bytes = try source.window(offset, buf);
+        if (bytes.len == 0) break;
+        if (std.mem.indexOfScalar(u8, bytes, '\n')) |i| return offset + i + 1;
+        offset += bytes.len;
+    }
+    return source.size();
+}
+
+fn csvRecordStart(source: anytype, pos: u64, options: Options, buf: []u8) !Resync {
+    const Hypothesis = struct {
+        scanner: CsvScanner,
+        boundary: ?u64 = null,
+        alive: bool = true,
+    };
+
+    const prev = (try source.window(pos - 1, buf[0..@min(buf.len, 1)]))[0];
+    const escaped = try endsInEscape(source, pos, options.csv, buf);
+    var hyps = [2]Hypothesis{
+        .{ .scanner = CsvScanner.init(options.csv, CsvScanner.entryState(options.csv, prev, false, escaped)) },
+        .{ .scanner = CsvScanner.init(options.csv, CsvScanner.entryState(options.csv, prev, true, escaped)) },
+    };
+
+    var offset = pos;
+    const limit = @min(source.size(), pos +| options.max_probe);
+    scan: while (offset < limit) {
+        const bytes = try source.window(offset, buf);
+        if (bytes.len == 0) break;
+        for (bytes[0..@min(bytes.len, @as(usize, @intCast(limit - offset)))], 0..) |c, i| {
+            for (&hyps) |*hyp| {
+                if (!hyp.alive) continue;
+                if (hyp.scanner.step(c) and hyp.boundary == null) hyp.boundary = offset + i + 1;
+                if (hyp.scanner.state == .invalid) hyp.alive = false;
+            }
+            if (!hyps[0].alive and !hyps[1].alive) break :scan;
+            for (hyps) |hyp| {
+                // The other hypothesis is refuted and this one found a record start
+                if (hyp.alive and hyp.boundary != null and !(hyps[0].alive and hyps[1].alive)) {
+                    return .{ .offset = hyp.boundary.? };
+                }
+            }
+        }
+        offset += bytes.len;
+    }
+
+    // A quoted field cannot be open at EOF
+    if (offset >= source.size()) {
+        for (&hyps) |*hyp| {
+            if (hyp.scanner.inQuotes()) hyp.alive = false;
+        }
+    }
+    if (hyps[0].alive != hyps[1].alive) {
+        const survivor = if (hyps[0].alive) hyps[0] else hyps[1];
+        if (survivor.boundary) |boundary| return .{ .offset = boundary };
+        if (offset >= source.size()) return .{ .offset = source.size() };
+    }
+
+    // Undecided: assume the cut is outside quotes and let verification confirm it
+    if (hyps[0].alive) {
+        if (hyps[0].boundary) |boundary| return .{ .offset = boundary, .speculative = true };
+    }
+    return .{ .offset = try nextLineStart(source, pos, buf), .speculative = true };
+}
+
+/// Whether the byte before `pos` is an escape that escapes the byte at `pos`,
+/// i.e. it ends an odd run of escape bytes. Inside quotes the byte before such
+/// a run leaves the scanner in `.quoted`, so the parity alone decides.
+fn endsInEscape(source: anytype, pos: u64, config: CsvConfig, buf: []u8) !bool {
+    const escape = CsvScanner.init(config, .field_start).escape orelse return false;
+    var odd = false;
+    var end = pos;
+    while (end > 0) {
+        const len: usize = @intCast(@min(end, @max(buf.len, 1)));
+        const bytes = try source.window(end - len, buf[0..@min(buf.len, len)]);
+        if (bytes.len < len) break;
+        var i = len;
+        while (i > 0 and bytes[i - 1] == escape) : (i -= 1) odd = !odd;
+        if (i > 0) break;
+        end -= len;
+    }
+    return odd;
+}
+
+/// Byte-level CSV quoting state machine, strict enough to refute a wrong guess
+const CsvScanner = struct {
+    const State = enum { field_start, unquoted, quoted, escaped, quote_seen, after_quoted, invalid };
+
+    delimiter: u8,
+    quote: u8,
+    escape: ?u8,
+    state: State,
+
+    fn init(config: CsvConfig, state: State) CsvScanner {
+        return .{
+            .delimiter = config.delimiter,
+            .quote = config.quote_char,
+            // An escape equal to the quote means doubling
+            .escape = if (config.escape_char == config.quote_char) null else config.escape_char,
+            .state = state,
+        };
+    }
+
+    /// State before the byte following `prev`, under either quoting hypothesis.
+    /// `escaped` says `prev` is an unescaped escape byte (see `endsInEscape`).
+    fn entryState(config: CsvConfig, prev: u8, inside: bool, escaped: bool) State {
+        if (inside) return if (escaped) .escaped else .quoted;
+        if (prev == '\n' or prev == config.delimiter) return .field_start;
+        if (prev == config.quote_char) return if (config.escape_char == null or config.escape_char == config.quote_char) .quote_seen else .after_quoted;
+        return .unquoted;
+    }
+
+    fn inQuotes(self: CsvScanner) bool {
+        return self.state == .quoted or self.state == .escaped;
+    }
+
+    /// Consumes one byte; returns true if it terminated a record
+    fn step(self: *CsvScanner, c: u8) bool {
+        switch (self.state) {
+            .field_start, .unquoted, .quote_seen, .after_quoted => {
+                if (c == '\n') {
+                    self.state = .field_start;
+                    return true;
+                }
+                if (c == self.delimiter) {
+                    self.state = .field_start;
+                    return false;
+                }
+            },
+            else => {},
+        }
+
+        self.state = switch (self.state) {
+            .field_start => if (c == self.quote) .quoted else .unquoted,
+            .unquoted => if (c == self.quote) .invalid else .unquoted,
+            .quoted => if (self.escape != null and c == self.escape.?)
+                .escaped
+            else if (c == self.quote)
+                (if (self.escape == null) .quote_seen else .after_quoted)
+            else
+                .quoted,
+            .escaped => .quoted,
+            .quote_seen => if (c == self.quote) .quoted else if (c == '\r') .after_quoted else .invalid,
+            .after_quoted => if (c == '\r') .after_quoted else .invalid,
+            .invalid => .invalid,
+        };
+        return false;
+    }
+};
+
+test "line shards tile the input on line boundaries" {
+    var data = std.ArrayList(u8).init(std.testing.allocator);
+    defer data.deinit();
+    for (0..1000) |i| try data.writer().print("{{\"id\": {d}, \"name\": \"item\"}}\n", .{i});
+
+    for (1..8) |n| {
+        var summaries: [8]BoundarySummary = undefined;
+        var records: u64 = 0;
+        for (0..n) |k| {
+            summaries[k] = try summarize(data.items, k, n, .{ .format = .ndjson });
+            const start: usize = @intCast(summaries[k].start);
+            try std.testing.expect(start == 0 or data.items[start - 1] == '\n');
+            records += summaries[k].records;
+        }
+        try verifyBoundaries(summaries[0..n], data.items.len);
+        try std.testing.expectEqual(@as(u64, 1000), records);
+    }
+}
+
+test "csv shards skip newlines inside quoted fields" {
+    const allocator = std.testing.allocator;
+    var data = std.ArrayList(u8).init(allocator);
+    defer data.deinit();
+    for (0..500) |i| {
+        if (i % 3 == 0) {
+            try data.writer().print("{d},\"multi\nline, with \"\"quotes\"\"\",x\n", .{i});
+        } else {
+            try data.writer().print("{d},plain,\"quoted\"\n", .{i});
+        }
+    }
+
+    // True record starts, from a sequential scan
+    var starts = std.AutoHashMap(u64, void).init(allocator);
+    defer starts.deinit();
+    try starts.put(0, {});
+    var scanner = CsvScanner.init(.{}, .field_start);
+    for (data.items, 0..) |c, i| {
+        if (scanner.step(c)) try starts.put(i + 1, {});
+    }
+
+    const n = 7;
+    var summaries: [n]BoundarySummary = undefined;
+    var records: u64 = 0;
+    for (&summaries, 0..) |*summary, k| {
+        summary.* = try summarize(data.items, k, n, .{ .format = .csv });
+        try std.testing.expect(starts.contains(summary.start));
+        try std.testing.expectEqual(@as(u64, 0), summary.anomalies);
+        records += summary.records;
+    }
+    try verifyBoundaries(&summaries, data.items.len);
+    try std.testing.expectEqual(@as(u64, 500), records);
+
+    // A tampered boundary is caught by the merge check
+    summaries[3].start += 1;
+    try std.testing.expectError(error.ShardGap, verifyBoundaries(&summaries, data.items.len));
+}
+
+test "csv cuts after a backslash escape resume inside the quoted field" {
+    const allocator = std.testing.allocator;
+    const options = Options{ .format = .csv, .csv = .{ .escape_char = '\\' } };
+    var data = std.ArrayList(u8).init(allocator);
+    defer data.deinit();
+    for (0..50) |i| {
+        try data.writer().print("{d},\"say \\\"hi\\\"\nthere\\\\\",x\n", .{i});
+    }
+
+    var starts = std.AutoHashMap(u64, void).init(allocator);
+    defer starts.deinit();
+    var scanner = CsvScanner.init(options.csv, .field_start);
+    for (data.items, 0..) |c, i| {
+        if (scanner.step(c)) try starts.put(i + 1, {});
+    }
+    try std.testing.expectEqual(@as(u32, 50), starts.count());
+
+    // Cut right after every backslash: an escaped quote, or either half of an
+    // escaped backslash before the closing quote
+    var no_buf: [0]u8 = .{};
+    for (1..data.items.len) |pos| {
+        if (data.items[pos - 1] != '\\') continue;
+        const resync = try csvRecordStart(SliceSource{ .data = data.items }, pos, options, &no_buf);
+        try std.testing.expect(!resync.speculative);
+        try std.testing.expect(starts.contains(resync.offset));
+    }
+}
@@ -1,6 +1,10 @@
 const std = @import("std");
 const builtin = @import("builtin");
 const char_class = @import("char_class.zig");
+const cpu_features = @import("cpu_features.zig");
+const IsaLevel = cpu_features.IsaLevel;
+const teddy = @import("teddy.zig");
+const aho_corasick = @import("aho_corasick.zig");
 
 /// Token pattern types for SIMD optimization
 pub const TokenPatternType = enum {
@@ -14,124 +18,115 @@ pub const TokenPatternType = enum {
 // SIMD-accelerated pattern matching for hot paths
 pub const simd = struct {
     
-    // Check if we have SIMD support
+    // Compile-target guarantees (SSE2 is part of the x86_64 baseline)
     pub const has_sse2 = std.Target.x86.featureSetHas(builtin.cpu.features, .sse2);
-    pub const has_avx2 = std.Target.x86.featureSetHas(builtin.cpu.features, .avx2);
     pub const has_neon = builtin.cpu.arch == .aarch64;
     
-    // Fast character class checking using SIMD
-    pub fn findNextNonWhitespace(data: []const u8, start: usize) usize {
-        if (comptime has_avx2) {
-            return findNextNonWhitespaceAVX2(data, start);
-        } else if (comptime has_sse2) {
-            return findNextNonWhitespaceSSE2(data, start);
-        } else if (comptime has_neon) {
-            return findNextNonWhitespaceNEON(data, start);
-        } else {
-            return findNextNonWhitespaceScalar(data, start);
-        }
-    }
+    /// Deprecated: whether the build target has AVX2; kernels use `vector_bytes`
+    pub const has_avx2 = std.Target.x86.featureSetHas(builtin.cpu.features, .avx2);
     
-    pub fn findNextAlpha(data: []const u8, start: usize) ?usize {
-        if (comptime has_avx2) {
-            return findNextAlphaAVX2(data, start);
-        } else if (comptime has_sse2) {
-            return findNextAlphaSSE2(data, start);
-        } else {
-            return findNextAlphaScalar(data, start);
-        }
-    }
+    /// Bytes per vector block of the kernels compiled into this module,
+    /// fixed by the build target: code compiled without AVX2 cannot run
+    /// 32-byte compares as one instruction. The fixed-signature kernels in
+    /// `Kernels` are also built once per x86 tier (src/kernels.zig) and the
+    /// best one the CPU runs is picked at startup; kernels specialized on a
+    /// comptime byte set or needle stay at this width (`-Dcpu=native` widens
+    /// them too).
+    pub const vector_bytes: usize = if (targetHas(.avx512bw)) 64 else if (targetHas(.avx2)) 32 else 16;
     
-    pub fn findEndOfAlphaSequence(data: []const u8, start: usize) usize {
-        if (comptime has_avx2) {
-            return findEndOfAlphaSequenceAVX2(data, start);
-        } else if (comptime has_sse2) {
-            return findEndOfAlphaSequenceSSE2(data, start);
-        } else {
-            return findEndOfAlphaSequenceScalar(data, start);
-        }
-    }
+    /// Tier of the build target itself
+    pub const build_level: IsaLevel = if (targetHas(.avx512bw)) .avx512bw else if (targetHas(.avx2)) .avx2 else if (targetHas(.sse4_2)) .sse42 else .baseline;
+    
+    const K = VectorKernels(vector_bytes);
+    
+    /// Hot kernels of one ISA tier. They use the C ABI so that tiers compiled
+    /// as separate objects, with their own CPU features, can fill the table.
+    /// Searches return the input length when nothing is found.
+    pub const Kernels = struct {
+        level: IsaLevel,
+        skip_whitespace: *const fn ([*]const u8, usize, usize) callconv(.C) usize,
+        find_alpha: *const fn ([*]const u8, usize, usize) callconv(.C) usize,
+        end_of_alpha: *const fn ([*]const u8, usize, usize) callconv(.C) usize,
+        find_byte: *const fn ([*]const u8, usize, u8) callconv(.C) usize,
+        classify64: *const fn (*const [64]u8, *[64]u8) callconv(.C) void,
+        class_masks64: *const fn (*const [64]u8, *[class_count]u64) callconv(.C) void,
+    };
     
-    // AVX2 implementations (32 bytes at a time)
-    fn findNextNonWhitespaceAVX2(data: []const u8, start: usize) usize {
-        // This would contain actual AVX2 intrinsics
-        // For now, fall back to scalar
-        return findNextNonWhitespaceScalar(data, start);
+    /// Weak references to the tier objects only resolve in these formats
+    const tiers_linkable = builtin.cpu.arch == .x86_64 and (builtin.object_format == .elf or builtin.object_format == .macho);
+    
+    var tier_tables = [_]?Kernels{null} ** @typeInfo(IsaLevel).@"enum".fields.len;
+    var auto_kernels: *const Kernels = undefined;
+    var active_kernels = std.atomic.Value(?*const Kernels).init(null);
+    var resolve_once = std.once(resolveKernels);
+    
+    /// Kernel table for the running CPU, filled once on first use
+    pub fn kernels() *const Kernels {
+        if (active_kernels.load(.acquire)) |table| return table;
+        resolve_once.call();
+        return active_kernels.load(.acquire).?;
     }
     
-    fn findNextAlphaAVX2(data: []const u8, start: usize) ?usize {
-        return findNextAlphaScalar(data, start);
+    /// Pins a kernel tier, e.g. to compare tiers in tests. False when the CPU
+    /// cannot run it or no object for it was linked into this artifact.
+    pub fn selectKernels(level: IsaLevel) bool {
+        resolve_once.call();
+        if (level != build_level and @intFromEnum(level) > @intFromEnum(cpu_features.get().level())) return false;
+        if (tier_tables[@intFromEnum(level)]) |*table| {
+            active_kernels.store(table, .release);
+            return true;
+        }
+        return false;
     }
     
-    fn findEndOfAlphaSequenceAVX2(data: []const u8, start: usize) usize {
-        return findEndOfAlphaSequenceScalar(data, start);
+    /// Undoes `selectKernels`
+    pub fn resetKernels() void {
+        resolve_once.call();
+        active_kernels.store(auto_kernels, .release);
     }
     
-    // SSE2 implementations (16 bytes at a time)
-    fn findNextNonWhitespaceSSE2(data: []const u8, start: usize) usize {
-        var pos = start;
-        
-        // Process 16 bytes at a time
-        while (pos + 16 <= data.len) {
-            // Load 16 bytes
-            const chunk = data[pos..pos + 16];
-            
-            // Check if any byte is non-whitespace
-            for (chunk, 0..) |byte, i| {
-                if (byte != ' ' and byte != '\t' and byte != '\n' and byte != '\r') {
-                    return pos + i;
-                }
+    fn resolveKernels() void {
+        tier_tables[@intFromEnum(build_level)] = KernelEntryPoints(vector_bytes).table(build_level);
+        inline for (.{ IsaLevel.avx2, IsaLevel.avx512bw }) |level| {
+            if (comptime @intFromEnum(level) > @intFromEnum(build_level)) {
+                tier_tables[@intFromEnum(level)] = linkedKernels(level);
             }
-            
-            pos += 16;
         }
         
-        // Handle remaining bytes
-        return findNextNonWhitespaceScalar(data, pos);
+        var best: usize = @intFromEnum(build_level);
+        const cpu_level = @intFromEnum(cpu_features.get().level());
+        for (tier_tables, 0..) |table, i| {
+            if (table != null and i > best and i <= cpu_level) best = i;
+        }
+        auto_kernels = &tier_tables[best].?;
+        active_kernels.store(auto_kernels, .release);
     }
     
-    fn findNextAlphaSSE2(data: []const u8, start: usize) ?usize {
-        var pos = start;
-        
-        // Process 16 bytes at a time
-        while (pos + 16 <= data.len) {
-            const chunk = data[pos..pos + 16];
-            
-            for (chunk, 0..) |byte, i| {
-                if ((byte >= 'a' and byte <= 'z') or (byte >= 'A' and byte <= 'Z')) {
-                    return pos + i;
-                }
-            }
-            
-            pos += 16;
+    /// Table exported by the tier's kernel object, or null when build.zig
+    /// did not link one into this artifact
+    fn linkedKernels(comptime level: IsaLevel) ?Kernels {
+        if (comptime !tiers_linkable) return null;
+        var table: Kernels = undefined;
+        table.level = level;
+        inline for (@typeInfo(Kernels).@"struct".fields[1..]) |field| {
+            const symbol = @extern(?field.type, .{ .name = kernelSymbol(level, field.name), .linkage = .weak });
+            @field(table, field.name) = symbol orelse return null;
         }
-        
-        return findNextAlphaScalar(data, pos);
+        return table;
     }
     
-    fn findEndOfAlphaSequenceSSE2(data: []const u8, start: usize) usize {
-        var pos = start;
-        
-        // Process 16 bytes at a time
-        while (pos + 16 <= data.len) {
-            const chunk = data[pos..pos + 16];
-            
-            for (chunk, 0..) |byte, i| {
-                if (!((byte >= 'a' and byte <= 'z') or (byte >= 'A' and byte <= 'Z'))) {
-                    return pos + i;
-                }
-            }
-            
-            pos += 16;
-        }
-        
-        return findEndOfAlphaSequenceScalar(data, pos);
+    // Fast character class checking using SIMD
+    pub fn findNextNonWhitespace(data: []const u8, start: usize) usize {
+        return kernels().skip_whitespace(data.ptr, data.len, start);
     }
     
-    // NEON implementations (16 bytes at a time)
-    fn findNextNonWhitespaceNEON(data: []const u8, start: usize) usize {
-        // ARM NEON implementation would go here
-        return findNextNonWhitespaceScalar(data, start);
+    pub fn findNextAlpha(data: []const u8, start: usize) ?usize {
+        const pos = kernels().find_alpha(data.ptr, data.len, start);
+        return if (pos < data.len) pos else null;
+    }
+    
+    pub fn findEndOfAlphaSequence(data: []const u8, start: usize) usize {
+        return kernels().end_of_alpha(data.ptr, data.len, start);
     }
     
     // Scalar fallbacks
@@ -173,28 +168,21 @@ pub const simd = struct {
     
     /// Find end of digit sequence starting at pos
     pub fn findEndOfDigitSequence(input: []const u8, start_pos: usize) usize {
-        var pos = start_pos;
-        while (pos < input.len and input[pos] >= '0' and input[pos] <= '9') {
-            pos += 1;
-        }
-        return pos;
+        return findTokenPattern(input, start_pos, .digit_sequence);
     }
     
     /// Find end of whitespace sequence starting at pos
     pub fn findEndOfWhitespaceSequence(input: []const u8, start_pos: usize) usize {
-        var pos = start_pos;
-        while (pos < input.len) {
-            const c = input[pos];
-            if (c != ' ' and c != '\t' and c != '\n' and c != '\r') break;
-            pos += 1;
-        }
-        return pos;
+        return findTokenPattern(input, start_pos, .whitespace_sequence);
     }
     
     /// Find a specific byte in input (SIMD accelerated when possible)
     pub fn findByte(input: []const u8, needle: u8) usize {
-        // TODO: Implement SIMD version
-        for (input, 0..) |c, i| {
+        return kernels().find_byte(input.ptr, input.len, needle);
+    }
+    
+    fn findByteScalar(input: []const u8, start: usize, needle: u8) usize {
+        for (input[start..], start..) |c, i| {
             if (c == needle) return i;
         }
         return input.len; // Not found
@@ -209,34 +197,54 @@ pub const simd = struct {
     
     /// SIMD-accelerated pattern matching for common token patterns
     pub fn findTokenPattern(input: []const u8, start: usize, comptime pattern_type: TokenPatternType) usize {
-        const data = input[start..];
-        
-        if (has_sse2) {
-            return switch (pattern_type) {
-                .digit_sequence => findDigitSequenceSSE2(data) + start,
-                .alpha_sequence => findAlphaSequenceSSE2(data) + start,
-                .whitespace_sequence => findWhitespaceSequenceSSE2(data) + start,
-                .identifier_chars => findIdentifierSequenceSSE2(data) + start,
-                .number_chars => findNumberSequenceSSE2(data) + start,
-            };
-        }
-        
-        // Fallback to scalar implementation
-        return switch (pattern_type) {
-            .digit_sequence => findDigitSequenceScalar(data) + start,
-            .alpha_sequence => findAlphaSequenceScalar(data) + start,
-            .whitespace_sequence => findWhitespaceSequenceScalar(data) + start,
-            .identifier_chars => findIdentifierSequenceScalar(data) + start,
-            .number_chars => findNumberSequenceScalar(data) + start,
-        };
+        return runEnd(input, start, comptime tokenPatternRanges(pattern_type));
+    }
+    
+    /// End of the run of bytes within `ranges` (see `byteRanges`) starting at
+    /// `start`, a `vector_bytes` block at a time
+    pub fn runEnd(input: []const u8, start: usize, comptime ranges: []const [2]u8) usize {
+        if (start >= input.len) return input.len;
+        return K.runEnd(ranges, input, start);
     }
     
     /// Vectorized character classification for 16 bytes at once
     pub fn classifyChars16(bytes: *const [16]u8) [16]u8 {
-        if (has_sse2) {
-            return classifyChars16SSE2(bytes);
-        }
-        return classifyChars16Scalar(bytes);
+        return VectorKernels(16).classify(bytes.*);
+    }
+    
+    /// CharClass id of each of 64 bytes, at the selected tier's width
+    pub fn classifyChars64(bytes: *const [64]u8) [64]u8 {
+        var ids: [64]u8 = undefined;
+        kernels().classify64(bytes, &ids);
+        return ids;
+    }
+    
+    /// One 64-bit mask per CharClass for a 64-byte block, at the selected
+    /// tier's width (one vpshufb per nibble row on the AVX-512BW tier)
+    pub fn classMasks64(bytes: *const [64]u8) [class_count]u64 {
+        var masks: [class_count]u64 = undefined;
+        kernels().class_masks64(bytes, &masks);
+        return masks;
+    }
+    
+    /// End of the run of `class` bytes starting at `start`, for classes such
+    /// as punctuation that do not reduce to a few byte ranges
+    pub fn classRunEnd(input: []const u8, start: usize, comptime class: char_class.CharClass) usize {
+        if (start >= input.len) return input.len;
+        return K.spanEnd(K.Class(class), input, start);
+    }
+    
+    /// End of the run of `set` bytes starting at `start`. Any user-defined
+    /// class costs one or two pairs of nibble lookups per block
+    pub fn setRunEnd(input: []const u8, start: usize, comptime set: char_class.ByteSet) usize {
+        if (start >= input.len) return input.len;
+        return K.spanEnd(K.Shufti(set), input, start);
+    }
+    
+    /// First byte of `set` at or after `start`
+    pub fn findInSet(input: []const u8, start: usize, comptime set: char_class.ByteSet) ?usize {
+        if (start >= input.len) return null;
+        return K.firstOf(K.Shufti(set), input, start);
     }
     
     /// Multiple pattern match result
@@ -245,12 +253,18 @@ pub const simd = struct {
         position: usize,
     };
     
-    /// Find multiple patterns simultaneously using SIMD
+    /// First of `patterns` (in order) that occurs at `start`
     pub fn findMultiplePatterns(input: []const u8, start: usize, comptime patterns: []const []const u8) ?MultiPatternResult {
         if (patterns.len == 0) return null;
         
-        if (has_sse2 and patterns.len <= 4) {
-            return findMultiplePatternsSSE2(input, start, patterns);
+        if (comptime teddy.supports(patterns)) {
+            const index = teddy.Teddy(patterns).matchAt(input, start) orelse return null;
+            return .{ .pattern_index = index, .position = start };
+        }
+        if (comptime aho_corasick.supports(patterns)) {
+            const automaton = comptime aho_corasick.AhoCorasick.compile(patterns);
+            const found = automaton.matchAt(input, start, .priority) orelse return null;
+            return .{ .pattern_index = found.literal, .position = start };
         }
         
         // Fallback to sequential search
@@ -263,105 +277,57 @@ pub const simd = struct {
         return null;
     }
     
-    /// SIMD-accelerated string searching using Boyer-Moore-like algorithm
-    pub fn findStringPattern(input: []const u8, pattern: []const u8) ?usize {
-        if (pattern.len == 0) return 0;
-        if (pattern.len > input.len) return null;
-        
-        if (has_sse2 and pattern.len <= 16) {
-            return findStringPatternSSE2(input, pattern);
-        }
-        
-        // Use std library for complex patterns
-        return std.mem.indexOf(u8, input, pattern);
-    }
-    
-    /// Advanced SIMD character set matching for up to 16 characters
-    pub fn matchCharacterSet(c: u8, comptime charset: []const u8) bool {
-        if (charset.len <= 16 and has_sse2) {
-            return matchCharacterSetSSE2(c, charset);
+    /// Leftmost occurrence of any of `literals` at or after `start`; at equal
+    /// positions the earlier literal wins
+    pub fn findAnyLiteral(input: []const u8, start: usize, comptime literals: []const []const u8) ?MultiPatternResult {
+        if (comptime teddy.supports(literals)) return teddy.Teddy(literals).find(input, start);
+        if (comptime aho_corasick.supports(literals)) {
+            const automaton = comptime aho_corasick.AhoCorasick.compile(literals);
+            const found = automaton.find(input, start, .priority) orelse return null;
+            return .{ .pattern_index = found.literal, .position = found.start };
         }
         
-        // Fallback to lookup table or linear search
-        for (charset) |char| {
-            if (c == char) return true;
-        }
-        return false;
-    }
-    
-    /// SIMD implementations (placeholders for now - would use actual intrinsics)
-    
-    fn findDigitSequenceSSE2(data: []const u8) usize {
-        // Placeholder: Would use actual SSE2 intrinsics
-        return findDigitSequenceScalar(data);
-    }
-    
-    fn findAlphaSequenceSSE2(data: []const u8) usize {
-        // Placeholder: Would use actual SSE2 intrinsics  
-        return findAlphaSequenceScalar(data);
-    }
-    
-    fn findWhitespaceSequenceSSE2(data: []const u8) usize {
-        // Placeholder: Would use actual SSE2 intrinsics
-        return findWhitespaceSequenceScalar(data);
-    }
-    
-    fn findIdentifierSequenceSSE2(data: []const u8) usize {
-        // Placeholder: Would match [a-zA-Z0-9_] using SIMD
-        var pos: usize = 0;
-        while (pos < data.len) {
-            const c = data[pos];
-            if (!((c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z') or (c >= '0' and c <= '9') or c == '_')) {
-                break;
-            }
-            pos += 1;
-        }
-        return pos;
-    }
-    
-    fn findNumberSequenceSSE2(data: []const u8) usize {
-        // Placeholder: Would match [0-9.-+eE] using SIMD for number parsing
-        var pos: usize = 0;
-        while (pos < data.len) {
-            const c = data[pos];
-            if (!((c >= '0' and c <= '9') or c == '.' or c == '-' or c == '+' or c == 'e' or c == 'E')) {
-                break;
+        var pos = start;
+        while (pos < input.len) : (pos += 1) {
+            for (literals, 0..) |literal, i| {
+                if (literal.len > 0 and std.mem.startsWith(u8, input[pos..], literal)) {
+                    return .{ .pattern_index = @intCast(i), .position = pos };
+                }
             }
-            pos += 1;
-        }
-        return pos;
-    }
-    
-    fn classifyChars16SSE2(bytes: *const [16]u8) [16]u8 {
-        // Placeholder: Would classify 16 characters using SIMD
-        var result: [16]u8 = undefined;
-        for (bytes, 0..) |byte, i| {
-            result[i] = @intFromEnum(char_class.char_table[byte]);
         }
-        return result;
+        return null;
     }
     
-    fn findMultiplePatternsSSE2(input: []const u8, start: usize, comptime patterns: []const []const u8) ?MultiPatternResult {
-        // Placeholder: Would use SIMD to match multiple patterns simultaneously
-        for (patterns, 0..) |pattern, i| {
-            if (std.mem.startsWith(u8, input[start..], pattern)) {
-                return .{ .pattern_index = @intCast(i), .position = start };
-            }
+    /// First occurrence of a needle known only at runtime: short needles
+    /// are filtered a block at a time on their first and last bytes, long
+    /// ones use the standard library's Boyer-Moore-Horspool
+    pub fn findStringPattern(input: []const u8, pattern: []const u8) ?usize {
+        if (pattern.len == 0) return 0;
+        if (pattern.len > input.len) return null;
+        if (pattern.len == 1) return std.mem.indexOfScalar(u8, input, pattern[0]);
+        
+        if (pattern.len <= two_way_min_len) {
+            return K.findLiteral(pattern, input, 0);
         }
-        return null;
+        return std.mem.indexOf(u8, input, pattern);
     }
     
-    fn findStringPatternSSE2(input: []const u8, pattern: []const u8) ?usize {
-        // Placeholder: Would use SIMD string search
-        return std.mem.indexOf(u8, input, pattern);
+    /// Start of the first `needle` at or after `start`, for delimiters such
+    /// as "*/" or a heredoc terminator. Short needles use the vector
+    /// first/last-byte filter; long ones use two-way search, which stays
+    /// linear on repetitive input where filter-and-verify would not
+    pub fn findLiteral(input: []const u8, start: usize, comptime needle: []const u8) ?usize {
+        if (needle.len == 0) return if (start <= input.len) start else null;
+        if (start >= input.len) return null;
+        if (comptime needle.len == 1) return findInSet(input, start, comptime char_class.ByteSet.of(needle));
+        if (comptime needle.len > two_way_min_len) return TwoWay(needle).find(input, start);
+        return K.findLiteral(needle, input, start);
     }
     
-    fn matchCharacterSetSSE2(c: u8, comptime charset: []const u8) bool {
-        // Placeholder: Would use SIMD to match against character set
-        for (charset) |char| {
-            if (c == char) return true;
-        }
-        return false;
+    /// Character set membership with one bit test, for any set size
+    pub fn matchCharacterSet(c: u8, comptime charset: []const u8) bool {
+        const set = comptime char_class.ByteSet.of(charset);
+        return set.contains(c);
     }
     
     // Scalar fallback implementations
@@ -431,6 +397,485 @@ pub const simd = struct {
     }
 };
 
+/// Width-generic kernels, used at `simd.vector_bytes` and, through
+/// `KernelEntryPoints`, at each tier's width in its own object. Zig has no
+/// per-function target attributes, so a width wider than the target's
+/// registers would only be lowered to several narrower operations; tests
+/// instantiate every width to check the tail handling.
+///
+/// Byte classes are given as a comptime list of inclusive ranges, so each
+/// block costs one compare-and-subtract per range plus a movemask; the first
+/// interesting lane is found with ctz. Tails never fall back to a byte loop:
+/// the last full block is reloaded overlapping the previous one, or, for
+/// inputs shorter than a block, copied into a zero-padded buffer.
+fn VectorKernels(comptime width: usize) type {
+    return struct {
+        const V = @Vector(width, u8);
+        const Mask = std.meta.Int(.unsigned, width);
+        
+        inline fn load(data: []const u8, pos: usize) V {
+            return data[pos..][0..width].*;
+        }
+        
+        inline fn eq(v: V, c: u8) Mask {
+            return @bitCast(v == @as(V, @splat(c)));
+        }
+        
+        inline fn rangeMask(comptime ranges: []const [2]u8, v: V) Mask {
+            var mask: Mask = 0;
+            inline for (ranges) |r| {
+                if (r[0] == r[1]) {
+                    mask |= eq(v, r[0]);
+                } else {
+                    // Unsigned wraparound turns lo <= c <= hi into one compare
+                    mask |= @as(Mask, @bitCast(v -% @as(V, @splat(r[0])) <= @as(V, @splat(r[1] - r[0]))));
+                }
+            }
+            return mask;
+        }
+        
+        /// Lanes 0..count-1; count < width
+        inline fn lowLanes(count: usize) Mask {
+            return (@as(Mask, 1) << @intCast(count)) - 1;
+        }
+        
+        /// Vector holding data[pos..] (fewer than `width` bytes) from lane 0,
+        /// plus the number of leading lanes to discard from its mask
+        inline fn tailBlock(data: []const u8, pos: usize) struct { v: V, shift: usize } {
+            if (data.len >= width) {
+                const base = data.len - width;
+                return .{ .v = load(data, base), .shift = pos - base };
+            }
+            var block = [_]u8{0} ** width;
+            @memcpy(block[0 .. data.len - pos], data[pos..]);
+            return .{ .v = block, .shift = 0 };
+        }
+        
+        inline fn tailMask(comptime Set: type, data: []const u8, pos: usize) Mask {
+            const tail = tailBlock(data, pos);
+            return (Set.mask(tail.v) >> @intCast(tail.shift)) & lowLanes(data.len - pos);
+        }
+        
+        /// Byte set given as inclusive ranges
+        fn Ranges(comptime ranges: []const [2]u8) type {
+            return struct {
+                inline fn mask(v: V) Mask {
+                    return rangeMask(ranges, v);
+                }
+            };
+        }
+        
+        /// Bytes of one CharClass, for classes too scattered for a few ranges
+        fn Class(comptime class: char_class.CharClass) type {
+            return struct {
+                inline fn mask(v: V) Mask {
+                    return eq(classify(v), @intFromEnum(class));
+                }
+            };
+        }
+        
+        /// Bytes of a user-defined ByteSet: a byte is a member when its
+        /// low- and high-nibble lookups share a bucket bit
+        fn Shufti(comptime set: char_class.ByteSet) type {
+            const tables = comptime set.shufti();
+            return struct {
+                inline fn mask(v: V) Mask {
+                    const lo = v & @as(V, @splat(0x0F));
+                    const hi = v >> @as(V, @splat(4));
+                    var hits: V = @splat(0);
+                    inline for (0..tables.pairs) |p| {
+                        hits |= lookup16(width, tables.lo[p], lo) & lookup16(width, tables.hi[p], hi);
+                    }
+                    return @bitCast(hits != @as(V, @splat(0)));
+                }
+            };
+        }
+        
+        /// End of the run of bytes in `Set` that starts at `start`
+        fn spanEnd(comptime Set: type, data: []const u8, start: usize) usize {
+            var pos = start;
+            while (pos + width <= data.len) : (pos += width) {
+                const other = ~Set.mask(load(data, pos));
+                if (other != 0) return pos + @ctz(other);
+            }
+            if (pos >= data.len) return data.len;
+            const other = ~tailMask(Set, data, pos) & lowLanes(data.len - pos);
+            return if (other != 0) pos + @ctz(other) else data.len;
+        }
+        
+        /// First occurrence of `needle` (two bytes or more) at or after
+        /// `start`. Positions whose first and last bytes both match are
+        /// found a block at a time; only those are compared in full.
+        fn findLiteral(needle: []const u8, data: []const u8, start: usize) ?usize {
+            const last = needle.len - 1;
+            var pos = start;
+            while (pos + last + width <= data.len) : (pos += width) {
+                var candidates = eq(load(data, pos), needle[0]) & eq(load(data, pos + last), needle[last]);
+                while (candidates != 0) : (candidates &= candidates - 1) {
+                    const at = pos + @ctz(candidates);
+                    if (std.mem.eql(u8, data[at + 1 .. at + last], needle[1..last])) return at;
+                }
+            }
+            // Fewer than `width` positions are left to try
+            while (pos + needle.len <= data.len) : (pos += 1) {
+                if (std.mem.eql(u8, data[pos..][0..needle.len], needle)) return pos;
+            }
+            return null;
+        }
+        
+        /// First byte in `Set` at or after `start`
+        fn firstOf(comptime Set: type, data: []const u8, start: usize) ?usize {
+            var pos = start;
+            while (pos + width <= data.len) : (pos += width) {
+                const hits = Set.mask(load(data, pos));
+                if (hits != 0) return pos + @ctz(hits);
+            }
+            if (pos >= data.len) return null;
+            const hits = tailMask(Set, data, pos);
+            return if (hits != 0) pos + @ctz(hits) else null;
+        }
+        
+        fn runEnd(comptime ranges: []const [2]u8, data: []const u8, start: usize) usize {
+            return spanEnd(Ranges(ranges), data, start);
+        }
+        
+        /// CharClass id of every byte. Bytes >= 0x80 are all `.other`, so one
+        /// 16-entry lookup on the low nibble per high nibble 0-7 covers the
+        /// whole table
+        inline fn classify(v: V) V {
+            const lo = v & @as(V, @splat(0x0F));
+            const hi = v >> @as(V, @splat(4));
+            var ids: V = @splat(@intFromEnum(char_class.CharClass.other));
+            inline for (0..8) |h| {
+                const row = comptime classRow(h);
+                ids = @select(u8, hi == @as(V, @splat(h)), lookup16(width, row, lo), ids);
+            }
+            return ids;
+        }
+        
+        /// Per-class masks of a 64-byte block; bit i of masks[c] is set when
+        /// bytes[i] has class c
+        fn classMasks64(bytes: *const [64]u8) [class_count]u64 {
+            var masks = [_]u64{0} ** class_count;
+            inline for (0..64 / width) |block| {
+                const ids = classify(bytes[block * width ..][0..width].*);
+                inline for (0..class_count) |c| {
+                    masks[c] |= @as(u64, eq(ids, c)) << (block * width);
+                }
+            }
+            return masks;
+        }
+        
+        fn classify64(bytes: *const [64]u8) [64]u8 {
+            var out: [64]u8 = undefined;
+            inline for (0..64 / width) |block| {
+                out[block * width ..][0..width].* = classify(bytes[block * width ..][0..width].*);
+            }
+            return out;
+        }
+        
+        fn skipWhitespace(data: []const u8, start: usize) usize {
+            return runEnd(&whitespace_ranges, data, start);
+        }
+        
+        fn findAlpha(data: []const u8, start: usize) ?usize {
+            return firstOf(Ranges(&alpha_ranges), data, start);
+        }
+        
+        fn endOfAlpha(data: []const u8, start: usize) usize {
+            return runEnd(&alpha_ranges, data, start);
+        }
+        
+        fn findByte(data: []const u8, needle: u8) usize {
+            var pos: usize = 0;
+            while (pos + width <= data.len) : (pos += width) {
+                const hits = eq(load(data, pos), needle);
+                if (hits != 0) return pos + @ctz(hits);
+            }
+            if (pos >= data.len) return data.len;
+            const tail = tailBlock(data, pos);
+            const hits = (eq(tail.v, needle) >> @intCast(tail.shift)) & lowLanes(data.len - pos);
+            return if (hits != 0) pos + @ctz(hits) else data.len;
+        }
+    };
+}
+
+/// C-ABI entry points of `VectorKernels(width)`, one per `simd.Kernels`
+/// field. src/kernels.zig exports them under `kernelSymbol` names.
+pub fn KernelEntryPoints(comptime width: usize) type {
+    const K = VectorKernels(width);
+    return struct {
+        fn skipWhitespace(ptr: [*]const u8, len: usize, start: usize) callconv(.C) usize {
+            return K.skipWhitespace(ptr[0..len], start);
+        }
+        
+        fn findAlpha(ptr: [*]const u8, len: usize, start: usize) callconv(.C) usize {
+            return K.findAlpha(ptr[0..len], start) orelse len;
+        }
+        
+        fn endOfAlpha(ptr: [*]const u8, len: usize, start: usize) callconv(.C) usize {
+            return K.endOfAlpha(ptr[0..len], start);
+        }
+        
+        fn findByte(ptr: [*]const u8, len: usize, needle: u8) callconv(.C) usize {
+            return K.findByte(ptr[0..len], needle);
+        }
+        
+        fn classify64(bytes: *const [64]u8, ids: *[64]u8) callconv(.C) void {
+            ids.* = K.classify64(bytes);
+        }
+        
+        fn classMasks64(bytes: *const [64]u8, masks: *[class_count]u64) callconv(.C) void {
+            masks.* = K.classMasks64(bytes);
+        }
+        
+        pub fn table(level: IsaLevel) simd.Kernels {
+            return .{
+                .level = level,
+                .skip_whitespace = &skipWhitespace,
+                .find_alpha = &findAlpha,
+                .end_of_alpha = &endOfAlpha,
+                .find_byte = &findByte,
+                .classify64 = &classify64,
+                .class_masks64 = &classMasks64,
+            };
+        }
+    };
+}
+
+/// Symbol under which a tier object exports one `simd.Kernels` entry
+pub fn kernelSymbol(comptime level: IsaLevel, comptime field: []const u8) []const u8 {
+    return "zp_kernels_" ++ @tagName(level) ++ "_" ++ field;
+}
+
+/// Inclusive byte ranges covering `set`, computed at comptime
+pub fn byteRanges(comptime set: [256]bool) []const [2]u8 {
+    comptime {
+        @setEvalBranchQuota(10_000);
+        var ranges: [128][2]u8 = undefined;
+        var count: usize = 0;
+        var c: usize = 0;
+        while (c < 256) {
+            if (!set[c]) {
+                c += 1;
+                continue;
+            }
+            const lo = c;
+            while (c < 256 and set[c]) c += 1;
+            ranges[count] = .{ lo, c - 1 };
+            count += 1;
+        }
+        const result = ranges[0..count].*;
+        return &result;
+    }
+}
+
+const class_count = @typeInfo(char_class.CharClass).@"enum".fields.len;
+
+/// char_table entries for bytes 16*hi .. 16*hi+15
+fn classRow(comptime hi: usize) [16]u8 {
+    var row: [16]u8 = undefined;
+    for (&row, 0..) |*id, lo| id.* = @intFromEnum(char_class.char_table[hi * 16 + lo]);
+    return row;
+}
+
+extern fn @"llvm.x86.ssse3.pshuf.b.128"(@Vector(16, u8), @Vector(16, u8)) @Vector(16, u8);
+extern fn @"llvm.x86.avx2.pshuf.b"(@Vector(32, u8), @Vector(32, u8)) @Vector(32, u8);
+extern fn @"llvm.x86.avx512.pshuf.b.512"(@Vector(64, u8), @Vector(64, u8)) @Vector(64, u8);
+extern fn @"llvm.aarch64.neon.tbl1.v16i8"(@Vector(16, u8), @Vector(16, u8)) @Vector(16, u8);
+
+/// The byte-shuffle intrinsics above only resolve under the LLVM backend;
+/// the self-hosted backends take the portable per-lane paths instead
+const llvm_intrinsics = builtin.zig_backend == .stage2_llvm;
+
+fn targetHas(comptime feature: std.Target.x86.Feature) bool {
+    return switch (builtin.cpu.arch) {
+        .x86, .x86_64 => std.Target.x86.featureSetHas(builtin.cpu.features, feature),
+        else => false,
+    };
+}
+
+/// out[i] = table[idx[i]] for idx < 16: a single pshufb/tbl when the build
+/// target has one at this width, otherwise split into halves, bottoming out
+/// in per-lane reads on targets (or backends) without a byte shuffle
+pub inline fn lookup16(comptime n: usize, comptime table: [16]u8, idx: @Vector(n, u8)) @Vector(n, u8) {
+    const Vn = @Vector(n, u8);
+    // pshufb looks up within each 16-byte lane, so the table is repeated
+    const lanes: Vn = comptime blk: {
+        var t: [n]u8 = undefined;
+        for (&t, 0..) |*b, i| b.* = table[i % 16];
+        break :blk t;
+    };
+
+    if (comptime llvm_intrinsics) {
+        if (n == 64 and comptime targetHas(.avx512bw)) return @"llvm.x86.avx512.pshuf.b.512"(lanes, idx);
+        if (n == 32 and comptime targetHas(.avx2)) return @"llvm.x86.avx2.pshuf.b"(lanes, idx);
+        if (n == 16 and comptime targetHas(.ssse3)) return @"llvm.x86.ssse3.pshuf.b.128"(lanes, idx);
+        if (n == 16 and comptime builtin.cpu.arch == .aarch64) return @"llvm.aarch64.neon.tbl1.v16i8"(lanes, idx);
+    }
+
+    if (n > 16) {
+        const half = n / 2;
+        const lo = lookup16(half, table, @shuffle(u8, idx, undefined, comptime iota(half, 0)));
+        const hi = lookup16(half, table, @shuffle(u8, idx, undefined, comptime iota(half, half)));
+        return @shuffle(u8, lo, hi, comptime concatMask(half));
+    }
+
+    const indices: [n]u8 = idx;
+    var out: [n]u8 = undefined;
+    inline for (0..n) |i| out[i] = table[indices[i]];
+    return out;
+}
+
+/// Whether the build target permutes 16 bytes by a runtime index vector
+/// in one instruction (pshufb/tbl)
+pub const has_byte_shuffle = llvm_intrinsics and (targetHas(.ssse3) or builtin.cpu.arch == .aarch64);
+
+/// out[i] = table[idx[i]] for idx < 16 with a runtime table; per-lane reads
+/// unless `has_byte_shuffle`
+pub inline fn shuffle16(table: @Vector(16, u8), idx: @Vector(16, u8)) @Vector(16, u8) {
+    if (comptime has_byte_shuffle) {
+        if (comptime targetHas(.ssse3)) return @"llvm.x86.ssse3.pshuf.b.128"(table, idx);
+        return @"llvm.aarch64.neon.tbl1.v16i8"(table, idx);
+    }
+
+    const bytes: [16]u8 = table;
+    const indices: [16]u8 = idx;
+    var out: [16]u8 = undefined;
+    inline for (0..16) |i| out[i] = bytes[indices[i]];
+    return out;
+}
+
+fn iota(comptime len: usize, comptime start: i32) [len]i32 {
+    var mask: [len]i32 = undefined;
+    for (&mask, 0..) |*m, i| m.* = start + @as(i32, @intCast(i));
+    return mask;
+}
+
+fn concatMask(comptime half: usize) [2 * half]i32 {
+    var mask: [2 * half]i32 = undefined;
+    for (0..half) |i| {
+        mask[i] = @intCast(i);
+        mask[half + i] = ~@as(i32, @intCast(i));
+    }
+    return mask;
+}
+
+/// Needles longer than this are searched with `TwoWay`
+const two_way_min_len = 32;
+
+/// Two-way string search (Crochemore-Perrin) for a comptime needle. The
+/// needle is split at a critical factorization: the right part is compared
+/// first, and a mismatch there shifts past it, a full match shifts by the
+/// period. Windows are first skipped on their last byte, as in Horspool.
+fn TwoWay(comptime needle: []const u8) type {
+    const l = needle.len;
+    const plan = comptime twoWayPlan(needle);
+    const shift = comptime blk: {
+        // Distance from the last occurrence of each byte to the end
+        var table = [_]usize{l} ** 256;
+        for (needle, 0..) |c, i| table[c] = l - 1 - i;
+        break :blk table;
+    };
+    return struct {
+        fn find(input: []const u8, start: usize) ?usize {
+            var h = start;
+            // needle[0..mem] is known to match at h
+            var mem: usize = 0;
+            while (h + l <= input.len) {
+                const skip = shift[input[h + l - 1]];
+                if (skip != 0) {
+                    h += skip;
+                    mem = 0;
+                    continue;
+                }
+                var k = @max(plan.split, mem);
+                while (k < l and needle[k] == input[h + k]) k += 1;
+                if (k < l) {
+                    h += k - plan.split + 1;
+                    mem = 0;
+                    continue;
+                }
+                k = plan.split;
+                while (k > mem and needle[k - 1] == input[h + k - 1]) k -= 1;
+                if (k <= mem) return h;
+                h += plan.period;
+                mem = plan.memory;
+            }
+            return null;
+        }
+    };
+}
+
+const TwoWayPlan = struct {
+    /// Start of the right part of the factorization
+    split: usize,
+    /// Shift after the right part matched
+    period: usize,
+    /// Prefix known to match after that shift (periodic needles only)
+    memory: usize,
+};
+
+fn twoWayPlan(comptime needle: []const u8) TwoWayPlan {
+    comptime {
+        @setEvalBranchQuota(100_000 + 100 * needle.len);
+        const l = needle.len;
+        const forward = maximalSuffix(needle, false);
+        const backward = maximalSuffix(needle, true);
+        const chosen = if (backward.split > forward.split) backward else forward;
+        const periodic = chosen.period + chosen.split <= l and
+            std.mem.eql(u8, needle[0..chosen.split], needle[chosen.period..][0..chosen.split]);
+        if (periodic) return .{ .split = chosen.split, .period = chosen.period, .memory = l - chosen.period };
+        return .{ .split = chosen.split, .period = @max(chosen.split -| 1, l - chosen.split) + 1, .memory = 0 };
+    }
+}
+
+/// Maximal suffix of `needle` under byte order (or reversed order) and its
+/// period; `split` is where the suffix starts
+fn maximalSuffix(comptime needle: []const u8, comptime reversed: bool) struct { split: usize, period: usize } {
+    comptime {
+        var i: comptime_int = -1;
+        var j: comptime_int = 0;
+        var k: comptime_int = 1;
+        var p: comptime_int = 1;
+        while (j + k < needle.len) {
+            const a = needle[i + k];
+            const b = needle[j + k];
+            if (a == b) {
+                if (k == p) {
+                    j += p;
+                    k = 1;
+                } else {
+                    k += 1;
+                }
+            } else if ((a > b) != reversed) {
+                j += k;
+                k = 1;
+                p = j - i;
+            } else {
+                i = j;
+                j += 1;
+                k = 1;
+                p = 1;
+            }
+        }
+        return .{ .split = i + 1, .period = p };
+    }
+}
+
+const whitespace_ranges = [_][2]u8{ .{ '\t', '\n' }, .{ '\r', '\r' }, .{ ' ', ' ' } };
+const alpha_ranges = [_][2]u8{ .{ 'A', 'Z' }, .{ 'a', 'z' } };
+
+fn tokenPatternRanges(comptime pattern_type: TokenPatternType) []const [2]u8 {
+    return switch (pattern_type) {
+        .digit_sequence => &.{.{ '0', '9' }},
+        .alpha_sequence => &alpha_ranges,
+        .whitespace_sequence => &whitespace_ranges,
+        .identifier_chars => &.{ .{ '0', '9' }, .{ 'A', 'Z' }, .{ '_', '_' }, .{ 'a', 'z' } },
+        .number_chars => &.{ .{ '+', '+' }, .{ '-', '.' }, .{ '0', '9' }, .{ 'E', 'E' }, .{ 'e', 'e' } },
+    };
+}
+
 test "SIMD whitespace skipping" {
     const input = "   \t\n  hello world";
     const result = simd.findNextNonWhitespace(input, 0);
@@ -516,6 +961,28 @@ test "SIMD string pattern finding" {
     try std.testing.expectEqual(@as(usize, 0), result3.?);
 }
 
+test "literal search for until delimiters" {
+    const text = "/* a * b / c **/ x */";
+    try std.testing.expectEqual(@as(?usize, 14), simd.findLiteral(text, 2, "*/"));
+    try std.testing.expectEqual(@as(?usize, 19), simd.findLiteral(text, 15, "*/"));
+    try std.testing.expectEqual(@as(?usize, null), simd.findLiteral(text, 20, "*/"));
+
+    // Repetitive input with a long, periodic delimiter runs two-way search
+    const delimiter = "ab" ** 20 ++ "c";
+    var input: [500]u8 = undefined;
+    for (&input, 0..) |*c, i| c.* = if (i % 2 == 0) 'a' else 'b';
+    @memcpy(input[400..][0..delimiter.len], delimiter);
+    for ([_]usize{ 0, 1, 399, 400 }) |start| {
+        try std.testing.expectEqual(std.mem.indexOfPos(u8, &input, start, delimiter), simd.findLiteral(&input, start, delimiter));
+    }
+    try std.testing.expectEqual(@as(?usize, null), simd.findLiteral(&input, 401, delimiter));
+
+    const aperiodic = "EOF_MARKER_FOR_A_VERY_LONG_HEREDOC\n";
+    const heredoc = "x\n" ** 100 ++ aperiodic ++ "tail";
+    try std.testing.expectEqual(@as(?usize, 200), simd.findLiteral(heredoc, 0, aperiodic));
+    try std.testing.expectEqual(@as(?usize, 200), simd.findStringPattern(heredoc, aperiodic));
+}
+
 test "SIMD multiple pattern matching" {
     const input = "function foo() { return 42; }";
     const patterns = [_][]const u8{ "function", "return", "if", "else" };
@@ -533,6 +1000,33 @@ test "SIMD multiple pattern matching" {
     try std.testing.expectEqual(@as(usize, 17), result2.?.position);
 }
 
+test "SIMD multi-literal search" {
+    const keywords = [_][]const u8{ "timeout", "refused", "denied", "reset" };
+    const log = "conn 1 ok; conn 2 reset by peer; conn 3 refused";
+    const first = simd.findAnyLiteral(log, 0, &keywords).?;
+    try std.testing.expectEqual(@as(u32, 3), first.pattern_index);
+    try std.testing.expectEqual(@as(usize, 18), first.position);
+    const second = simd.findAnyLiteral(log, first.position + 1, &keywords).?;
+    try std.testing.expectEqual(@as(u32, 1), second.pattern_index);
+    try std.testing.expectEqual(@as(?simd.MultiPatternResult, null), simd.findAnyLiteral(log, second.position + 1, &keywords));
+}
+
+test "SIMD multi-literal search beyond the Teddy limit" {
+    // 100 directives: too many for Teddy, so an Aho-Corasick automaton is built
+    const directives = comptime blk: {
+        var list: [100][]const u8 = undefined;
+        for (&list, 0..) |*d, i| d.* = std.fmt.comptimePrint("dir{d}", .{i});
+        break :blk list;
+    };
+    const config = "# dir\nlisten dir42 dir7;";
+    const first = simd.findAnyLiteral(config, 0, &directives).?;
+    // "dir4" (index 4) and "dir42" both start here; declaration order wins
+    try std.testing.expectEqual(@as(u32, 4), first.pattern_index);
+    try std.testing.expectEqual(@as(usize, 13), first.position);
+    try std.testing.expectEqual(@as(u32, 7), simd.findMultiplePatterns(config, 19, &directives).?.pattern_index);
+    try std.testing.expectEqual(@as(?simd.MultiPatternResult, null), simd.findMultiplePatterns(config, 0, &directives));
+}
+
 test "SIMD character set matching" {
     // Test vowel matching
     try std.testing.expect(simd.matchCharacterSet('a', "aeiou"));
@@ -543,4 +1037,150 @@ test "SIMD character set matching" {
     try std.testing.expect(simd.matchCharacterSet('+', "+-*/%"));
     try std.testing.expect(simd.matchCharacterSet('*', "+-*/%"));
     try std.testing.expect(!simd.matchCharacterSet('=', "+-*/%"));
-}
\ No newline at end of file
+}
+
+test "SIMD kernels agree with scalar at every width" {
+    var data: [301]u8 = undefined;
+    var prng = std.Random.DefaultPrng.init(7);
+    const alphabet = " \t\nab1_XZ{";
+    for (&data) |*c| c.* = alphabet[prng.random().uintLessThan(usize, alphabet.len)];
+    
+    inline for (.{ 16, 32, 64 }) |width| {
+        const W = VectorKernels(width);
+        for (0..data.len) |start| {
+            try std.testing.expectEqual(simd.findNextNonWhitespaceScalar(&data, start), W.skipWhitespace(&data, start));
+            try std.testing.expectEqual(simd.findNextAlphaScalar(&data, start), W.findAlpha(&data, start));
+            try std.testing.expectEqual(simd.findEndOfAlphaSequenceScalar(&data, start), W.endOfAlpha(&data, start));
+            try std.testing.expectEqual(simd.findByteScalar(data[start..], 0, '{'), W.findByte(data[start..], '{'));
+        }
+    }
+}
+
+test "SIMD kernel tiers agree with scalar" {
+    var data: [301]u8 = undefined;
+    var prng = std.Random.DefaultPrng.init(13);
+    const alphabet = " \t\nab1_XZ{";
+    for (&data) |*c| c.* = alphabet[prng.random().uintLessThan(usize, alphabet.len)];
+    
+    defer simd.resetKernels();
+    inline for (@typeInfo(IsaLevel).@"enum".fields) |field| {
+        const level: IsaLevel = @enumFromInt(field.value);
+        if (simd.selectKernels(level)) {
+            try std.testing.expectEqual(level, simd.kernels().level);
+            for (0..data.len) |start| {
+                try std.testing.expectEqual(simd.findNextNonWhitespaceScalar(&data, start), simd.findNextNonWhitespace(&data, start));
+                try std.testing.expectEqual(simd.findNextAlphaScalar(&data, start), simd.findNextAlpha(&data, start));
+                try std.testing.expectEqual(simd.findEndOfAlphaSequenceScalar(&data, start), simd.findEndOfAlphaSequence(&data, start));
+                try std.testing.expectEqual(simd.findByteScalar(data[start..], 0, '{'), simd.findByte(data[start..], '{'));
+            }
+        }
+    }
+}
+
+test "SIMD token pattern kernels agree with scalar at every width and tail" {
+    var data: [150]u8 = undefined;
+    var prng = std.Random.DefaultPrng.init(11);
+    const alphabet = "09a_Z .e+-\n";
+    for (&data) |*c| c.* = alphabet[prng.random().uintLessThan(usize, alphabet.len)];
+    
+    inline for (.{ 16, 32, 64 }) |width| {
+        const K = VectorKernels(width);
+        // Every length exercises both the overlapping and the padded tail
+        for (0..data.len) |len| {
+            const input = data[0..len];
+            for (0..len) |start| {
+                try std.testing.expectEqual(start + simd.findDigitSequenceScalar(input[start..]), K.runEnd(comptime tokenPatternRanges(.digit_sequence), input, start));
+                try std.testing.expectEqual(start + simd.findWhitespaceSequenceScalar(input[start..]), K.runEnd(comptime tokenPatternRanges(.whitespace_sequence), input, start));
+                try std.testing.expectEqual(start + simd.findIdentifierSequenceScalar(input[start..]), K.runEnd(comptime tokenPatternRanges(.identifier_chars), input, start));
+                try std.testing.expectEqual(start + simd.findNumberSequenceScalar(input[start..]), K.runEnd(comptime tokenPatternRanges(.number_chars), input, start));
+            }
+        }
+    }
+}
+
+test "SIMD 64-byte classification matches the scalar table" {
+    var bytes: [256]u8 = undefined;
+    for (&bytes, 0..) |*b, i| b.* = @intCast(i);
+    
+    inline for (.{ 16, 32, 64 }) |width| {
+        const K = VectorKernels(width);
+        for (0..4) |block| {
+            const chunk = bytes[block * 64 ..][0..64];
+            const ids = K.classify64(chunk);
+            const masks = K.classMasks64(chunk);
+            for (chunk, 0..) |b, i| {
+                const expected: u8 = @intFromEnum(char_class.char_table[b]);
+                try std.testing.expectEqual(expected, ids[i]);
+                for (masks, 0..) |mask, c| {
+                    try std.testing.expectEqual(c == expected, (mask >> @intCast(i)) & 1 == 1);
+                }
+            }
+        }
+        
+        const text = "a+b-(c*d)/e;; !?...[] done";
+        for (0..text.len) |start| {
+            var end = start;
+            while (end < text.len and char_class.isPunct(text[end])) end += 1;
+            try std.testing.expectEqual(end, K.spanEnd(K.Class(.punct), text, start));
+        }
+    }
+}
+
+test "SIMD 64-byte classification runs on the AVX-512BW tier" {
+    // Selected at runtime, so this needs the CPU feature, not -Dcpu
+    if (!cpu_features.get().avx512bw or !simd.selectKernels(.avx512bw)) return error.SkipZigTest;
+    defer simd.resetKernels();
+    try std.testing.expectEqual(IsaLevel.avx512bw, simd.kernels().level);
+    
+    var bytes: [256]u8 = undefined;
+    for (&bytes, 0..) |*b, i| b.* = @intCast(i);
+    
+    for (0..4) |block| {
+        const chunk = bytes[block * 64 ..][0..64];
+        const ids = simd.classifyChars64(chunk);
+        const masks = simd.classMasks64(chunk);
+        for (chunk, 0..) |b, i| {
+            const expected: u8 = @intFromEnum(char_class.char_table[b]);
+            try std.testing.expectEqual(expected, ids[i]);
+            for (masks, 0..) |mask, c| {
+                try std.testing.expectEqual(c == expected, (mask >> @intCast(i)) & 1 == 1);
+            }
+        }
+    }
+}
+
+test "SIMD shufti kernels agree with ByteSet membership" {
+    const sets = comptime .{
+        char_class.ByteSet.fromClass(.alpha_lower).unionWith(char_class.ByteSet.range('0', '9')).unionWith(char_class.ByteSet.of("-.:")),
+        char_class.ByteSet.fromClass(.punct).negate(),
+        char_class.ByteSet.of("\x00\x13\x26\x39\x4c\x5f\x62\x75\x88\x9b\xae\xc1"),
+    };
+    
+    var data: [150]u8 = undefined;
+    var prng = std.Random.DefaultPrng.init(13);
+    const alphabet = "az09-.:_ ;(\x13\x88\xc1\x00";
+    for (&data) |*c| c.* = alphabet[prng.random().uintLessThan(usize, alphabet.len)];
+    
+    inline for (.{ 16, 32, 64 }) |width| {
+        const K = VectorKernels(width);
+        inline for (sets) |set| {
+            for (0..data.len) |len| {
+                const input = data[0..len];
+                for (0..len) |start| {
+                    var end = start;
+                    while (end < len and set.contains(input[end])) end += 1;
+                    try std.testing.expectEqual(end, K.spanEnd(K.Shufti(set), input, start));
+                    
+                    var first: ?usize = null;
+                    for (input[start..], start..) |c, i| {
+                        if (set.contains(c)) {
+                            first = i;
+                            break;
+                        }
+                    }
+                    try std.testing.expectEqual(first, K.firstOf(K.Shufti(set), input, start));
+                }
+            }
+        }
+    }
+}
@@ -1,42 +1,16 @@
 const std = @import("std");
 const builtin = @import("builtin");
+const cpu = @import("cpu_features.zig");
 
 /// Simple but effective cross-platform SIMD implementation
 /// Focuses on the most impactful operations with straightforward code
 
-/// CPU feature detection
-pub const CpuFeatures = struct {
-    sse2: bool = false,
-    avx2: bool = false,
-    neon: bool = false,
-    
-    pub fn detect() CpuFeatures {
-        var features = CpuFeatures{};
-        
-        switch (builtin.cpu.arch) {
-            .x86, .x86_64 => {
-                features.sse2 = std.Target.x86.featureSetHas(builtin.cpu.features, .sse2);
-                features.avx2 = std.Target.x86.featureSetHas(builtin.cpu.features, .avx2);
-            },
-            .aarch64 => {
-                features.neon = true;
-            },
-            else => {
-                // No SIMD support
-            },
-        }
-        
-        return features;
-    }
-};
-
-var cpu_features: ?CpuFeatures = null;
+/// CPU feature detection, based on the machine we run on (CPUID), not the
+/// compile target
+pub const CpuFeatures = cpu.CpuFeatures;
 
 pub fn getCpuFeatures() CpuFeatures {
-    if (cpu_features == null) {
-        cpu_features = CpuFeatures.detect();
-    }
-    return cpu_features.?;
+    return cpu.get();
 }
 
 /// High-performance string searching
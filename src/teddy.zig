@@ -0,0 +1,257 @@
+const std = @import("std");
+const simd_module = @import("simd.zig");
+const simd = simd_module.simd;
+const Pattern = @import("pattern.zig").Pattern;
+const match = @import("pattern.zig").match;
+
+/// Most literals one matcher takes: 8 buckets of up to 8 literals each
+pub const max_literals = 64;
+const bucket_count = 8;
+
+pub const Match = simd.MultiPatternResult;
+
+/// Whether `Teddy(literals)` can be built: 1 to 64 non-empty literals
+pub fn supports(comptime literals: []const []const u8) bool {
+    if (literals.len == 0 or literals.len > max_literals) return false;
+    for (literals) |lit| {
+        if (lit.len == 0) return false;
+    }
+    return true;
+}
+
+/// Teddy-style packed multi-literal matcher.
+///
+/// Literals are grouped into 8 buckets. For each of the first 1-3 bytes of a
+/// literal (its fingerprint) two 16-entry tables map the byte's low and high
+/// nibble to the buckets that may have that byte there. A position is a
+/// candidate when, for every fingerprint byte, both nibble lookups share a
+/// bucket bit; this costs two shuffles per fingerprint byte for a whole vector
+/// of positions. Candidates are verified against the literals of their
+/// buckets only. Buckets hold literals with neighbouring fingerprints, so a
+/// bucket bit rarely stands for bytes of unrelated literals.
+///
+/// When several literals match at one position, the first in declaration
+/// order wins, as when trying them in turn.
+pub fn Teddy(comptime literals: []const []const u8) type {
+    if (!supports(literals)) @compileError("Teddy needs 1 to 64 non-empty literals");
+
+    return struct {
+        /// Fingerprint length: the shortest literal, at most 3 bytes
+        pub const fingerprint_len = blk: {
+            var len: usize = 3;
+            for (literals) |lit| len = @min(len, lit.len);
+            break :blk len;
+        };
+
+        const Tables = struct {
+            lo: [fingerprint_len][16]u8,
+            hi: [fingerprint_len][16]u8,
+            /// Literal indices in each bucket
+            members: [bucket_count][]const u8,
+        };
+
+        const tables: Tables = buildTables();
+
+        fn buildTables() Tables {
+            @setEvalBranchQuota(100_000);
+            // Sort by fingerprint, then cut into contiguous buckets
+            var order: [literals.len]u8 = undefined;
+            for (&order, 0..) |*o, i| o.* = i;
+            for (1..order.len) |i| {
+                var j = i;
+                while (j > 0 and std.mem.lessThan(u8, fingerprint(order[j]), fingerprint(order[j - 1]))) : (j -= 1) {
+                    std.mem.swap(u8, &order[j], &order[j - 1]);
+                }
+            }
+
+            var result = Tables{
+                .lo = [_][16]u8{[_]u8{0} ** 16} ** fingerprint_len,
+                .hi = [_][16]u8{[_]u8{0} ** 16} ** fingerprint_len,
+                .members = [_][]const u8{&.{}} ** bucket_count,
+            };
+            const per_bucket = (literals.len + bucket_count - 1) / bucket_count;
+            for (0..bucket_count) |b| {
+                const first = @min(b * per_bucket, literals.len);
+                const last = @min(first + per_bucket, literals.len);
+                const frozen = order[first..last].*;
+                result.members[b] = &frozen;
+                for (frozen) |i| {
+                    for (literals[i][0..fingerprint_len], 0..) |c, j| {
+                        result.lo[j][c & 15] |= 1 << b;
+                        result.hi[j][c >> 4] |= 1 << b;
+                    }
+                }
+            }
+            return result;
+        }
+
+        fn fingerprint(comptime i: usize) []const u8 {
+            return literals[i][0..fingerprint_len];
+        }
+
+        /// Buckets whose fingerprint admits the bytes at `bytes`
+        inline fn candidateBuckets(bytes: *const [fingerprint_len]u8) u8 {
+            var buckets: u8 = 0xFF;
+            inline for (0..fingerprint_len) |j| {
+                buckets &= tables.lo[j][bytes[j] & 15] & tables.hi[j][bytes[j] >> 4];
+            }
+            return buckets;
+        }
+
+        /// Bit i is set when literals[i] occurs at `pos`
+        pub fn matchMaskAt(input: []const u8, pos: usize) u64 {
+            if (pos + fingerprint_len > input.len) return 0;
+            var buckets = candidateBuckets(input[pos..][0..fingerprint_len]);
+            var mask: u64 = 0;
+            while (buckets != 0) : (buckets &= buckets - 1) {
+                for (tables.members[@ctz(buckets)]) |i| {
+                    if (std.mem.startsWith(u8, input[pos..], literals[i])) mask |= @as(u64, 1) << @intCast(i);
+                }
+            }
+            return mask;
+        }
+
+        /// Index of the literal that occurs at `pos`, if any
+        pub fn matchAt(input: []const u8, pos: usize) ?u32 {
+            const mask = matchMaskAt(input, pos);
+            if (mask == 0) return null;
+            return @ctz(mask);
+        }
+
+        /// Leftmost occurrence of any literal at or after `start`
+        pub fn find(input: []const u8, start: usize) ?Match {
+            if (start >= input.len) return null;
+            return scan(simd.vector_bytes, input, start);
+        }
+
+        fn scan(comptime width: usize, input: []const u8, start: usize) ?Match {
+            const span = width + fingerprint_len - 1;
+            var pos = start;
+            while (pos + span <= input.len) : (pos += width) {
+                if (verify(width, input, pos, candidateLanes(width, input[pos..][0..span]))) |found| return found;
+            }
+            // Zero-padded tail; verification rejects lanes past the end
+            while (pos < input.len) : (pos += width) {
+                var block = [_]u8{0} ** span;
+                const available = @min(input.len - pos, span);
+                @memcpy(block[0..available], input[pos..][0..available]);
+                if (verify(width, input, pos, candidateLanes(width, &block))) |found| return found;
+            }
+            return null;
+        }
+
+        /// Lanes of a vector of positions whose fingerprint admits some bucket
+        inline fn candidateLanes(comptime width: usize, bytes: *const [width + fingerprint_len - 1]u8) std.meta.Int(.unsigned, width) {
+            const V = @Vector(width, u8);
+            var buckets: V = @splat(0xFF);
+            inline for (0..fingerprint_len) |j| {
+                const v: V = bytes[j..][0..width].*;
+                const lo = v & @as(V, @splat(0x0F));
+                const hi = v >> @as(V, @splat(4));
+                buckets &= simd_module.lookup16(width, tables.lo[j], lo) & simd_module.lookup16(width, tables.hi[j], hi);
+            }
+            return @bitCast(buckets != @as(V, @splat(0)));
+        }
+
+        fn verify(comptime width: usize, input: []const u8, base: usize, candidates: std.meta.Int(.unsigned, width)) ?Match {
+            var lanes = candidates;
+            while (lanes != 0) : (lanes &= lanes - 1) {
+                const pos = base + @ctz(lanes);
+                if (matchAt(input, pos)) |index| return .{ .pattern_index = index, .position = pos };
+            }
+            return null;
+        }
+    };
+}
+
+/// Literal patterns of a token set (a struct of Patterns), in field order
+pub fn literalsOf(comptime patterns: anytype) []const []const u8 {
+    comptime {
+        const T = switch (@typeInfo(@TypeOf(patterns))) {
+            .pointer => |p| p.child,
+            else => @TypeOf(patterns),
+        };
+        var literals: []const []const u8 = &.{};
+        for (std.meta.fields(T)) |field| {
+            const p: Pattern = @field(patterns, field.name);
+            if (p == .literal) literals = literals ++ &[_][]const u8{p.literal};
+        }
+        return literals;
+    }
+}
+
+/// Teddy matcher over the literal patterns of a token set
+pub fn fromPatterns(comptime patterns: anytype) type {
+    return Teddy(literalsOf(patterns));
+}
+
+test "teddy finds the leftmost literal and prefers declaration order" {
+    const keywords = [_][]const u8{ "ERROR", "WARN", "timeout", "refused", "ERR", "panic", "oom-killer", "segfault", "denied" };
+    const T = Teddy(&keywords);
+    try std.testing.expectEqual(@as(usize, 3), T.fingerprint_len);
+
+    const log = "12:00:01 conn ok\n12:00:02 WARN slow disk\n12:00:03 ERROR connection refused";
+    const first = T.find(log, 0).?;
+    try std.testing.expectEqual(@as(u32, 1), first.pattern_index);
+    try std.testing.expectEqual(std.mem.indexOf(u8, log, "WARN").?, first.position);
+
+    // "ERROR" and "ERR" both start here; the earlier literal wins
+    const second = T.find(log, first.position + 1).?;
+    try std.testing.expectEqual(@as(u32, 0), second.pattern_index);
+    try std.testing.expectEqual(@as(u64, 0b1_0001), T.matchMaskAt(log, second.position));
+
+    try std.testing.expectEqual(@as(?Match, null), T.find("nothing to see here", 0));
+}
+
+test "teddy agrees with a naive search at every width" {
+    const alphabet = "abcdxyz\x80\xff";
+    // 40 literals of 2-4 bytes over a small alphabet, so buckets collide
+    const literals = comptime blk: {
+        var lits: [40][]const u8 = undefined;
+        var seed: u32 = 17;
+        for (&lits, 0..) |*lit, i| {
+            var bytes: [2 + i % 3]u8 = undefined;
+            for (&bytes) |*c| {
+                seed = seed *% 1103515245 +% 12345;
+                c.* = alphabet[(seed >> 16) % alphabet.len];
+            }
+            const owned = bytes;
+            lit.* = &owned;
+        }
+        break :blk lits;
+    };
+    const T = Teddy(&literals);
+
+    var input: [300]u8 = undefined;
+    var prng = std.Random.DefaultPrng.init(17);
+    for (&input) |*c| c.* = alphabet[prng.random().uintLessThan(usize, alphabet.len)];
+
+    inline for (.{ 16, 32, 64 }) |width| {
+        for (0..input.len) |start| {
+            var expected: ?Match = null;
+            outer: for (start..input.len) |pos| {
+                for (literals, 0..) |lit, i| {
+                    if (std.mem.startsWith(u8, input[pos..], lit)) {
+                        expected = .{ .pattern_index = @intCast(i), .position = pos };
+                        break :outer;
+                    }
+                }
+            }
+            try std.testing.expectEqual(expected, T.scan(width, &input, start));
+        }
+    }
+}
+
+test "teddy matcher built from a token set" {
+    const patterns = comptime .{
+        .kw_let = match.literal("let"),
+        .ident = match.alpha.oneOrMore(),
+        .kw_fn = match.literal("fn"),
+        .arrow = match.literal("=>"),
+    };
+    const T = fromPatterns(patterns);
+    try std.testing.expectEqual(@as(usize, 3), literalsOf(patterns).len);
+    try std.testing.expectEqual(@as(?u32, 1), T.matchAt("fn main", 0));
+    try std.testing.expectEqual(@as(?u32, 2), T.matchAt("x => y", 2));
+    try std.testing.expectEqual(@as(?u32, null), T.matchAt("lex", 0));
+}
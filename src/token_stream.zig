@@ -1,12 +1,126 @@
 const std = @import("std");
 const pattern = @import("pattern.zig");
 const char_class = @import("char_class.zig");
+const simd_module = @import("simd.zig");
+const simd = simd_module.simd;
+const BlockClassifier = @import("block_classifier.zig").BlockClassifier;
+const teddy = @import("teddy.zig");
+const aho_corasick = @import("aho_corasick.zig");
+const pattern_ir = @import("pattern_ir.zig");
+
+/// Repetitions of a byte class with more ranges than this use shufti lookups
+const max_run_ranges = 6;
+
+const ClassRun = struct {
+    ranges: []const [2]u8,
+    /// Set instead of `ranges` for scattered classes such as punctuation
+    class: ?char_class.CharClass = null,
+    /// Set when the byte set is exactly a union of CharClasses, so the run
+    /// can be read off the stream's cached block masks
+    classes: ?BlockClassifier.Selector = null,
+    /// Any other set, scanned with shufti nibble lookups
+    set: ?char_class.ByteSet = null,
+    min: usize,
+};
+
+/// Selector for `set` if it contains every byte of each class it touches
+fn classSelector(comptime set: [256]bool) ?BlockClassifier.Selector {
+    @setEvalBranchQuota(10000);
+    var touched: u8 = 0;
+    var partial: u8 = 0;
+    for (0..256) |b| {
+        const bit = @as(u8, 1) << @intFromEnum(char_class.char_table[b]);
+        if (set[b]) touched |= bit else partial |= bit;
+    }
+    if (touched & partial != 0) return null;
+    return .{ .classes = touched };
+}
+
+/// `oneOrMore`/`zeroOrMore` of a single-byte class, matched with the vector kernels
+fn classRun(comptime p: pattern.Pattern) ?ClassRun {
+    const min: usize = switch (p) {
+        .one_or_more => 1,
+        .zero_or_more => 0,
+        else => return null,
+    };
+    const inner = switch (p) {
+        .one_or_more, .zero_or_more => |sub| sub.*,
+        else => unreachable,
+    };
+    const set = pattern.byteSet(inner) orelse return null;
+    if (classSelector(set)) |classes| return .{ .ranges = &.{}, .classes = classes, .min = min };
+    const ranges = simd_module.byteRanges(set);
+    if (ranges.len <= max_run_ranges) return .{ .ranges = ranges, .min = min };
+    return switch (inner) {
+        .char_class => |class| .{ .ranges = &.{}, .class = class, .min = min },
+        else => .{ .ranges = &.{}, .set = char_class.ByteSet.fromArray(set), .min = min },
+    };
+}
+
+fn matchRun(comptime run: ClassRun, classifier: *BlockClassifier, pos: usize) pattern.MatchResult {
+    const input = classifier.input;
+    const end = if (comptime run.classes != null)
+        classifier.runEnd(pos, run.classes.?)
+    else if (comptime run.class != null)
+        simd.classRunEnd(input, pos, run.class.?)
+    else if (comptime run.set != null)
+        simd.setRunEnd(input, pos, run.set.?)
+    else
+        simd.runEnd(input, pos, run.ranges);
+    const len = end - pos;
+    if (len < run.min) return .{ .matched = false, .len = 0 };
+    return .{ .matched = true, .len = len };
+}
+
+/// Token sets with at least this many literal patterns look them all up at
+/// once, with a Teddy fingerprint for up to 64 literals and an Aho-Corasick
+/// trie walk beyond that, instead of comparing each in turn
+const min_literal_set = 4;
+
+/// Matcher over the literal patterns of a token set, or void if too few.
+/// `matchAt` returns the lowest-index literal occurring at a position.
+fn LiteralSet(comptime patterns: anytype) type {
+    const literals = teddy.literalsOf(patterns);
+    if (literals.len < min_literal_set) return void;
+    if (teddy.supports(literals)) return teddy.Teddy(literals);
+    if (!aho_corasick.supports(literals)) return void;
+    return struct {
+        const automaton = aho_corasick.AhoCorasick.compile(literals);
+        
+        fn matchAt(input: []const u8, pos: usize) ?u32 {
+            const found = automaton.matchAt(input, pos, .priority) orelse return null;
+            return found.literal;
+        }
+    };
+}
+
+/// Index of field `name` among the literal patterns of a token set
+fn literalIndex(comptime fields: anytype, comptime patterns: anytype, comptime name: []const u8) usize {
+    var index: usize = 0;
+    for (fields) |field| {
+        if (std.mem.eql(u8, field.name, name)) return index;
+        if (@field(patterns, field.name) == .literal) index += 1;
+    }
+    unreachable;
+}
+
+/// Token type of an identifier span: its keyword's type if it is one
+fn keywordType(comptime TokenType: type, comptime ki: *const pattern.KeywordIdent, default: TokenType, text: []const u8) TokenType {
+    const types = comptime blk: {
+        var list: [ki.names.len]TokenType = undefined;
+        for (&list, ki.names) |*t, name| t.* = @field(TokenType, name);
+        break :blk list;
+    };
+    const index = ki.keywordIndex(text) orelse return default;
+    return types[index];
+}
 
 pub const TokenStream = struct {
     source: []const u8,
     pos: usize,
     line: usize,
     column: usize,
+    classifier: BlockClassifier,
     
     pub fn init(source: []const u8) TokenStream {
         return .{
@@ -14,6 +128,7 @@ pub const TokenStream = struct {
             .pos = 0,
             .line = 1,
             .column = 1,
+            .classifier = BlockClassifier.init(source, &.{}),
         };
     }
     
@@ -39,27 +154,36 @@ pub const TokenStream = struct {
             else => @compileError("Expected struct patterns"),
         };
         
+        const Literals = comptime LiteralSet(patterns);
+        const first_literal: ?u32 = if (Literals != void) Literals.matchAt(self.source, self.pos) else null;
+        
         inline for (fields) |field| {
             const token_type = @field(TokenType, field.name);
             const pattern_value = @field(patterns, field.name);
+            // Keyword identifiers match their identifier span, then reclassify it
+            const span_pattern = comptime if (pattern_value == .keyword_ident) pattern_value.keyword_ident.ident else pattern_value;
             
-            const result = pattern.matchPattern(pattern_value, self.source, self.pos);
+            const result = if (comptime Literals != void and pattern_value == .literal) blk: {
+                // One lookup answered every literal of the set. Later literals
+                // that also occur here are never reached: the first one wins.
+                const index = comptime literalIndex(fields, patterns, field.name);
+                const matched = if (first_literal) |first| first == index else false;
+                break :blk pattern.MatchResult{ .matched = matched, .len = pattern_value.literal.len };
+            } else if (comptime classRun(span_pattern)) |run|
+                matchRun(run, &self.classifier, self.pos)
+            else
+                pattern_ir.Compiled(span_pattern).match(self.source, self.pos);
             if (result.matched and result.len > 0) {
                 const text = self.source[self.pos..][0..result.len];
                 
-                // Update position tracking
-                for (text) |c| {
-                    if (c == '\n') {
-                        self.line += 1;
-                        self.column = 1;
-                    } else {
-                        self.column += 1;
-                    }
-                }
+                char_class.advancePosition(&self.line, &self.column, text);
                 self.pos += result.len;
                 
                 return .{
-                    .type = token_type,
+                    .type = if (comptime pattern_value == .keyword_ident)
+                        keywordType(TokenType, pattern_value.keyword_ident, token_type, text)
+                    else
+                        token_type,
                     .text = text,
                     .line = start_line,
                     .column = start_column,
@@ -96,6 +220,14 @@ pub const TokenStream = struct {
         return copy.next(TokenType, patterns);
     }
     
+    /// Consumes up to `len` bytes without matching them, keeping line and column
+    pub fn advance(self: *TokenStream, len: usize) []const u8 {
+        const text = self.remaining()[0..@min(len, self.source.len -| self.pos)];
+        char_class.advancePosition(&self.line, &self.column, text);
+        self.pos += text.len;
+        return text;
+    }
+    
     pub fn remaining(self: *const TokenStream) []const u8 {
         if (self.pos >= self.source.len) return "";
         return self.source[self.pos..];
@@ -147,4 +279,86 @@ test "token stream" {
     
     // No more tokens
     try std.testing.expect(stream.next(TokenType, patterns) == null);
-}
\ No newline at end of file
+}
+
+test "token stream class runs match the generic matcher" {
+    const patterns = comptime [_]pattern.Pattern{
+        pattern.match.alpha.oneOrMore(),
+        pattern.match.digit.oneOrMore(),
+        pattern.match.whitespace.zeroOrMore(),
+        pattern.match.alphanumeric.oneOrMore(),
+        pattern.match.range('a', 'f').oneOrMore(),
+        pattern.match.punct.oneOrMore(),
+        pattern.match.anyOf("aXz0_.;(\n").oneOrMore(),
+        pattern.match.set(char_class.ByteSet.fromClass(.alpha_lower).unionWith(char_class.ByteSet.of("_.;"))).zeroOrMore(),
+    };
+    
+    var input: [200]u8 = undefined;
+    var prng = std.Random.DefaultPrng.init(3);
+    const alphabet = "ab fz09 \t\nXY_.;(";
+    for (&input) |*c| c.* = alphabet[prng.random().uintLessThan(usize, alphabet.len)];
+    
+    var classifier = BlockClassifier.init(&input, &.{});
+    inline for (patterns) |p| {
+        const run = comptime classRun(p).?;
+        for (0..input.len) |pos| {
+            const expected = pattern.matchPattern(p, &input, pos);
+            const actual = matchRun(run, &classifier, pos);
+            try std.testing.expectEqual(expected.matched, actual.matched);
+            if (expected.matched) try std.testing.expectEqual(expected.len, actual.len);
+        }
+    }
+}
+
+test "token stream literal sets match in declaration order" {
+    const TokenType = enum { kw_if, kw_in, kw_int, ident, arrow, eq, space };
+    const patterns = comptime .{
+        .kw_if = pattern.match.literal("if"),
+        .kw_in = pattern.match.literal("in"),
+        .kw_int = pattern.match.literal("int"),
+        .ident = pattern.match.alpha.oneOrMore(),
+        .arrow = pattern.match.literal("=>"),
+        .eq = pattern.match.literal("="),
+        .space = pattern.match.whitespace.oneOrMore(),
+    };
+    
+    var stream = TokenStream.init("if int => x = y");
+    const expected = [_]struct { TokenType, []const u8 }{
+        .{ .kw_if, "if" }, .{ .space, " " }, .{ .kw_in, "in" }, .{ .ident, "t" },
+        .{ .space, " " }, .{ .arrow, "=>" }, .{ .space, " " }, .{ .ident, "x" },
+        .{ .space, " " }, .{ .eq, "=" }, .{ .space, " " }, .{ .ident, "y" },
+    };
+    for (expected) |e| {
+        const token = stream.next(TokenType, patterns).?;
+        try std.testing.expectEqual(e[0], token.type);
+        try std.testing.expectEqualStrings(e[1], token.text);
+    }
+    try std.testing.expect(stream.isAtEnd());
+}
+
+test "token stream reclassifies identifiers as keywords" {
+    const TokenType = enum { kw_let, kw_if, kw_else, kw_return, ident, space, punct };
+    const patterns = comptime .{
+        .ident = pattern.match.identifierWithKeywords(pattern.match.alpha.oneOrMore(), .{
+            .kw_let = "let",
+            .kw_if = "if",
+            .kw_else = "else",
+            .kw_return = "return",
+        }),
+        .space = pattern.match.whitespace.oneOrMore(),
+        .punct = pattern.match.punct,
+    };
+    
+    var stream = TokenStream.init("if iffy else;let returns return");
+    const expected = [_]struct { TokenType, []const u8 }{
+        .{ .kw_if, "if" }, .{ .space, " " }, .{ .ident, "iffy" }, .{ .space, " " },
+        .{ .kw_else, "else" }, .{ .punct, ";" }, .{ .kw_let, "let" }, .{ .space, " " },
+        .{ .ident, "returns" }, .{ .space, " " }, .{ .kw_return, "return" },
+    };
+    for (expected) |e| {
+        const token = stream.next(TokenType, patterns).?;
+        try std.testing.expectEqual(e[0], token.type);
+        try std.testing.expectEqualStrings(e[1], token.text);
+    }
+    try std.testing.expect(stream.isAtEnd());
+}
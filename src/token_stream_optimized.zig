@@ -1,6 +1,6 @@
 const std = @import("std");
 const pattern = @import("pattern.zig");
-const pattern_optimized = @import("pattern_optimized.zig");
+const pattern_ir = @import("pattern_ir.zig");
 const char_class = @import("char_class.zig");
 
 /// Ultra-high-performance TokenStream with aggressive optimizations
@@ -30,8 +30,8 @@ pub const TokenStreamOptimized = struct {
                 const token_type = @field(TokenType, field.name);
                 const pattern_def = @field(patterns, field.name);
                 
-                // Use optimized pattern matching
-                const result = pattern_optimized.matchPatternOptimized(pattern_def, self.input, start_pos);
+                // Matcher specialized for the pattern's optimized form
+                const result = pattern_ir.Compiled(pattern_def).match(self.input, start_pos);
                 
                 if (result.matched and result.len > 0) {
                     const token_text = self.input[start_pos..start_pos + result.len];
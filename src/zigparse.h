@@ -44,6 +44,9 @@ typedef struct {
 
 /**
  * Opaque handle for a parser instance.
+ * The pointer value is a generation-tagged handle, not an address, so a
+ * destroyed parser's handle is rejected rather than dereferenced. On 32-bit
+ * targets the generation is narrower and repeats after 2048 reuses of a slot.
  */
 typedef struct ZP_Parser_s ZP_Parser;
 
@@ -59,6 +62,77 @@ typedef enum {
     ZP_EVENT_ERROR = 5,
 } ZP_EventType;
 
+/**
+ * Event flags.
+ */
+#define ZP_EVENT_FLAG_DETACHED (1u << 0) /* payload is not in the input; see zp_get_error() */
+#define ZP_EVENT_FLAG_QUOTED   (1u << 1) /* payload was quoted; offset/length exclude the quotes */
+#define ZP_EVENT_FLAG_KEY      (1u << 2) /* JSON object key */
+#define ZP_EVENT_FLAG_ARRAY    (1u << 3) /* element is a JSON array (otherwise object or CSV record) */
+#define ZP_EVENT_FLAG_NUMBER   (1u << 4) /* JSON number */
+#define ZP_EVENT_FLAG_LITERAL  (1u << 5) /* JSON true, false or null */
+
+/**
+ * Fixed-size event record filled by zp_next_events().
+ * Payloads are not copied: offset and length locate them in the input,
+ * counted from the first byte passed to the parser.
+ */
+typedef struct {
+    int type;          /* ZP_EventType */
+    uint32_t flags;    /* ZP_EVENT_FLAG_* */
+    uint64_t offset;
+    uint64_t length;
+    uint32_t line;
+    uint32_t column;
+} ZP_Event;
+
+/**
+ * Built-in formats for zp_tokenize_batch().
+ */
+typedef enum {
+    ZP_FORMAT_JSON = 0,
+    ZP_FORMAT_CSV = 1,
+} ZP_Format;
+
+/**
+ * Token types reported by zp_tokenize_batch() for ZP_FORMAT_JSON.
+ */
+typedef enum {
+    ZP_JSON_TOKEN_LBRACE = 0,
+    ZP_JSON_TOKEN_RBRACE = 1,
+    ZP_JSON_TOKEN_LBRACKET = 2,
+    ZP_JSON_TOKEN_RBRACKET = 3,
+    ZP_JSON_TOKEN_COMMA = 4,
+    ZP_JSON_TOKEN_COLON = 5,
+    ZP_JSON_TOKEN_STRING = 6,
+    ZP_JSON_TOKEN_NUMBER = 7,
+    ZP_JSON_TOKEN_TRUE = 8,
+    ZP_JSON_TOKEN_FALSE = 9,
+    ZP_JSON_TOKEN_NULL = 10,
+} ZP_JsonToken;
+
+/**
+ * Token types reported by zp_tokenize_batch() for ZP_FORMAT_CSV.
+ */
+typedef enum {
+    ZP_CSV_TOKEN_FIELD = 0,
+    ZP_CSV_TOKEN_QUOTED_FIELD = 1,
+    ZP_CSV_TOKEN_DELIMITER = 2,
+    ZP_CSV_TOKEN_NEWLINE = 3,
+} ZP_CsvToken;
+
+/**
+ * Caller-supplied allocator.
+ * resize must grow or shrink a block in place and return nonzero on success;
+ * it may be NULL, in which case blocks are always moved.
+ */
+typedef struct {
+    void* ctx;
+    void* (*alloc)(void* ctx, size_t size, size_t alignment);
+    int (*resize)(void* ctx, void* ptr, size_t old_size, size_t new_size, size_t alignment);
+    void (*free)(void* ctx, void* ptr, size_t size, size_t alignment);
+} ZP_Allocator;
+
 /**
  * Callback function type for handling parser events.
  *
@@ -121,16 +195,84 @@ ZP_Result zp_create_parser(
     uint32_t initial_state
 );
 
+/**
+ * Options for the predefined format parsers.
+ * Initialize with zp_format_params_default() before changing fields.
+ */
+typedef struct {
+    char delimiter;           /* CSV field delimiter (default ',') */
+    char quote;               /* CSV quote character (default '"') */
+    char escape;              /* CSV escape character; 0 = quotes escaped by doubling */
+    uint8_t trim_whitespace;  /* CSV: trim spaces/tabs around unquoted fields */
+    uint8_t skip_empty_lines; /* CSV: no records for empty lines (default 1) */
+    uint32_t max_depth;       /* JSON nesting limit; 0 = unlimited */
+} ZP_FormatParams;
+
+/**
+ * Fill a ZP_FormatParams with default values.
+ *
+ * @param params Parameters to initialize.
+ */
+void zp_format_params_default(ZP_FormatParams* params);
+
 /**
  * Create a parser for a specific predefined format.
+ * JSON objects/arrays and CSV records are reported as START_ELEMENT/END_ELEMENT,
+ * scalars and fields as VALUE events. "xml" is not implemented yet.
  *
- * @param format_name Name of the format (e.g., "json", "csv", "xml").
+ * @param format_name Name of the format ("json" or "csv").
  * @return ZP_Result with parser handle in data field on success.
  */
 ZP_Result zp_create_format_parser(const char* format_name);
 
+/**
+ * Create a parser for a specific predefined format with options.
+ *
+ * @param format_name Name of the format ("json" or "csv").
+ * @param params Format options, or NULL for defaults.
+ * @return ZP_Result with parser handle in data field on success.
+ */
+ZP_Result zp_create_format_parser_ex(const char* format_name, const ZP_FormatParams* params);
+
+/**
+ * Parser flags for ZP_ParserOptions.
+ */
+#define ZP_PARSER_FLAG_ARENA (1u << 0) /* per-document arena, released by zp_reset() */
+
+/**
+ * Options for zp_create_parser_ex().
+ */
+typedef struct {
+    const ZP_Allocator* allocator;         /* NULL = library default allocator */
+    uint32_t flags;                        /* ZP_PARSER_FLAG_* */
+    const ZP_FormatParams* format_params;  /* NULL = defaults */
+} ZP_ParserOptions;
+
+/**
+ * Create a format parser that allocates through a caller-supplied allocator.
+ * With ZP_PARSER_FLAG_ARENA, all memory for a document comes from an arena
+ * on top of that allocator and is released at once by zp_reset().
+ *
+ * @param format_name Name of the format ("json" or "csv").
+ * @param options Parser options, or NULL for defaults.
+ * @return ZP_Result with parser handle in data field on success.
+ */
+ZP_Result zp_create_parser_ex(const char* format_name, const ZP_ParserOptions* options);
+
+/**
+ * Start a new document on an existing parser, discarding queued events.
+ *
+ * @param parser Parser handle.
+ * @return ZP_Result with ZP_OK on success.
+ */
+ZP_Result zp_reset(ZP_Parser* parser);
+
 /**
  * Destroy a parser and free associated resources.
+ * Waits for calls still using the parser on other threads. Calling it from
+ * the parser's own event callback fails with ZP_ERROR_INVALID_STATE, since
+ * the call delivering the event is still using the parser; destroy it after
+ * that call returns.
  *
  * @param parser Parser handle to destroy.
  * @return ZP_Result with ZP_OK on success.
@@ -139,6 +281,7 @@ ZP_Result zp_destroy_parser(ZP_Parser* parser);
 
 /**
  * Set an event handler for parser events.
+ * Passing a NULL callback switches back to pull mode (see zp_next_events()).
  *
  * @param parser Parser handle.
  * @param callback Function to call when events occur.
@@ -154,6 +297,8 @@ ZP_Result zp_set_event_handler(
 /**
  * Parse a chunk of data incrementally.
  * Call zp_finish_parsing() when done with all chunks.
+ * Chunks may split tokens anywhere; event offsets are relative to the start
+ * of the whole input, and callback payloads are only valid during the callback.
  *
  * @param parser Parser handle.
  * @param data Pointer to data chunk.
@@ -164,6 +309,8 @@ ZP_Result zp_parse_chunk(ZP_Parser* parser, const char* data, size_t len);
 
 /**
  * Finish incremental parsing.
+ * In pull mode with a full event queue, the remaining input is parsed as
+ * zp_next_events() drains the queue; no more chunks are accepted after this.
  *
  * @param parser Parser handle.
  * @return ZP_Result with ZP_OK on success.
@@ -180,6 +327,205 @@ ZP_Result zp_finish_parsing(ZP_Parser* parser);
  */
 ZP_Result zp_parse_string(ZP_Parser* parser, const char* data, size_t len);
 
+/**
+ * Retrieve queued events in bulk (pull mode).
+ * Events are queued whenever no callback is set with zp_set_event_handler().
+ * The queue holds a few thousand events; once it is full, parsing stops at
+ * the next token and the rest of the input is kept inside the parser. Each
+ * call first resumes that parsing, so call repeatedly until *count is 0 to
+ * get every event for the input passed so far.
+ *
+ * @param parser Parser handle.
+ * @param out Caller-owned array receiving the events.
+ * @param cap Capacity of the out array.
+ * @param count Receives the number of events written.
+ * @return ZP_Result with ZP_OK on success.
+ */
+ZP_Result zp_next_events(ZP_Parser* parser, ZP_Event* out, size_t cap, size_t* count);
+
+/**
+ * Tokenize a whole buffer into caller-owned parallel arrays, without creating
+ * a parser. Tokens are reported as offsets and lengths into data; JSON
+ * whitespace is not reported. If the arrays fill up, resume by calling again
+ * with data + *consumed (offsets are relative to the data passed in).
+ *
+ * @param format ZP_FORMAT_JSON or ZP_FORMAT_CSV.
+ * @param params CSV delimiter, quote, escape and trim_whitespace, or NULL for
+ *               defaults; an unusable delimiter gives ZP_ERROR_PARSER_CONFIG.
+ * @param data Input buffer.
+ * @param len Length of the input buffer.
+ * @param types Receives ZP_JsonToken / ZP_CsvToken values.
+ * @param offsets Receives token offsets.
+ * @param lengths Receives token lengths.
+ * @param cap Capacity of each output array.
+ * @param count Receives the number of tokens written.
+ * @param consumed Receives the number of input bytes fully tokenized.
+ * @return ZP_Result with ZP_OK on success.
+ */
+ZP_Result zp_tokenize_batch(
+    ZP_Format format,
+    const ZP_FormatParams* params,
+    const char* data,
+    size_t len,
+    uint32_t* types,
+    size_t* offsets,
+    size_t* lengths,
+    size_t cap,
+    size_t* count,
+    size_t* consumed
+);
+
+/**
+ * Opaque handle for a runtime literal set (keywords, directives, ...).
+ */
+typedef struct ZP_LiteralSet_s ZP_LiteralSet;
+
+/**
+ * Which literal wins among those starting at the same position.
+ */
+typedef enum {
+    ZP_MATCH_LONGEST = 0,  /* the longest literal */
+    ZP_MATCH_PRIORITY = 1, /* the literal given first to zp_create_literal_set() */
+} ZP_MatchKind;
+
+#define ZP_NO_LITERAL UINT32_MAX
+
+/**
+ * Literal occurrence [start, end); literal is ZP_NO_LITERAL if none was found.
+ */
+typedef struct {
+    uint32_t literal;
+    size_t start;
+    size_t end;
+} ZP_LiteralMatch;
+
+/**
+ * Build a literal set for matching hundreds to thousands of literals at once.
+ * Lookups cost one automaton step per input byte, whatever the set size.
+ *
+ * @param literals Array of count byte strings (need not be NUL-terminated).
+ * @param lens Length of each literal; empty literals are rejected.
+ * @param count Number of literals.
+ * @return ZP_Result with data pointing to the ZP_LiteralSet on success.
+ */
+ZP_Result zp_create_literal_set(const char* const* literals, const size_t* lens, size_t count);
+
+/**
+ * Destroy a literal set.
+ * Waits for calls still using the set on other threads. The handle is
+ * invalid afterwards: destroying it again or passing it to any other call
+ * fails with ZP_ERROR_INVALID_HANDLE.
+ *
+ * @param set Literal set handle.
+ * @return ZP_Result with ZP_OK on success.
+ */
+ZP_Result zp_destroy_literal_set(ZP_LiteralSet* set);
+
+/**
+ * Find the leftmost literal occurring at or after start.
+ *
+ * @param set Literal set handle.
+ * @param data Input buffer.
+ * @param len Length of the input buffer.
+ * @param start Offset to search from.
+ * @param kind Tie-break between literals starting at the same offset.
+ * @param out Receives the match, or ZP_NO_LITERAL.
+ * @return ZP_Result with ZP_OK on success.
+ */
+ZP_Result zp_literal_set_find(
+    const ZP_LiteralSet* set,
+    const char* data,
+    size_t len,
+    size_t start,
+    ZP_MatchKind kind,
+    ZP_LiteralMatch* out
+);
+
+/**
+ * Match a literal exactly at pos, as a tokenizer would.
+ *
+ * Parameters are as for zp_literal_set_find().
+ */
+ZP_Result zp_literal_set_match_at(
+    const ZP_LiteralSet* set,
+    const char* data,
+    size_t len,
+    size_t pos,
+    ZP_MatchKind kind,
+    ZP_LiteralMatch* out
+);
+
+/**
+ * Opaque handle for a runtime regex set (a grammar's token patterns).
+ */
+typedef struct ZP_RegexSet_s ZP_RegexSet;
+
+/**
+ * Longest match at a position; pattern is ZP_NO_LITERAL if nothing matched.
+ */
+typedef struct {
+    uint32_t pattern;
+    size_t len;
+} ZP_PatternMatch;
+
+/**
+ * Why zp_create_regex_set() rejected its patterns.
+ */
+typedef struct {
+    uint32_t pattern;    /* index of the malformed regex, or ZP_NO_LITERAL */
+    size_t position;     /* byte offset of the error within that regex */
+    const char* message; /* static, NUL-terminated description */
+} ZP_RegexError;
+
+/**
+ * Build a regex set from token patterns known only at runtime.
+ *
+ * Supports literals, ., [...] classes, \d \w \s, \xHH, groups, |, and the
+ * * + ? {n,m} repeats. DFA states are built as matching reaches them and
+ * kept in a bounded cache; inputs that keep overflowing it are matched by
+ * NFA simulation instead.
+ *
+ * @param patterns Array of count regexes (need not be NUL-terminated).
+ * @param lens Length of each regex.
+ * @param count Number of regexes.
+ * @param cache_states Most DFA states cached at once, or 0 for the default.
+ * @param error_info Receives the failing regex and position on
+ *                   ZP_ERROR_INVALID_ARGUMENT; may be NULL.
+ * @return ZP_Result with data pointing to the ZP_RegexSet on success, or
+ *         ZP_ERROR_INVALID_ARGUMENT for a malformed regex.
+ */
+ZP_Result zp_create_regex_set(const char* const* patterns, const size_t* lens, size_t count, size_t cache_states, ZP_RegexError* error_info);
+
+/**
+ * Destroy a regex set.
+ * Waits for calls still using the set on other threads. The handle is
+ * invalid afterwards: destroying it again or passing it to any other call
+ * fails with ZP_ERROR_INVALID_HANDLE.
+ *
+ * @param set Regex set handle.
+ * @return ZP_Result with ZP_OK on success.
+ */
+ZP_Result zp_destroy_regex_set(ZP_RegexSet* set);
+
+/**
+ * Match the longest token at pos; among patterns matching that much, the
+ * one given first wins. Calls on one set are serialized.
+ *
+ * @param set Regex set handle.
+ * @param data Input buffer.
+ * @param len Length of the input buffer.
+ * @param pos Offset the match must start at.
+ * @param out Receives the match, or ZP_NO_LITERAL.
+ * @return ZP_Result with ZP_OK on success.
+ */
+ZP_Result zp_regex_set_match_at(
+    ZP_RegexSet* set,
+    const char* data,
+    size_t len,
+    size_t pos,
+    ZP_PatternMatch* out
+);
+
 /**
  * Get the last error message.
  *
@@ -7,6 +7,7 @@ pub const TokenStream = @import("token_stream.zig").TokenStream;
 pub const Pattern = @import("pattern.zig").Pattern;
 pub const match = @import("pattern.zig").match;
 pub const matchPattern = @import("pattern.zig").matchPattern;
+pub const pattern_ir = @import("pattern_ir.zig");
 
 // Legacy compatibility - deprecated but kept for old examples
 pub const TokenMatcher = struct {
@@ -25,16 +26,60 @@ pub const Token = struct {
 
 // Character classification (for advanced users)
 pub const char_class = @import("char_class.zig");
+pub const ByteSet = char_class.ByteSet;
 
 // Performance components
 pub const simd = @import("simd.zig").simd;
+pub const cpu_features = @import("cpu_features.zig");
+pub const BlockClassifier = @import("block_classifier.zig").BlockClassifier;
+pub const Teddy = @import("teddy.zig").Teddy;
+pub const AhoCorasick = @import("aho_corasick.zig").AhoCorasick;
+pub const KeywordSet = @import("keywords.zig").KeywordSet;
+pub const Nfa = @import("nfa.zig").Nfa;
+pub const Glushkov = @import("glushkov.zig").Glushkov;
+pub const DFAGenerator = @import("dfa_generator.zig").DFAGenerator;
+pub const LazyDfa = @import("lazy_dfa.zig").LazyDfa;
 pub const RingBuffer = @import("ring_buffer.zig").RingBuffer;
 pub const StreamingTokenizer = @import("ring_buffer.zig").StreamingTokenizer;
 
+// Threaded delivery and multi-stage pipelines
+pub const event_pipeline = @import("event_pipeline.zig");
+pub const PipelinedEmitter = event_pipeline.PipelinedEmitter;
+pub const pipeline = @import("pipeline.zig");
+pub const PipelineRunner = pipeline.PipelineRunner;
+pub const parseMany = @import("parse_many.zig").parseMany;
+pub const ParallelLexer = @import("parallel_lexer.zig").ParallelLexer;
+pub const sharding = @import("shard.zig");
+
 // Pre-built parsers
 pub const json = @import("parsers/json.zig");
 pub const csv = @import("parsers/csv.zig");
 
+// Modules are only analyzed when referenced, so list those with tests
+test {
+    _ = @import("aho_corasick.zig");
+    _ = @import("block_classifier.zig");
+    _ = @import("char_class.zig");
+    _ = @import("cpu_features.zig");
+    _ = @import("dfa_generator.zig");
+    _ = @import("event_pipeline.zig");
+    _ = @import("fast_matcher.zig");
+    _ = @import("glushkov.zig");
+    _ = @import("keywords.zig");
+    _ = @import("lazy_dfa.zig");
+    _ = @import("nfa.zig");
+    _ = @import("parallel_lexer.zig");
+    _ = @import("parse_many.zig");
+    _ = @import("pattern_ir.zig");
+    _ = @import("pipeline.zig");
+    _ = @import("regex.zig");
+    _ = @import("ring_buffer.zig");
+    _ = @import("shard.zig");
+    _ = @import("simd.zig");
+    _ = @import("teddy.zig");
+    _ = @import("token_stream.zig");
+}
+
 test "simple parsing" {
     const TestTokenType = enum { word, number, whitespace };
     const patterns = comptime .{